@@ -257,7 +257,7 @@ void TestScene::OnUpdateScene (float dt)
 
 	if (PhysicsEngine::Instance ()->GetIsDrawOcTree ())
 	{
-		PhysicsEngine::Instance ()->GetOcTreeRoot ()->Draw ();
+		PhysicsEngine::Instance ()->GetOcTree ()->Draw ();
 	}
 
 	DrawAxis ();
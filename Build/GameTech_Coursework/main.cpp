@@ -1,7 +1,9 @@
 #include <enet/enet.h>
 
 #include <nclgl\Window.h>
+#include <nclgl\MathBenchmark.h>
 #include <ncltech\PhysicsEngine.h>
+#include <ncltech\ContactBenchmark.h>
 #include <ncltech\SceneManager.h>
 #include <ncltech\NCLDebug.h>
 #include <ncltech\PerfTimer.h>
@@ -96,6 +98,7 @@ void PrintStatusEntries()
 		timer_update.PrintOutputToStatusEntry(status_colour, "          Scene Update   :");
 		timer_physics.PrintOutputToStatusEntry(status_colour, "          Physics Update :");
 		timer_render.PrintOutputToStatusEntry(status_colour, "          Render Scene   :");
+		NCLDebug::AddStatusEntry(status_colour, "          (Press K to benchmark the maths library and contact generation - results in the console)");
 	}
 	NCLDebug::AddStatusEntry(status_colour, "");
 	
@@ -110,6 +113,20 @@ void PrintStatusEntries()
 
 	NCLDebug::AddStatusEntry (status_colour, "");
 	NCLDebug::AddStatusEntry (status_colour, "Collision Pairs: %d", PhysicsEngine::Instance ()->GetCollisionPairs ());
+	NCLDebug::AddStatusEntry (status_colour, "Broadphase: %s (Press B to cycle)",
+		PhysicsEngine::GetBroadphaseModeName (PhysicsEngine::Instance ()->GetBroadphaseMode ()));
+	NCLDebug::AddStatusEntry (status_colour, "Solver: %s (Press N to cycle)",
+		PhysicsEngine::GetSolverModeName (PhysicsEngine::Instance ()->GetSolverMode ()));
+	NCLDebug::AddStatusEntry (status_colour, "Position Correction: %s (Press H to cycle)",
+		PhysicsEngine::GetPositionCorrectionModeName (PhysicsEngine::Instance ()->GetPositionCorrectionMode ()));
+	if (PhysicsEngine::Instance ()->GetSolverMode () == SOLVER_GRAPHCOLOURING)
+		NCLDebug::AddStatusEntry (status_colour, "Solver Colours: %d", PhysicsEngine::Instance ()->GetNumSolverColours ());
+	NCLDebug::AddStatusEntry (status_colour, "Solver Iterations: %.1f avg, %d max (Residual: %.5f)",
+		PhysicsEngine::Instance ()->GetSolverAverageIterations (), PhysicsEngine::Instance ()->GetSolverMostIterations (),
+		PhysicsEngine::Instance ()->GetSolverResidual ());
+	NCLDebug::AddStatusEntry (status_colour, "Islands: %d (Largest: %d objects)",
+		PhysicsEngine::Instance ()->GetNumIslands (), PhysicsEngine::Instance ()->GetLargestIslandSize ());
+	NCLDebug::AddStatusEntry (status_colour, "Sleeping Objects: %d", PhysicsEngine::Instance ()->GetNumSleeping ());
 }
 
 
@@ -138,6 +155,30 @@ void HandleKeyboardInputs()
 
 	if (Window::GetKeyboard()->KeyTriggered(KEYBOARD_G))
 		show_perf_metrics = !show_perf_metrics;
+
+	if (Window::GetKeyboard()->KeyTriggered(KEYBOARD_K))
+	{
+		MathBenchmark::Run(std::cout);
+		ContactBenchmark::Run(std::cout);
+	}
+
+	if (Window::GetKeyboard()->KeyTriggered(KEYBOARD_B))
+	{
+		int mode = (PhysicsEngine::Instance()->GetBroadphaseMode() + 1) % BROADPHASE_MAX;
+		PhysicsEngine::Instance()->SetBroadphaseMode((BroadphaseMode)mode);
+	}
+
+	if (Window::GetKeyboard()->KeyTriggered(KEYBOARD_N))
+	{
+		int mode = (PhysicsEngine::Instance()->GetSolverMode() + 1) % SOLVER_MAX;
+		PhysicsEngine::Instance()->SetSolverMode((SolverMode)mode);
+	}
+
+	if (Window::GetKeyboard()->KeyTriggered(KEYBOARD_H))
+	{
+		int mode = (PhysicsEngine::Instance()->GetPositionCorrectionMode() + 1) % POSITION_CORRECTION_MAX;
+		PhysicsEngine::Instance()->SetPositionCorrectionMode((PositionCorrectionMode)mode);
+	}
 }
 
 
@@ -152,8 +193,6 @@ int main()
 	//Create main game-loop
 	while (Window::GetWindow().UpdateWindow() && !Window::GetKeyboard()->KeyDown(KEYBOARD_ESCAPE)) 
 	{
-		PhysicsEngine::Instance ()->CreateOcTree ();
-
 		//Start Timing
 		float dt = Window::GetWindow().GetTimer()->GetTimedMS() * 0.001f;	//How many milliseconds since last update?
 		timer_total.BeginTimingSection();
@@ -202,8 +241,6 @@ int main()
 
 		//Let other programs on the computer have some CPU time
 		Sleep(0);
-		
-		PhysicsEngine::Instance ()->DestoryOcTree ();
 	}
 
 	//Cleanup
@@ -7,6 +7,7 @@ Description:
 This demo scene creates two hanging objects, constrained together by
 distance constraints. The first (Ball-ball) is connected at the centre's
 of each object and the second (Ball-Cube) is connect on the corner of the cube.
+Between them is a door on a hinge constraint, which can only swing about its post.
 
 Once the distance constraint class is built this should swing like a pendulum.
 
@@ -43,6 +44,7 @@ Once the distance constraint class is built this should swing like a pendulum.
 #include <ncltech\PhysicsEngine.h>
 #include <ncltech\NCLDebug.h>
 #include <ncltech\DistanceConstraint.h>
+#include <ncltech\HingeConstraint.h>
 #include <ncltech\CommonUtils.h>
 
 class Phy3_Constraints : public Scene
@@ -97,12 +99,11 @@ public:
 			this->AddGameObject(ball);
 
 			//Add distance constraint between the two objects
-			DistanceConstraint* constraint = new DistanceConstraint(
+			PhysicsEngine::Instance()->AddConstraint(DistanceConstraint(
 				handle->Physics(),					//Physics Object A
 				ball->Physics(),					//Physics Object B
 				handle->Physics()->GetPosition(),	//Attachment Position on Object A	-> Currently the centre
-				ball->Physics()->GetPosition());	//Attachment Position on Object B	-> Currently the centre  
-			PhysicsEngine::Instance()->AddConstraint(constraint);
+				ball->Physics()->GetPosition()));	//Attachment Position on Object B	-> Currently the centre  
 		}
 
 
@@ -131,7 +132,7 @@ public:
 			this->AddGameObject(handle);
 			this->AddGameObject(cube);
 
-			PhysicsEngine::Instance()->AddConstraint(new DistanceConstraint(
+			PhysicsEngine::Instance()->AddConstraint(DistanceConstraint(
 				handle->Physics(),													//Physics Object A
 				cube->Physics(),													//Physics Object B
 				handle->Physics()->GetPosition(),									//Attachment Position on Object A	-> Currently the far right edge
@@ -139,6 +140,39 @@ public:
 		}
 
 
+
+
+		//Create Hinged Door (Swings about the post's vertical axis only)
+		{
+			Object* post = CommonUtils::BuildCuboidObject("",
+				Vector3(-1.f, 3.f, -5.0f),				//Position
+				Vector3(0.1f, 2.0f, 0.1f),				//Half Dimensions
+				true,									//Has Physics Object
+				0.0f,									//Infinite Mass
+				false,									//No Collision Shape Yet
+				false,									//Not Dragable
+				CommonUtils::GenColour(0.65f, 0.5f));	//Color
+
+			Object* door = CommonUtils::BuildCuboidObject("",
+				Vector3(0.1f, 3.f, -5.0f),				//Position
+				Vector3(1.0f, 1.5f, 0.05f),				//Half Dimensions
+				true,									//Has Physics Object
+				1.0f,									//Inverse Mass = 1 / 1kg mass
+				false,									//No Collision Shape Yet
+				true,									//Dragable by the user
+				CommonUtils::GenColour(0.7f, 1.0f));	//Color
+
+			this->AddGameObject(post);
+			this->AddGameObject(door);
+
+			PhysicsEngine::Instance()->AddConstraint(HingeConstraint(
+				post->Physics(),					//Physics Object A
+				door->Physics(),					//Physics Object B
+				Vector3(-0.9f, 3.f, -5.0f),			//Pivot				-> Between the post and the door's near edge
+				Vector3(0.0f, 1.0f, 0.0f)));		//Hinge Axis		-> Vertical
+		}
+
+
 	}
 
 	virtual void OnUpdateScene(float dt) override
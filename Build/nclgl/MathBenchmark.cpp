@@ -0,0 +1,204 @@
+#include "MathBenchmark.h"
+#include "Matrix4.h"
+#include "Matrix3.h"
+#include "Quaternion.h"
+#include "GameTimer.h"
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+
+#define BENCHMARK_NUM_INPUTS 1024		//Must be a power of two
+
+//Plain scalar versions of the nclgl operations being tested
+static Matrix4 ScalarMul(const Matrix4& a, const Matrix4& b)
+{
+	Matrix4 out;
+	for (unsigned int r = 0; r < 4; ++r) {
+		for (unsigned int c = 0; c < 4; ++c) {
+			out.values[c + (r * 4)] = 0.0f;
+			for (unsigned int i = 0; i < 4; ++i) {
+				out.values[c + (r * 4)] += a.values[c + (i * 4)] * b.values[(r * 4) + i];
+			}
+		}
+	}
+	return out;
+}
+
+static Vector4 ScalarMul(const Matrix4& m, const Vector4& v)
+{
+	return Vector4(
+		v.x*m.values[0] + v.y*m.values[4] + v.z*m.values[8]  + v.w*m.values[12],
+		v.x*m.values[1] + v.y*m.values[5] + v.z*m.values[9]  + v.w*m.values[13],
+		v.x*m.values[2] + v.y*m.values[6] + v.z*m.values[10] + v.w*m.values[14],
+		v.x*m.values[3] + v.y*m.values[7] + v.z*m.values[11] + v.w*m.values[15]);
+}
+
+static Vector3 ScalarMul(const Matrix4& m, const Vector3& v)
+{
+	float temp = v.x*m.values[3] + v.y*m.values[7] + v.z*m.values[11] + m.values[15];
+	return Vector3(
+		(v.x*m.values[0] + v.y*m.values[4] + v.z*m.values[8]  + m.values[12]) / temp,
+		(v.x*m.values[1] + v.y*m.values[5] + v.z*m.values[9]  + m.values[13]) / temp,
+		(v.x*m.values[2] + v.y*m.values[6] + v.z*m.values[10] + m.values[14]) / temp);
+}
+
+static Matrix3 ScalarMul(const Matrix3& a, const Matrix3& b)
+{
+	Matrix3 out;
+	out._11 = a._11 * b._11 + a._12 * b._21 + a._13 * b._31;
+	out._12 = a._11 * b._12 + a._12 * b._22 + a._13 * b._32;
+	out._13 = a._11 * b._13 + a._12 * b._23 + a._13 * b._33;
+
+	out._21 = a._21 * b._11 + a._22 * b._21 + a._23 * b._31;
+	out._22 = a._21 * b._12 + a._22 * b._22 + a._23 * b._32;
+	out._23 = a._21 * b._13 + a._22 * b._23 + a._23 * b._33;
+
+	out._31 = a._31 * b._11 + a._32 * b._21 + a._33 * b._31;
+	out._32 = a._31 * b._12 + a._32 * b._22 + a._33 * b._32;
+	out._33 = a._31 * b._13 + a._32 * b._23 + a._33 * b._33;
+	return out;
+}
+
+static Vector3 ScalarMul(const Matrix3& a, const Vector3& b)
+{
+	return Vector3(
+		a._11 * b.x + a._21 * b.y + a._31 * b.z,
+		a._12 * b.x + a._22 * b.y + a._32 * b.z,
+		a._13 * b.x + a._23 * b.y + a._33 * b.z);
+}
+
+static Quaternion ScalarMul(const Quaternion& a, const Quaternion& b)
+{
+	return Quaternion(
+		(a.x * b.w) + (a.w * b.x) + (a.y * b.z) - (a.z * b.y),
+		(a.y * b.w) + (a.w * b.y) + (a.z * b.x) - (a.x * b.z),
+		(a.z * b.w) + (a.w * b.z) + (a.x * b.y) - (a.y * b.x),
+		(a.w * b.w) - (a.x * b.x) - (a.y * b.y) - (a.z * b.z));
+}
+
+static Matrix3 ScalarToMatrix3(const Quaternion& q)
+{
+	Matrix3 mat;
+	float yy = q.y*q.y, zz = q.z*q.z, xx = q.x*q.x;
+	float xy = q.x*q.y, xz = q.x*q.z, yz = q.y*q.z;
+	float zw = q.z*q.w, yw = q.y*q.w, xw = q.x*q.w;
+
+	mat.mat_array[0] = 1 - 2 * yy - 2 * zz;
+	mat.mat_array[1] = 2 * xy + 2 * zw;
+	mat.mat_array[2] = 2 * xz - 2 * yw;
+
+	mat.mat_array[3] = 2 * xy - 2 * zw;
+	mat.mat_array[4] = 1 - 2 * xx - 2 * zz;
+	mat.mat_array[5] = 2 * yz + 2 * xw;
+
+	mat.mat_array[6] = 2 * xz + 2 * yw;
+	mat.mat_array[7] = 2 * yz - 2 * xw;
+	mat.mat_array[8] = 1 - 2 * xx - 2 * yy;
+	return mat;
+}
+
+static Matrix3 ScalarOuterProduct(const Vector3& a, const Vector3& b)
+{
+	return Matrix3(
+		a.x * b.x, a.x * b.y, a.x * b.z,
+		a.y * b.x, a.y * b.y, a.y * b.z,
+		a.z * b.x, a.z * b.y, a.z * b.z);
+}
+
+static Vector4 ScalarAdd(const Vector4& a, const Vector4& b)
+{
+	return Vector4(a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w);
+}
+
+
+
+static float RandomFloat()
+{
+	return (rand() / (float)RAND_MAX) * 2.0f - 1.0f;
+}
+
+//Applies 'op' to every input 'repeats' times, returning the time taken in ms. The
+// inputs are offset by the repeat count so that the work can't be hoisted out.
+template <typename T, typename Func>
+static float TimeOperation(std::vector<T>& results, unsigned int repeats, Func op)
+{
+	GameTimer timer;
+	for (unsigned int r = 0; r < repeats; ++r)
+	{
+		for (unsigned int i = 0; i < BENCHMARK_NUM_INPUTS; ++i)
+			results[i] = op((i + r) & (BENCHMARK_NUM_INPUTS - 1));
+	}
+	return timer.GetMS();
+}
+
+template <typename T>
+static void PrintResult(std::ostream& out, const char* name, float scalar_ms, float simd_ms,
+	const std::vector<T>& scalar_results, const std::vector<T>& simd_results)
+{
+	bool identical = memcmp(&scalar_results[0], &simd_results[0], scalar_results.size() * sizeof(T)) == 0;
+
+	char line[256];
+	snprintf(line, sizeof(line), "    %-24s %10.2f %10.2f %9.2fx   %s",
+		name, scalar_ms, simd_ms, scalar_ms / max(simd_ms, 1e-6f), identical ? "Identical" : "MISMATCH");
+	out << line << std::endl;
+}
+
+#define RUN_BENCHMARK(name, type, scalar_op, simd_op) \
+	{ \
+		std::vector<type> scalar_results(BENCHMARK_NUM_INPUTS), simd_results(BENCHMARK_NUM_INPUTS); \
+		float scalar_ms = TimeOperation(scalar_results, repeats, [&](unsigned int i) { return scalar_op; }); \
+		float simd_ms = TimeOperation(simd_results, repeats, [&](unsigned int i) { return simd_op; }); \
+		PrintResult(out, name, scalar_ms, simd_ms, scalar_results, simd_results); \
+	}
+
+void MathBenchmark::Run(std::ostream& out, unsigned int repeats)
+{
+	std::vector<Matrix4>	m4a(BENCHMARK_NUM_INPUTS), m4b(BENCHMARK_NUM_INPUTS);
+	std::vector<Matrix3>	m3a(BENCHMARK_NUM_INPUTS), m3b(BENCHMARK_NUM_INPUTS);
+	std::vector<Quaternion>	qa(BENCHMARK_NUM_INPUTS), qb(BENCHMARK_NUM_INPUTS);
+	std::vector<Vector4>	v4a(BENCHMARK_NUM_INPUTS), v4b(BENCHMARK_NUM_INPUTS);
+	std::vector<Vector3>	v3(BENCHMARK_NUM_INPUTS), v3b(BENCHMARK_NUM_INPUTS);
+
+	srand(12345);
+	for (unsigned int i = 0; i < BENCHMARK_NUM_INPUTS; ++i)
+	{
+		for (int j = 0; j < 16; ++j)
+		{
+			m4a[i].values[j] = RandomFloat();
+			m4b[i].values[j] = RandomFloat();
+		}
+		for (int j = 0; j < 9; ++j)
+		{
+			m3a[i].mat_array[j] = RandomFloat();
+			m3b[i].mat_array[j] = RandomFloat();
+		}
+
+		qa[i] = Quaternion(RandomFloat(), RandomFloat(), RandomFloat(), RandomFloat());
+		qb[i] = Quaternion(RandomFloat(), RandomFloat(), RandomFloat(), RandomFloat());
+		qa[i].Normalise();
+		qb[i].Normalise();
+
+		v4a[i] = Vector4(RandomFloat(), RandomFloat(), RandomFloat(), RandomFloat());
+		v4b[i] = Vector4(RandomFloat(), RandomFloat(), RandomFloat(), RandomFloat());
+		v3[i] = Vector3(RandomFloat(), RandomFloat(), RandomFloat());
+		v3b[i] = Vector3(RandomFloat(), RandomFloat(), RandomFloat());
+	}
+
+#ifdef NCLGL_USE_SSE
+	out << "nclgl maths benchmark (SSE enabled), " << repeats << " x " << BENCHMARK_NUM_INPUTS << " operations" << std::endl;
+#else
+	out << "nclgl maths benchmark (SSE disabled), " << repeats << " x " << BENCHMARK_NUM_INPUTS << " operations" << std::endl;
+#endif
+	out << "    Operation                 Scalar(ms)  nclgl(ms)   Speedup" << std::endl;
+
+	RUN_BENCHMARK("Matrix4 * Matrix4",		Matrix4,	ScalarMul(m4a[i], m4b[i]),	m4a[i] * m4b[i]);
+	RUN_BENCHMARK("Matrix4 * Vector4",		Vector4,	ScalarMul(m4a[i], v4a[i]),	m4a[i] * v4a[i]);
+	RUN_BENCHMARK("Matrix4 * Vector3",		Vector3,	ScalarMul(m4a[i], v3[i]),	m4a[i] * v3[i]);
+	RUN_BENCHMARK("Matrix3 * Matrix3",		Matrix3,	ScalarMul(m3a[i], m3b[i]),	m3a[i] * m3b[i]);
+	RUN_BENCHMARK("Matrix3 * Vector3",		Vector3,	ScalarMul(m3a[i], v3[i]),	m3a[i] * v3[i]);
+	RUN_BENCHMARK("Matrix3::OuterProduct",	Matrix3,	ScalarOuterProduct(v3[i], v3b[i]),	Matrix3::OuterProduct(v3[i], v3b[i]));
+	RUN_BENCHMARK("Quaternion * Quaternion",	Quaternion,	ScalarMul(qa[i], qb[i]),	qa[i] * qb[i]);
+	RUN_BENCHMARK("Quaternion::ToMatrix3",	Matrix3,	ScalarToMatrix3(qa[i]),		qa[i].ToMatrix3());
+	RUN_BENCHMARK("Vector4 + Vector4",		Vector4,	ScalarAdd(v4a[i], v4b[i]),	v4a[i] + v4b[i]);
+}
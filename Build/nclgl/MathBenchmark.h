@@ -0,0 +1,21 @@
+/******************************************************************************
+Class: MathBenchmark
+Description: Times the common maths operations (matrix/vector/quaternion
+products etc) against plain scalar versions of the same code, and checks that
+both give the same results.
+
+Operations that nclgl keeps scalar (see SIMD.h) are still timed, so that any
+changes to them can be checked here too - along with everything else when built
+with NCLGL_NO_SIMD, they should come out at ~1x.
+******************************************************************************/
+#pragma once
+
+#include <iostream>
+
+class MathBenchmark
+{
+public:
+	//Runs every benchmark 'repeats' times over a set of random inputs, and prints
+	// the time taken (in ms) by the scalar and nclgl versions to 'out'
+	static void Run(std::ostream& out, unsigned int repeats = 1000);
+};
@@ -2,6 +2,7 @@
 #include "Matrix4.h"
 #include "OGLRenderer.h"
 #include "common.h"
+#include "SIMD.h"
 
 const Matrix3 Matrix3::Identity   = Matrix3(1.0f, 0.0f, 0.0f,
 										    0.0f, 1.0f, 0.0f,
@@ -201,6 +202,13 @@ Matrix3 Matrix3::OuterProduct(const Vector3& a, const Vector3& b)
 {
 	Matrix3 m;
 
+#ifdef NCLGL_USE_SSE
+	const __m128 vb = SIMD_Load3(&b.x);
+	SIMD_StoreMatrix3(m.mat_array,
+		_mm_mul_ps(_mm_set1_ps(a.x), vb),
+		_mm_mul_ps(_mm_set1_ps(a.y), vb),
+		_mm_mul_ps(_mm_set1_ps(a.z), vb));
+#else
 	m._11 = a.x * b.x;
 	m._12 = a.x * b.y;
 	m._13 = a.x * b.z;
@@ -212,6 +220,7 @@ Matrix3 Matrix3::OuterProduct(const Vector3& a, const Vector3& b)
 	m._31 = a.z * b.x;
 	m._32 = a.z * b.y;
 	m._33 = a.z * b.z;
+#endif
 
 	return m;
 }
@@ -340,6 +349,15 @@ Vector3 operator*(const Matrix3& a, const Vector3& b)
 {
 	Vector3 out;
 
+#ifdef NCLGL_USE_SSE
+	__m128 c0, c1, c2;
+	SIMD_LoadMatrix3(a.mat_array, c0, c1, c2);
+
+	__m128 r = _mm_mul_ps(c0, _mm_set1_ps(b.x));
+	r = _mm_add_ps(r, _mm_mul_ps(c1, _mm_set1_ps(b.y)));
+	r = _mm_add_ps(r, _mm_mul_ps(c2, _mm_set1_ps(b.z)));
+	SIMD_Store3(&out.x, r);
+#else
 	out.x = a._11 * b.x
 		  + a._21 * b.y
 		  + a._31 * b.z;
@@ -351,6 +369,7 @@ Vector3 operator*(const Matrix3& a, const Vector3& b)
 	out.z = a._13 * b.x
 		  + a._23 * b.y
 		  + a._33 * b.z;
+#endif
 
 	return out;
 }
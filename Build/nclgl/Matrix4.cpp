@@ -11,6 +11,8 @@ Matrix4::Matrix4( float elements[16] )	{
 
 Matrix4::Matrix4(const Matrix3& mat33)
 {
+	ToIdentity();
+
 	const unsigned int size = 3 * sizeof(float);
 	memcpy(&values[0], & mat33.mat_array[0], size);
 	memcpy(&values[4], & mat33.mat_array[3], size);
@@ -189,4 +191,63 @@ Matrix4 Matrix4::GetTransposedRotation() const {
 	temp.values[6] = values[9];
 	temp.values[9] = values[6];
 	return temp;
-}
\ No newline at end of file
+}
+
+void Matrix4::TransformPoints(const Vector3* in, Vector3* out, unsigned int count) const
+{
+	unsigned int i = 0;
+
+#ifdef NCLGL_USE_SSE
+	const __m128 m0 = _mm_set1_ps(values[0]), m1 = _mm_set1_ps(values[1]), m2 = _mm_set1_ps(values[2]);
+	const __m128 m4 = _mm_set1_ps(values[4]), m5 = _mm_set1_ps(values[5]), m6 = _mm_set1_ps(values[6]);
+	const __m128 m8 = _mm_set1_ps(values[8]), m9 = _mm_set1_ps(values[9]), m10 = _mm_set1_ps(values[10]);
+	const __m128 m12 = _mm_set1_ps(values[12]), m13 = _mm_set1_ps(values[13]), m14 = _mm_set1_ps(values[14]);
+
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 x, y, z;
+		SIMD_LoadVector3x4(&in[i].x, x, y, z);
+
+		__m128 ox = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m0), _mm_mul_ps(y, m4)), _mm_mul_ps(z, m8)), m12);
+		__m128 oy = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m1), _mm_mul_ps(y, m5)), _mm_mul_ps(z, m9)), m13);
+		__m128 oz = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m2), _mm_mul_ps(y, m6)), _mm_mul_ps(z, m10)), m14);
+
+		SIMD_StoreVector3x4(&out[i].x, ox, oy, oz);
+	}
+#endif
+
+	for (; i < count; ++i)
+	{
+		const Vector3 v = in[i];
+		out[i].x = v.x*values[0] + v.y*values[4] + v.z*values[8]  + values[12];
+		out[i].y = v.x*values[1] + v.y*values[5] + v.z*values[9]  + values[13];
+		out[i].z = v.x*values[2] + v.y*values[6] + v.z*values[10] + values[14];
+	}
+}
+
+void Matrix4::Multiply(const Matrix4* a, const Matrix4* b, Matrix4* out, unsigned int count)
+{
+	for (unsigned int n = 0; n < count; ++n)
+	{
+#ifdef NCLGL_USE_SSE
+		//Same as operator*, but writing straight into the output array
+		const __m128 c0 = _mm_loadu_ps(&a[n].values[0]);
+		const __m128 c1 = _mm_loadu_ps(&a[n].values[4]);
+		const __m128 c2 = _mm_loadu_ps(&a[n].values[8]);
+		const __m128 c3 = _mm_loadu_ps(&a[n].values[12]);
+
+		for (unsigned int r = 0; r < 4; ++r)
+		{
+			const __m128 br = _mm_loadu_ps(&b[n].values[r * 4]);
+
+			__m128 col = _mm_mul_ps(c0, SIMD_SPLAT(br, 0));
+			col = _mm_add_ps(col, _mm_mul_ps(c1, SIMD_SPLAT(br, 1)));
+			col = _mm_add_ps(col, _mm_mul_ps(c2, SIMD_SPLAT(br, 2)));
+			col = _mm_add_ps(col, _mm_mul_ps(c3, SIMD_SPLAT(br, 3)));
+			_mm_storeu_ps(&out[n].values[r * 4], col);
+		}
+#else
+		out[n] = a[n] * b[n];
+#endif
+	}
+}
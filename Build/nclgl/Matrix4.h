@@ -19,6 +19,7 @@ _-_-_-_-_-_-_-""  ""
 #include "common.h"
 #include "Vector3.h"
 #include "Vector4.h"
+#include "SIMD.h"
 
 class Vector3;
 class Matrix3;
@@ -76,10 +77,35 @@ public:
 	Matrix4 GetRotation() const;
 	Matrix4 GetTransposedRotation() const;
 
+	//Transforms 'count' points by this matrix, four at a time where SSE is available.
+	//Unlike operator*(Vector3) this assumes the matrix is affine (bottom row of 0,0,0,1),
+	// so skips the divide by w. 'in' and 'out' may be the same array.
+	void	TransformPoints(const Vector3* in, Vector3* out, unsigned int count) const;
+
+	//Computes out[i] = a[i] * b[i] for 'count' pairs of matrices. 'out' may be the same
+	// array as either 'a' or 'b'.
+	static void Multiply(const Matrix4* a, const Matrix4* b, Matrix4* out, unsigned int count);
+
 	//Multiplies 'this' matrix by matrix 'a'. Performs the multiplication in 'OpenGL' order (ie, backwards)
 	inline Matrix4 operator*(const Matrix4 &a) const{	
 		Matrix4 out;
-		//Students! You should be able to think up a really easy way of speeding this up...
+#ifdef NCLGL_USE_SSE
+		//Each column of the output is a weighted sum of the columns of 'this'
+		const __m128 c0 = _mm_loadu_ps(&values[0]);
+		const __m128 c1 = _mm_loadu_ps(&values[4]);
+		const __m128 c2 = _mm_loadu_ps(&values[8]);
+		const __m128 c3 = _mm_loadu_ps(&values[12]);
+
+		for(unsigned int r = 0; r < 4; ++r) {
+			const __m128 ar = _mm_loadu_ps(&a.values[r*4]);
+
+			__m128 col = _mm_mul_ps(c0, SIMD_SPLAT(ar, 0));
+			col = _mm_add_ps(col, _mm_mul_ps(c1, SIMD_SPLAT(ar, 1)));
+			col = _mm_add_ps(col, _mm_mul_ps(c2, SIMD_SPLAT(ar, 2)));
+			col = _mm_add_ps(col, _mm_mul_ps(c3, SIMD_SPLAT(ar, 3)));
+			_mm_storeu_ps(&out.values[r*4], col);
+		}
+#else
 		for(unsigned int r = 0; r < 4; ++r) {
 			for(unsigned int c = 0; c < 4; ++c) {
 				out.values[c + (r*4)] = 0.0f;
@@ -88,12 +114,21 @@ public:
 				}
 			}
 		}
+#endif
 		return out;
 	}
 
 	inline Vector3 operator*(const Vector3 &v) const {
 		Vector3 vec;
 
+#ifdef NCLGL_USE_SSE
+		__m128 r = _mm_mul_ps(_mm_loadu_ps(&values[0]), _mm_set1_ps(v.x));
+		r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(&values[4]), _mm_set1_ps(v.y)));
+		r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(&values[8]), _mm_set1_ps(v.z)));
+		r = _mm_add_ps(r, _mm_loadu_ps(&values[12]));
+
+		SIMD_Store3(&vec.x, _mm_div_ps(r, SIMD_SPLAT(r, 3)));
+#else
 		float temp;
 
 		vec.x = v.x*values[0] + v.y*values[4] + v.z*values[8]  + values[12];
@@ -105,17 +140,29 @@ public:
 		vec.x = vec.x/temp;
 		vec.y = vec.y/temp;
 		vec.z = vec.z/temp;
+#endif
 
 		return vec;
 	};
 
 		inline Vector4 operator*(const Vector4 &v) const {
+#ifdef NCLGL_USE_SSE
+		__m128 r = _mm_mul_ps(_mm_loadu_ps(&values[0]), _mm_set1_ps(v.x));
+		r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(&values[4]), _mm_set1_ps(v.y)));
+		r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(&values[8]), _mm_set1_ps(v.z)));
+		r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(&values[12]), _mm_set1_ps(v.w)));
+
+		Vector4 out;
+		_mm_storeu_ps(&out.x, r);
+		return out;
+#else
 		return Vector4(
 			v.x*values[0] + v.y*values[4] + v.z*values[8]  +v.w * values[12],
 			v.x*values[1] + v.y*values[5] + v.z*values[9]  +v.w * values[13],
 			v.x*values[2] + v.y*values[6] + v.z*values[10] +v.w * values[14],
 			v.x*values[3] + v.y*values[7] + v.z*values[11] +v.w * values[15]
 		);
+#endif
 	};
 
 
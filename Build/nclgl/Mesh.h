@@ -70,6 +70,10 @@ public:
 
 	bool	TransformsTexCoords() { return transformCoords;}
 
+	//Vertex positions are kept after buffering, so they can be used to build collision shapes
+	const Vector3*	GetVertices() const		{ return vertices; }
+	GLuint			GetNumVertices() const	{ return numVertices; }
+
 	//Generates normals for all facets. Assumes geometry type is GL_TRIANGLES...
 	void	GenerateNormals();
 
@@ -1,4 +1,6 @@
 #include "Plane.h"
+#include "Matrix3.h"
+#include "SIMD.h"
 
 Plane::Plane(const Vector3 &_normal, float distance, bool normalise) {
 	if(normalise) {
@@ -30,4 +32,72 @@ bool Plane::PointInPlane(const Vector3 &position) const {
 	}
 
 	return true;
-}
\ No newline at end of file
+}
+
+void Plane::TransformPlanes(const Matrix3& normalMatrix, const Vector3& translation,
+	const Plane* in, Plane* out, unsigned int count)
+{
+	//For a point p on the plane, the transformed point Mp + t lies on the plane with
+	// normal N*n and distance d - (N*n).t - which then just needs normalising.
+	const Matrix3& N = normalMatrix;
+	unsigned int i = 0;
+
+#ifdef NCLGL_USE_SSE
+	//Planes are packed as [nx ny nz d], so four of them transpose neatly into registers
+	static_assert(sizeof(Plane) == 4 * sizeof(float), "Plane must be tightly packed");
+
+	const __m128 n11 = _mm_set1_ps(N._11), n12 = _mm_set1_ps(N._12), n13 = _mm_set1_ps(N._13);
+	const __m128 n21 = _mm_set1_ps(N._21), n22 = _mm_set1_ps(N._22), n23 = _mm_set1_ps(N._23);
+	const __m128 n31 = _mm_set1_ps(N._31), n32 = _mm_set1_ps(N._32), n33 = _mm_set1_ps(N._33);
+	const __m128 tx = _mm_set1_ps(translation.x), ty = _mm_set1_ps(translation.y), tz = _mm_set1_ps(translation.z);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 nx = _mm_loadu_ps((const float*)&in[i]);
+		__m128 ny = _mm_loadu_ps((const float*)&in[i + 1]);
+		__m128 nz = _mm_loadu_ps((const float*)&in[i + 2]);
+		__m128 d = _mm_loadu_ps((const float*)&in[i + 3]);
+		_MM_TRANSPOSE4_PS(nx, ny, nz, d);
+
+		__m128 ox = _mm_add_ps(_mm_add_ps(_mm_mul_ps(n11, nx), _mm_mul_ps(n21, ny)), _mm_mul_ps(n31, nz));
+		__m128 oy = _mm_add_ps(_mm_add_ps(_mm_mul_ps(n12, nx), _mm_mul_ps(n22, ny)), _mm_mul_ps(n32, nz));
+		__m128 oz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(n13, nx), _mm_mul_ps(n23, ny)), _mm_mul_ps(n33, nz));
+		d = _mm_sub_ps(d, _mm_add_ps(_mm_add_ps(_mm_mul_ps(ox, tx), _mm_mul_ps(oy, ty)), _mm_mul_ps(oz, tz)));
+
+		//Degenerate (zero length) normals are left as they are, as in Vector3::Normalise
+		__m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(ox, ox), _mm_mul_ps(oy, oy)), _mm_mul_ps(oz, oz)));
+		__m128 valid = _mm_cmpneq_ps(length, zero);
+		__m128 inv_length = _mm_div_ps(one, _mm_or_ps(_mm_and_ps(valid, length), _mm_andnot_ps(valid, one)));
+
+		ox = _mm_mul_ps(ox, inv_length);
+		oy = _mm_mul_ps(oy, inv_length);
+		oz = _mm_mul_ps(oz, inv_length);
+		d = _mm_mul_ps(d, inv_length);
+
+		_MM_TRANSPOSE4_PS(ox, oy, oz, d);
+		_mm_storeu_ps((float*)&out[i], ox);
+		_mm_storeu_ps((float*)&out[i + 1], oy);
+		_mm_storeu_ps((float*)&out[i + 2], oz);
+		_mm_storeu_ps((float*)&out[i + 3], d);
+	}
+#endif
+
+	for (; i < count; ++i)
+	{
+		const Vector3 n = in[i]._normal;
+
+		Vector3 normal = Vector3(
+			N._11 * n.x + N._21 * n.y + N._31 * n.z,
+			N._12 * n.x + N._22 * n.y + N._32 * n.z,
+			N._13 * n.x + N._23 * n.y + N._33 * n.z);
+		float dist = in[i].distance - Vector3::Dot(normal, translation);
+
+		float length = normal.Length();
+		float inv_length = (length != 0.0f) ? 1.0f / length : 1.0f;
+
+		out[i]._normal = normal * inv_length;
+		out[i].distance = dist * inv_length;
+	}
+}
@@ -15,6 +15,8 @@ _-_-_-_-_-_-_-""  ""
 #pragma once
 #include "vector3.h"
 
+class Matrix3;
+
 class Plane	{
 public:
 	Plane(void){};
@@ -34,6 +36,12 @@ public:
 	//Performs a simple sphere / point test
 	bool PointInPlane(const Vector3 &position) const;
 
+	//Transforms 'count' planes by an affine transform, given as its normal matrix (the
+	// inverse transpose of its rotation/scale) and its translation. The resulting planes
+	// are normalised. 'in' and 'out' may be the same array.
+	static void TransformPlanes(const Matrix3& normalMatrix, const Vector3& translation,
+		const Plane* in, Plane* out, unsigned int count);
+
 protected:
 	//Unit-length plane normal
 	Vector3 _normal;
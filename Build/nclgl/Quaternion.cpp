@@ -1,4 +1,5 @@
 #include "Quaternion.h"
+#include "SIMD.h"
 
 Quaternion::Quaternion(void)
 {
@@ -39,10 +40,28 @@ void Quaternion::Normalise(){
 Quaternion Quaternion::operator *(const Quaternion &b) const{
 	Quaternion ans;
 
+#ifdef NCLGL_USE_SSE
+	//The same sums as below, one column of terms at a time (lanes are x,y,z,w).
+	// Only the w lane subtracts its second and third terms.
+	const __m128 qa = _mm_loadu_ps(&x);
+	const __m128 qb = _mm_loadu_ps(&b.x);
+	const __m128 neg_w = _mm_set_ps(-0.0f, 0.0f, 0.0f, 0.0f);
+
+	__m128 t1 = _mm_mul_ps(qa, SIMD_SPLAT(qb, 3));
+	__m128 t2 = _mm_mul_ps(_mm_shuffle_ps(qa, qa, _MM_SHUFFLE(0, 3, 3, 3)), _mm_shuffle_ps(qb, qb, _MM_SHUFFLE(0, 2, 1, 0)));
+	__m128 t3 = _mm_mul_ps(_mm_shuffle_ps(qa, qa, _MM_SHUFFLE(1, 0, 2, 1)), _mm_shuffle_ps(qb, qb, _MM_SHUFFLE(1, 1, 0, 2)));
+	__m128 t4 = _mm_mul_ps(_mm_shuffle_ps(qa, qa, _MM_SHUFFLE(2, 1, 0, 2)), _mm_shuffle_ps(qb, qb, _MM_SHUFFLE(2, 0, 2, 1)));
+
+	__m128 r = _mm_add_ps(t1, _mm_xor_ps(t2, neg_w));
+	r = _mm_add_ps(r, _mm_xor_ps(t3, neg_w));
+	r = _mm_sub_ps(r, t4);
+	_mm_storeu_ps(&ans.x, r);
+#else
 	ans.w = (w * b.w) - (x * b.x) - (y * b.y) - (z * b.z);
 	ans.x = (x * b.w) + (w * b.x) + (y * b.z) - (z * b.y);
 	ans.y = (y * b.w) + (w * b.y) + (z * b.x) - (x * b.z);
 	ans.z = (z * b.w) + (w * b.z) + (x * b.y) - (y * b.x);
+#endif
 
 	return ans;
 }
@@ -0,0 +1,89 @@
+/******************************************************************************
+Description: SSE helpers shared by the maths classes (Vector4, Matrix3, Matrix4
+and Quaternion).
+
+NCLGL_USE_SSE is defined whenever the compiler targets SSE2 (always the case for
+x64 builds), and can be turned off by defining NCLGL_NO_SIMD before including
+any of the maths headers, in which case everything falls back to plain scalar
+code. Either way the classes keep exactly the same members and memory layout, so
+they can still be handed straight to OpenGL as float arrays.
+
+None of the SSE code paths use fused multiply-adds and they all sum their terms
+in the same order as the scalar code, so both give bit-identical results.
+
+Only the operations that actually came out faster in MathBenchmark use SSE.
+Vector3 (being only 12 bytes), Matrix3 * Matrix3 and the quaternion to matrix
+conversions cost more to shuffle in and out of registers than they save, so
+they stay scalar.
+******************************************************************************/
+#pragma once
+
+#if !defined(NCLGL_NO_SIMD) && (defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+	#define NCLGL_USE_SSE
+#endif
+
+#ifdef NCLGL_USE_SSE
+#include <emmintrin.h>
+
+//Broadcasts lane 'i' of 'v' to all four lanes
+#define SIMD_SPLAT(v, i) _mm_shuffle_ps(v, v, _MM_SHUFFLE(i, i, i, i))
+
+//Loads three floats into x/y/z (w = 0), without reading past the end of them
+static inline __m128 SIMD_Load3(const float* p)
+{
+	__m128 xy = _mm_loadl_pi(_mm_setzero_ps(), (const __m64*)p);
+	return _mm_movelh_ps(xy, _mm_load_ss(p + 2));
+}
+
+//Stores x/y/z, leaving whatever follows them in memory untouched
+static inline void SIMD_Store3(float* p, __m128 v)
+{
+	_mm_storel_pi((__m64*)p, v);
+	_mm_store_ss(p + 2, _mm_movehl_ps(v, v));
+}
+
+//Transposes four packed Vector3's [x0 y0 z0 x1][y1 z1 x2 y2][z2 x3 y3 z3] into [x0..x3][y0..y3][z0..z3]
+static inline void SIMD_LoadVector3x4(const float* f, __m128& x, __m128& y, __m128& z)
+{
+	__m128 p0 = _mm_loadu_ps(f);
+	__m128 p1 = _mm_loadu_ps(f + 4);
+	__m128 p2 = _mm_loadu_ps(f + 8);
+
+	x = _mm_shuffle_ps(p0, _mm_shuffle_ps(p1, p2, _MM_SHUFFLE(1, 1, 2, 2)), _MM_SHUFFLE(2, 0, 3, 0));
+	y = _mm_shuffle_ps(_mm_shuffle_ps(p0, p1, _MM_SHUFFLE(0, 0, 1, 1)), _mm_shuffle_ps(p1, p2, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+	z = _mm_shuffle_ps(_mm_shuffle_ps(p0, p1, _MM_SHUFFLE(1, 1, 2, 2)), _mm_shuffle_ps(p2, p2, _MM_SHUFFLE(3, 3, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+}
+
+//Inverse of SIMD_LoadVector3x4
+static inline void SIMD_StoreVector3x4(float* f, __m128 x, __m128 y, __m128 z)
+{
+	__m128 p0 = _mm_shuffle_ps(_mm_shuffle_ps(x, y, _MM_SHUFFLE(0, 0, 0, 0)), _mm_shuffle_ps(z, x, _MM_SHUFFLE(1, 1, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+	__m128 p1 = _mm_shuffle_ps(_mm_shuffle_ps(y, z, _MM_SHUFFLE(1, 1, 1, 1)), _mm_shuffle_ps(x, y, _MM_SHUFFLE(2, 2, 2, 2)), _MM_SHUFFLE(2, 0, 2, 0));
+	__m128 p2 = _mm_shuffle_ps(_mm_shuffle_ps(z, x, _MM_SHUFFLE(3, 3, 2, 2)), _mm_shuffle_ps(y, z, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+
+	_mm_storeu_ps(f, p0);
+	_mm_storeu_ps(f + 4, p1);
+	_mm_storeu_ps(f + 8, p2);
+}
+
+//Loads the three columns of a 3x3 (column major) float array. The w lanes are
+// left holding whatever follows each column and should be ignored.
+static inline void SIMD_LoadMatrix3(const float* m, __m128& c0, __m128& c1, __m128& c2)
+{
+	c0 = _mm_loadu_ps(m);
+	c1 = _mm_loadu_ps(m + 3);
+
+	//Load the last column from one float early to stay inside the array
+	__m128 t = _mm_loadu_ps(m + 5);
+	c2 = _mm_shuffle_ps(t, t, _MM_SHUFFLE(3, 3, 2, 1));
+}
+
+static inline void SIMD_StoreMatrix3(float* m, __m128 c0, __m128 c1, __m128 c2)
+{
+	//Each store overwrites the first value of the next column, so go in order
+	_mm_storeu_ps(m, c0);
+	_mm_storeu_ps(m + 3, c1);
+	SIMD_Store3(m + 6, c2);
+}
+
+#endif
@@ -13,6 +13,7 @@ _-_-_-_-_-_-_-""  ""
 #pragma once
 
 #include "Vector3.h"
+#include "SIMD.h"
 
 class Vector4	{
 public:
@@ -40,29 +41,49 @@ public:
 
 	Vector4 operator+(const Vector4& rhs) const
 	{
+#ifdef NCLGL_USE_SSE
+		Vector4 out;
+		_mm_storeu_ps(&out.x, _mm_add_ps(_mm_loadu_ps(&x), _mm_loadu_ps(&rhs.x)));
+		return out;
+#else
 		return Vector4(x + rhs.x, y + rhs.y, z + rhs.z, w + rhs.w);
+#endif
 	}
 
 	Vector4 operator-(const Vector4& rhs) const
 	{
+#ifdef NCLGL_USE_SSE
+		Vector4 out;
+		_mm_storeu_ps(&out.x, _mm_sub_ps(_mm_loadu_ps(&x), _mm_loadu_ps(&rhs.x)));
+		return out;
+#else
 		return Vector4(x - rhs.x, y - rhs.y, z - rhs.z, w - rhs.w);
+#endif
 	}
 
 	Vector4& operator+=(const Vector4& rhs)
 	{
+#ifdef NCLGL_USE_SSE
+		_mm_storeu_ps(&x, _mm_add_ps(_mm_loadu_ps(&x), _mm_loadu_ps(&rhs.x)));
+#else
 		x += rhs.x;
 		y += rhs.y;
 		z += rhs.z;
 		w += rhs.w;
+#endif
 		return *this;
 	}
 
 	Vector4& operator-=(const Vector4& rhs)
 	{
+#ifdef NCLGL_USE_SSE
+		_mm_storeu_ps(&x, _mm_sub_ps(_mm_loadu_ps(&x), _mm_loadu_ps(&rhs.x)));
+#else
 		x -= rhs.x;
 		y -= rhs.y;
 		z -= rhs.z;
 		w -= rhs.w;
+#endif
 		return *this;
 	}
 };
@@ -0,0 +1,53 @@
+/******************************************************************************
+Class: BallSocketConstraint
+Description: Pins a point on one object to a point on another, leaving them free
+to rotate about it in any direction (shoulders, hips, chain links etc).
+
+The three rows - the world x, y and z axes through the pivot - are solved
+together as one block, see BlockConstraint.
+******************************************************************************/
+#pragma once
+
+#include "BlockConstraint.h"
+#include "NCLDebug.h"
+
+//Final, so that the PhysicsEngine's pool of ball and socket joints can call it without going through the vtable
+class BallSocketConstraint final : public BlockConstraint<3>
+{
+public:
+	BallSocketConstraint(PhysicsObject* obj1, PhysicsObject* obj2, const Vector3& globalPivot)
+		: BlockConstraint<3>(obj1, obj2)
+	{
+		m_LocalOnA = Matrix3::Transpose(m_pObj1->GetRotation()) * (globalPivot - m_pObj1->GetPosition());
+		m_LocalOnB = Matrix3::Transpose(m_pObj2->GetRotation()) * (globalPivot - m_pObj2->GetPosition());
+	}
+
+	virtual void DebugDraw() const override
+	{
+		Vector3 globalOnA = m_pObj1->GetRotation() * m_LocalOnA + m_pObj1->GetPosition();
+		Vector3 globalOnB = m_pObj2->GetRotation() * m_LocalOnB + m_pObj2->GetPosition();
+
+		NCLDebug::DrawThickLine(m_pObj1->GetPosition(), globalOnA, 0.02f, Vector4(0.0f, 0.0f, 0.0f, 1.0f));
+		NCLDebug::DrawThickLine(m_pObj2->GetPosition(), globalOnB, 0.02f, Vector4(0.0f, 0.0f, 0.0f, 1.0f));
+		NCLDebug::DrawPointNDT(globalOnA, 0.05f, Vector4(1.0f, 0.8f, 1.0f, 1.0f));
+	}
+
+protected:
+	virtual void BuildRows() override
+	{
+		Vector3 r1 = m_pObj1->GetRotation() * m_LocalOnA;
+		Vector3 r2 = m_pObj2->GetRotation() * m_LocalOnB;
+		Vector3 error = (m_pObj1->GetPosition() + r1) - (m_pObj2->GetPosition() + r2);
+
+		m_Rows[0].Build(m_pObj1, m_pObj2, Vector3(1.0f, 0.0f, 0.0f), r1, r2);
+		m_Rows[1].Build(m_pObj1, m_pObj2, Vector3(0.0f, 1.0f, 0.0f), r1, r2);
+		m_Rows[2].Build(m_pObj1, m_pObj2, Vector3(0.0f, 0.0f, 1.0f), r1, r2);
+		m_Error[0] = error.x;
+		m_Error[1] = error.y;
+		m_Error[2] = error.z;
+	}
+
+protected:
+	Vector3 m_LocalOnA;		//Pivot in each object's local space
+	Vector3 m_LocalOnB;
+};
@@ -0,0 +1,193 @@
+/******************************************************************************
+Class: BlockConstraint
+Description: Base for joints made up of several rows (e.g. the three axes a ball
+and socket holds together) that are solved together as one block, rather than
+one row at a time.
+
+Solving the rows of a joint one after another, each row undoes part of what
+the ones before it did - so rigs built out of 1D constraints need a lot of
+iterations to converge. Here the rows' effective mass matrix (K = J * M^-1 * J^T)
+is built and factorised once in PreSolverStep, and each iteration then solves
+K * impulse = -(J * v + bias) for every row at once. A single joint on its own
+is satisfied in one iteration, and chains/ragdolls only have to converge
+between joints instead of within them.
+
+Derived joints just fill in the rows, and how far each of them is from being
+satisfied, for the objects' current positions in BuildRows.
+******************************************************************************/
+#pragma once
+
+#include "Constraint.h"
+#include "JacobianRow.h"
+
+//LDL^T factorisation of a small symmetric (positive semi-definite) matrix, so that
+// K * x = b can be solved for as many b's as needed with just a couple of substitutions
+template <int N>
+class BlockSolver
+{
+public:
+	void Factorise(const float K[N][N])
+	{
+		for (int j = 0; j < N; ++j)
+		{
+			float d = K[j][j];
+			for (int k = 0; k < j; ++k)
+				d -= m_L[j][k] * m_L[j][k] * m_D[k];
+
+			//A row that depends on the ones before it (or can't move at all) adds nothing,
+			// so it is just left out of the solve
+			bool solvable = d > K[j][j] * 1e-5f && d > 0.0f;
+			m_D[j] = solvable ? d : 0.0f;
+			m_InvD[j] = solvable ? 1.0f / d : 0.0f;
+
+			for (int i = j + 1; i < N; ++i)
+			{
+				float l = K[i][j];
+				for (int k = 0; k < j; ++k)
+					l -= m_L[i][k] * m_L[j][k] * m_D[k];
+				m_L[i][j] = l * m_InvD[j];
+			}
+		}
+	}
+
+	void Solve(const float b[N], float out_x[N]) const
+	{
+		//L * y = b
+		for (int i = 0; i < N; ++i)
+		{
+			float y = b[i];
+			for (int k = 0; k < i; ++k)
+				y -= m_L[i][k] * out_x[k];
+			out_x[i] = y;
+		}
+
+		//D * L^T * x = y
+		for (int i = N - 1; i >= 0; --i)
+		{
+			float x = out_x[i] * m_InvD[i];
+			for (int k = i + 1; k < N; ++k)
+				x -= m_L[k][i] * out_x[k];
+			out_x[i] = x;
+		}
+	}
+
+protected:
+	float m_L[N][N];		//Unit lower triangular, only the entries below the diagonal are used
+	float m_D[N];
+	float m_InvD[N];		//Zero for any row left out of the solve
+};
+
+template <int N>
+class BlockConstraint : public Constraint
+{
+public:
+	BlockConstraint(PhysicsObject* obj1, PhysicsObject* obj2)
+		: m_pObj1(obj1)
+		, m_pObj2(obj2)
+	{
+		for (int i = 0; i < N; ++i)
+		{
+			m_Error[i] = 0.0f;
+			m_Bias[i] = 0.0f;
+		}
+	}
+
+	virtual void PreSolverStep(float dt) override
+	{
+		PreSolverStep(dt, true);
+	}
+
+	//If velocity_baumgarte is false, any drift is left for the position correction pass to fix
+	void PreSolverStep(float dt, bool velocity_baumgarte)
+	{
+		BuildBlock();
+
+		float baumgarte_scalar = velocity_baumgarte ? 0.1f : 0.0f;
+		for (int i = 0; i < N; ++i)
+		{
+			m_Bias[i] = (baumgarte_scalar / dt) * m_Error[i];
+		}
+	}
+
+	virtual void ApplyImpulse() override
+	{
+		ApplyImpulseResidual();
+	}
+
+	virtual float ApplyImpulseResidual() override
+	{
+		float b[N], impulse[N];
+		for (int i = 0; i < N; ++i)
+		{
+			b[i] = -(m_Rows[i].GetRelativeVelocity(m_pObj1, m_pObj2) + m_Bias[i]);
+		}
+		m_Solver.Solve(b, impulse);
+
+		float residual = 0.0f;
+		for (int i = 0; i < N; ++i)
+		{
+			m_VelocityDelta.ApplyImpulse(m_pObj1, m_pObj2, m_Rows[i], impulse[i]);
+			residual = max(residual, fabs(impulse[i]));
+		}
+		return residual;
+	}
+
+	//Position correction pass - the block is built again for the integrated positions, then
+	// each iteration moves the objects to remove part of the (linearised) error of every row
+	void PrePositionStep()
+	{
+		BuildBlock();
+	}
+
+	float SolvePosition()
+	{
+		float b[N], correction[N];
+		float max_error = 0.0f;
+		for (int i = 0; i < N; ++i)
+		{
+			float error = m_Error[i] + m_Rows[i].GetRelativeCorrection(m_pObj1, m_pObj2);
+			max_error = max(max_error, fabs(error));
+			b[i] = -min(max(NGS_BAUMGARTE_SCALAR * error, -NGS_MAX_CORRECTION), NGS_MAX_CORRECTION);
+		}
+		m_Solver.Solve(b, correction);
+
+		for (int i = 0; i < N; ++i)
+		{
+			m_Rows[i].ApplyCorrection(m_pObj1, m_pObj2, correction[i]);
+		}
+		return max_error;
+	}
+
+	virtual PhysicsObject* GetObjectA() const override	{ return m_pObj1; }
+	virtual PhysicsObject* GetObjectB() const override	{ return m_pObj2; }
+
+protected:
+	//Fills in m_Rows and m_Error for the objects' current positions/orientations. Each error
+	// is measured so that it grows with the row's relative velocity (J * v), e.g. the position
+	// of the anchor on A minus the anchor on B.
+	virtual void BuildRows() = 0;
+
+	void BuildBlock()
+	{
+		BuildRows();
+
+		float K[N][N];
+		for (int i = 0; i < N; ++i)
+		{
+			for (int j = 0; j <= i; ++j)
+			{
+				K[i][j] = K[j][i] = m_Rows[i].GetCoupling(m_Rows[j]);
+			}
+		}
+		m_Solver.Factorise(K);
+	}
+
+protected:
+	PhysicsObject	*m_pObj1, *m_pObj2;
+
+	//Set up by PreSolverStep/PrePositionStep
+	JacobianRow		m_Rows[N];
+	float			m_Error[N];
+	float			m_Bias[N];
+	BlockSolver<N>	m_Solver;
+};
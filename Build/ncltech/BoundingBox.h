@@ -47,19 +47,55 @@ struct BoundingBox
 		_max.z = max(_max.z, point.z);
 	}
 
+	//Expand the boundingbox to fit another boundingbox
+	void ExpandToFit(const BoundingBox& other)
+	{
+		ExpandToFit(other._min);
+		ExpandToFit(other._max);
+	}
+
+	//Returns true if the two boundingboxes overlap (touching counts as overlapping)
+	bool Intersects(const BoundingBox& other) const
+	{
+		return _min.x <= other._max.x && other._min.x <= _max.x
+			&& _min.y <= other._max.y && other._min.y <= _max.y
+			&& _min.z <= other._max.z && other._min.z <= _max.z;
+	}
+
+	//Returns true if the given boundingbox is entirely inside this one
+	bool Contains(const BoundingBox& other) const
+	{
+		return _min.x <= other._min.x && _min.y <= other._min.y && _min.z <= other._min.z
+			&& other._max.x <= _max.x && other._max.y <= _max.y && other._max.z <= _max.z;
+	}
+
+	//Surface area of the box, used as the cost metric when building bounding volume hierarchies
+	float SurfaceArea() const
+	{
+		Vector3 d = _max - _min;
+		return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+	}
+
 	//Transform the given AABB and returns a new AABB that encapsulates the new rotated bounding box.
+	// The matrix must be affine (no perspective projection).
 	BoundingBox Transform(const Matrix4& mtx)
 	{
-		BoundingBox bb;
-		bb.ExpandToFit(mtx * Vector3(_min.x, _min.y, _min.z));
-		bb.ExpandToFit(mtx * Vector3(_max.x, _min.y, _min.z));
-		bb.ExpandToFit(mtx * Vector3(_min.x, _max.y, _min.z));
-		bb.ExpandToFit(mtx * Vector3(_max.x, _max.y, _min.z));
+		Vector3 corners[8] = {
+			Vector3(_min.x, _min.y, _min.z),
+			Vector3(_max.x, _min.y, _min.z),
+			Vector3(_min.x, _max.y, _min.z),
+			Vector3(_max.x, _max.y, _min.z),
+
+			Vector3(_min.x, _min.y, _max.z),
+			Vector3(_max.x, _min.y, _max.z),
+			Vector3(_min.x, _max.y, _max.z),
+			Vector3(_max.x, _max.y, _max.z)
+		};
+		mtx.TransformPoints(corners, corners, 8);
 
-		bb.ExpandToFit(mtx * Vector3(_min.x, _min.y, _max.z));
-		bb.ExpandToFit(mtx * Vector3(_max.x, _min.y, _max.z));
-		bb.ExpandToFit(mtx * Vector3(_min.x, _max.y, _max.z));
-		bb.ExpandToFit(mtx * Vector3(_max.x, _max.y, _max.z));
+		BoundingBox bb;
+		for (int i = 0; i < 8; ++i)
+			bb.ExpandToFit(corners[i]);
 		return bb;
 	}
 };
\ No newline at end of file
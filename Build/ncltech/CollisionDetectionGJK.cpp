@@ -0,0 +1,631 @@
+#include "CollisionDetectionGJK.h"
+
+#define GJK_TOLERANCE		1e-6f		//Relative change in distance at which GJK has converged
+#define GJK_EPSILON_SQ		1e-12f		//Squared distance at which two points are the same
+#define GJK_FLAT_TOLERANCE	1e-4f		//Sine of the angle below which a tetrahedron is treated as flat
+#define EPA_TOLERANCE		1e-4f		//How far the polytope must grow each iteration for EPA to carry on
+#define EPA_MIN_SEPARATION	1e-4f		//Cores closer than this are too close to get a normal from GJK
+
+CollisionDetectionGJK::CollisionDetectionGJK()
+	: m_pObj1(NULL)
+	, m_pObj2(NULL)
+	, m_pShape1(NULL)
+	, m_pShape2(NULL)
+	, m_Colliding(false)
+{
+	m_Simplex.count = 0;
+}
+
+void CollisionDetectionGJK::BeginNewPair(PhysicsObject* obj1, PhysicsObject* obj2)
+{
+	m_pObj1 = obj1;
+	m_pObj2 = obj2;
+	m_pShape1 = obj1->GetCollisionShape();
+	m_pShape2 = obj2->GetCollisionShape();
+
+	m_Colliding = false;
+}
+
+bool CollisionDetectionGJK::AreColliding(CollisionData* out_coldata)
+{
+	m_Colliding = false;
+	if (!m_pShape1 || !m_pShape2)
+		return false;
+
+	float margin1 = m_pShape1->GetSupportMargin();
+	float margin2 = m_pShape2->GetSupportMargin();
+
+	Vector3 core1, core2, normal;
+	float separation;			//Distance between the cores, negative if they intersect
+	bool found_normal = false;
+
+	if (!RunGJK(&core1, &core2))
+	{
+		//The cores are apart, so the shapes can only be colliding if their margins overlap
+		Vector3 diff = core2 - core1;
+		separation = diff.Length();
+		if (separation > margin1 + margin2)
+			return false;
+
+		if (separation > EPA_MIN_SEPARATION)
+		{
+			normal = diff * (1.0f / separation);
+			found_normal = true;
+		}
+	}
+
+	if (!found_normal)
+	{
+		float depth;
+		if (!BuildTetrahedron() || !RunEPA(&normal, &depth, &core1, &core2))
+			return false;
+
+		separation = -depth;
+	}
+
+	m_ColData._normal = normal;
+	m_ColData._penetration = separation - margin1 - margin2;
+	m_ColData._pointOnPlane = core2 - normal * margin2;
+
+	m_ContactOn1 = core1 + normal * margin1;
+	m_ContactOn2 = m_ColData._pointOnPlane;
+
+	if (out_coldata) *out_coldata = m_ColData;
+
+	m_Colliding = true;
+	return true;
+}
+
+void CollisionDetectionGJK::GenContactPoints(Manifold* out_manifold)
+{
+	if (!out_manifold || !m_Colliding)
+		return;
+
+	size_t num_contacts = out_manifold->GetNumContacts();
+
+	m_SAT.BeginNewPair(m_pObj1, m_pObj2, m_pObj1->GetCollisionShape(), m_pObj2->GetCollisionShape());
+	m_SAT.SetCollisionData(m_ColData);
+	m_SAT.GenContactPoints(out_manifold);
+
+	//Clipping finds nothing when the shapes only meet edge to edge, as the normal is then
+	// far from that of either face. The deepest points GJK/EPA found are still a contact.
+	if (out_manifold->GetNumContacts() == num_contacts)
+	{
+		out_manifold->AddContact(m_ContactOn1, m_ContactOn2, m_ColData._normal, m_ColData._penetration);
+	}
+}
+
+float CollisionDetectionGJK::GetDistance(Vector3* out_closest1, Vector3* out_closest2)
+{
+	if (!m_pShape1 || !m_pShape2)
+		return 0.0f;
+
+	Vector3 core1, core2;
+	if (RunGJK(&core1, &core2))
+	{
+		if (out_closest1) *out_closest1 = core1;
+		if (out_closest2) *out_closest2 = core2;
+		return 0.0f;
+	}
+
+	float margin1 = m_pShape1->GetSupportMargin();
+	float margin2 = m_pShape2->GetSupportMargin();
+
+	Vector3 diff = core2 - core1;
+	float dist = diff.Length();
+	Vector3 normal = (dist > 0.0f) ? diff * (1.0f / dist) : Vector3(0.0f, 0.0f, 0.0f);
+
+	if (out_closest1) *out_closest1 = core1 + normal * margin1;
+	if (out_closest2) *out_closest2 = core2 - normal * margin2;
+
+	dist = dist - margin1 - margin2;
+	return (dist > 0.0f) ? dist : 0.0f;
+}
+
+
+
+void CollisionDetectionGJK::Support(const Vector3& axis, SupportVertex* out_vertex) const
+{
+	out_vertex->p1 = m_pShape1->GetSupportPoint(m_pObj1, axis);
+	out_vertex->p2 = m_pShape2->GetSupportPoint(m_pObj2, -axis);
+	out_vertex->w = out_vertex->p1 - out_vertex->p2;
+}
+
+bool CollisionDetectionGJK::RunGJK(Vector3* out_closest1, Vector3* out_closest2)
+{
+	Simplex& simplex = m_Simplex;
+
+	//Start from any point on the Minkowski difference
+	Support(m_pObj2->GetPosition() - m_pObj1->GetPosition(), &simplex.verts[0]);
+	simplex.bary[0] = 1.0f;
+	simplex.count = 1;
+
+	Vector3 v = simplex.verts[0].w;
+	bool intersecting = false;
+	for (int itr = 0; itr < GJK_MAX_ITERATIONS; ++itr)
+	{
+		float vv = Vector3::Dot(v, v);
+		if (vv <= GJK_EPSILON_SQ)
+		{
+			//The origin is on the simplex
+			intersecting = true;
+			break;
+		}
+
+		//Furthest point of the Minkowski difference towards the origin
+		SupportVertex sv;
+		Support(-v, &sv);
+
+		//If that doesn't get us any closer to the origin, v is already the closest point
+		if (vv - Vector3::Dot(v, sv.w) <= GJK_TOLERANCE * vv)
+			break;
+
+		//..same if it is already in the simplex, which rounding errors can cause
+		bool duplicate = false;
+		for (int i = 0; i < simplex.count; ++i)
+		{
+			if ((simplex.verts[i].w - sv.w).LengthSquared() <= GJK_EPSILON_SQ)
+				duplicate = true;
+		}
+		if (duplicate)
+			break;
+
+		simplex.verts[simplex.count++] = sv;
+		v = ReduceSimplex(simplex);
+
+		//Only a tetrahedron with the origin inside it is left whole
+		if (simplex.count == 4)
+		{
+			intersecting = true;
+			break;
+		}
+	}
+
+	if (!intersecting)
+	{
+		Vector3 closest1 = Vector3(0.0f, 0.0f, 0.0f);
+		Vector3 closest2 = Vector3(0.0f, 0.0f, 0.0f);
+		for (int i = 0; i < simplex.count; ++i)
+		{
+			closest1 = closest1 + simplex.verts[i].p1 * simplex.bary[i];
+			closest2 = closest2 + simplex.verts[i].p2 * simplex.bary[i];
+		}
+
+		if (out_closest1) *out_closest1 = closest1;
+		if (out_closest2) *out_closest2 = closest2;
+	}
+
+	return intersecting;
+}
+
+bool CollisionDetectionGJK::BuildTetrahedron()
+{
+	static const Vector3 axes[6] = {
+		Vector3(1.0f, 0.0f, 0.0f), Vector3(-1.0f, 0.0f, 0.0f),
+		Vector3(0.0f, 1.0f, 0.0f), Vector3(0.0f, -1.0f, 0.0f),
+		Vector3(0.0f, 0.0f, 1.0f), Vector3(0.0f, 0.0f, -1.0f) };
+
+	Simplex& simplex = m_Simplex;
+	SupportVertex sv;
+
+	if (simplex.count == 1)
+	{
+		//Any other point will do for a line
+		for (int i = 0; i < 6 && simplex.count == 1; ++i)
+		{
+			Support(axes[i], &sv);
+			if ((sv.w - simplex.verts[0].w).LengthSquared() > GJK_EPSILON_SQ)
+				simplex.verts[simplex.count++] = sv;
+		}
+	}
+
+	if (simplex.count == 2)
+	{
+		//Search around the line (starting from the world axis least in line with it) for a
+		// point off the line
+		Vector3 line = simplex.verts[1].w - simplex.verts[0].w;
+		int axis = (fabs(line.x) < fabs(line.y))
+			? ((fabs(line.x) < fabs(line.z)) ? 0 : 4)
+			: ((fabs(line.y) < fabs(line.z)) ? 2 : 4);
+
+		Vector3 dir1 = Vector3::Cross(line, axes[axis]);
+		Vector3 dir2 = Vector3::Cross(line, dir1);
+		const Vector3 dirs[4] = { dir1, -dir1, dir2, -dir2 };
+		for (int i = 0; i < 4 && simplex.count == 2; ++i)
+		{
+			Support(dirs[i], &sv);
+			if (Vector3::Cross(sv.w - simplex.verts[0].w, line).LengthSquared() > GJK_EPSILON_SQ)
+				simplex.verts[simplex.count++] = sv;
+		}
+	}
+
+	if (simplex.count == 3)
+	{
+		//And then a point off the triangle, on either side of it
+		Vector3 normal = Vector3::Cross(simplex.verts[1].w - simplex.verts[0].w, simplex.verts[2].w - simplex.verts[0].w);
+		for (int i = 0; i < 2 && simplex.count == 3; ++i)
+		{
+			Support((i == 0) ? normal : -normal, &sv);
+			if (fabs(Vector3::Dot(sv.w - simplex.verts[0].w, normal)) > GJK_EPSILON_SQ)
+				simplex.verts[simplex.count++] = sv;
+		}
+	}
+
+	//Otherwise the Minkowski difference is flat, so the shapes are only touching
+	return simplex.count == 4;
+}
+
+bool CollisionDetectionGJK::RunEPA(Vector3* out_normal, float* out_depth, Vector3* out_closest1, Vector3* out_closest2)
+{
+	//Fixed size polytope, so nothing here touches the heap
+	SupportVertex verts[EPA_MAX_VERTICES];
+	EPAFace faces[EPA_MAX_FACES];
+	bool visible[EPA_MAX_FACES];
+	int edges[EPA_MAX_EDGES][2];
+
+	for (int i = 0; i < 4; ++i)
+		verts[i] = m_Simplex.verts[i];
+	int num_verts = 4;
+
+	//Wind the tetrahedron so that the faces below all point outwards
+	Vector3 normal012 = Vector3::Cross(verts[1].w - verts[0].w, verts[2].w - verts[0].w);
+	if (Vector3::Dot(normal012, verts[3].w - verts[0].w) > 0.0f)
+		std::swap(verts[1], verts[2]);
+
+	SetFace(faces[0], verts, 0, 1, 2);
+	SetFace(faces[1], verts, 0, 3, 1);
+	SetFace(faces[2], verts, 0, 2, 3);
+	SetFace(faces[3], verts, 1, 3, 2);
+	int num_faces = 4;
+
+	int closest;
+	for (;;)
+	{
+		//Face of the polytope closest to the origin
+		closest = 0;
+		for (int i = 1; i < num_faces; ++i)
+		{
+			if (faces[i].dist < faces[closest].dist)
+				closest = i;
+		}
+
+		const EPAFace& face = faces[closest];
+		if (face.dist == FLT_MAX)
+			return false;
+
+		//If the Minkowski difference doesn't go any further out than this face, then
+		// it's (close enough to) the surface
+		SupportVertex sv;
+		Support(face.normal, &sv);
+		if (Vector3::Dot(sv.w, face.normal) - face.dist < EPA_TOLERANCE || num_verts == EPA_MAX_VERTICES)
+			break;
+
+		//Find all faces that can see the new vertex, and the horizon around them - made
+		// up of the edges that are only used by one of those faces
+		int num_edges = 0;
+		int num_visible = 0;
+		bool overflow = false;
+		for (int i = 0; i < num_faces; ++i)
+		{
+			visible[i] = Vector3::Dot(faces[i].normal, sv.w - verts[faces[i].v[0]].w) > 0.0f;
+			if (!visible[i])
+				continue;
+
+			++num_visible;
+			for (int j = 0; j < 3; ++j)
+			{
+				int a = faces[i].v[j];
+				int b = faces[i].v[(j + 1) % 3];
+
+				int shared = -1;
+				for (int k = 0; k < num_edges; ++k)
+				{
+					if (edges[k][0] == b && edges[k][1] == a)
+						shared = k;
+				}
+
+				if (shared >= 0)
+				{
+					edges[shared][0] = edges[num_edges - 1][0];
+					edges[shared][1] = edges[num_edges - 1][1];
+					--num_edges;
+				}
+				else if (num_edges < EPA_MAX_EDGES)
+				{
+					edges[num_edges][0] = a;
+					edges[num_edges][1] = b;
+					++num_edges;
+				}
+				else
+				{
+					overflow = true;
+				}
+			}
+		}
+
+		//Stop with what we have if the polytope would get too big
+		if (overflow || num_faces - num_visible + num_edges > EPA_MAX_FACES)
+			break;
+
+		//Replace the visible faces with a fan of new faces from the horizon to the new vertex
+		int new_vert = num_verts++;
+		verts[new_vert] = sv;
+
+		int num_kept = 0;
+		for (int i = 0; i < num_faces; ++i)
+		{
+			if (!visible[i])
+				faces[num_kept++] = faces[i];
+		}
+		num_faces = num_kept;
+
+		for (int i = 0; i < num_edges; ++i)
+		{
+			SetFace(faces[num_faces++], verts, edges[i][0], edges[i][1], new_vert);
+		}
+	}
+
+	const EPAFace& face = faces[closest];
+	const SupportVertex& a = verts[face.v[0]];
+	const SupportVertex& b = verts[face.v[1]];
+	const SupportVertex& c = verts[face.v[2]];
+
+	//Barycentric coordinates of the origin projected onto the face, which give the
+	// deepest points on each of the shapes
+	Vector3 p = face.normal * face.dist;
+	Vector3 v0 = b.w - a.w, v1 = c.w - a.w, v2 = p - a.w;
+	float d00 = Vector3::Dot(v0, v0);
+	float d01 = Vector3::Dot(v0, v1);
+	float d11 = Vector3::Dot(v1, v1);
+	float d20 = Vector3::Dot(v2, v0);
+	float d21 = Vector3::Dot(v2, v1);
+	float denom = d00 * d11 - d01 * d01;
+
+	float u = 1.0f, v = 0.0f, w = 0.0f;
+	if (fabs(denom) > GJK_EPSILON_SQ)
+	{
+		v = (d11 * d20 - d01 * d21) / denom;
+		w = (d00 * d21 - d01 * d20) / denom;
+		u = 1.0f - v - w;
+	}
+
+	*out_normal = face.normal;
+	*out_depth = face.dist;
+	*out_closest1 = a.p1 * u + b.p1 * v + c.p1 * w;
+	*out_closest2 = a.p2 * u + b.p2 * v + c.p2 * w;
+	return true;
+}
+
+void CollisionDetectionGJK::SetFace(EPAFace& face, const SupportVertex* verts, int a, int b, int c)
+{
+	face.v[0] = a;
+	face.v[1] = b;
+	face.v[2] = c;
+
+	Vector3 normal = Vector3::Cross(verts[b].w - verts[a].w, verts[c].w - verts[a].w);
+	float length = normal.Length();
+	if (length > GJK_EPSILON_SQ)
+	{
+		face.normal = normal * (1.0f / length);
+		face.dist = Vector3::Dot(face.normal, verts[a].w);
+	}
+	else
+	{
+		//Degenerate faces are kept to hold the polytope together, but never picked as the closest
+		face.normal = Vector3(0.0f, 0.0f, 0.0f);
+		face.dist = FLT_MAX;
+	}
+}
+
+
+
+Vector3 CollisionDetectionGJK::ReduceSimplex(Simplex& simplex)
+{
+	switch (simplex.count)
+	{
+	case 1:
+		simplex.bary[0] = 1.0f;
+		break;
+	case 2:
+		ReduceLine(simplex);
+		break;
+	case 3:
+		ReduceTriangle(simplex);
+		break;
+	case 4:
+		ReduceTetrahedron(simplex);
+		if (simplex.count == 4)
+			return Vector3(0.0f, 0.0f, 0.0f);
+		break;
+	}
+
+	Vector3 closest = Vector3(0.0f, 0.0f, 0.0f);
+	for (int i = 0; i < simplex.count; ++i)
+	{
+		closest = closest + simplex.verts[i].w * simplex.bary[i];
+	}
+	return closest;
+}
+
+void CollisionDetectionGJK::ReduceLine(Simplex& simplex)
+{
+	const Vector3& a = simplex.verts[0].w;
+	const Vector3& b = simplex.verts[1].w;
+	Vector3 ab = b - a;
+
+	//Distance along the line of the origin, clamped between a and b
+	float t = -Vector3::Dot(a, ab);
+	float length_sq = Vector3::Dot(ab, ab);
+	if (t <= 0.0f)
+	{
+		simplex.bary[0] = 1.0f;
+		simplex.count = 1;
+	}
+	else if (t >= length_sq)
+	{
+		simplex.verts[0] = simplex.verts[1];
+		simplex.bary[0] = 1.0f;
+		simplex.count = 1;
+	}
+	else
+	{
+		t = t / length_sq;
+		simplex.bary[0] = 1.0f - t;
+		simplex.bary[1] = t;
+	}
+}
+
+void CollisionDetectionGJK::ReduceTriangle(Simplex& simplex)
+{
+	//Works out which of the triangle's vertex, edge or face regions the origin is in
+	// (see Real-Time Collision Detection, Christer Ericson, 5.1.5)
+	const SupportVertex sa = simplex.verts[0];
+	const SupportVertex sb = simplex.verts[1];
+	const SupportVertex sc = simplex.verts[2];
+	const Vector3& a = sa.w;
+	const Vector3& b = sb.w;
+	const Vector3& c = sc.w;
+
+	Vector3 ab = b - a;
+	Vector3 ac = c - a;
+
+	float d1 = -Vector3::Dot(ab, a);
+	float d2 = -Vector3::Dot(ac, a);
+	if (d1 <= 0.0f && d2 <= 0.0f)
+	{
+		simplex.bary[0] = 1.0f;
+		simplex.count = 1;
+		return;
+	}
+
+	float d3 = -Vector3::Dot(ab, b);
+	float d4 = -Vector3::Dot(ac, b);
+	if (d3 >= 0.0f && d4 <= d3)
+	{
+		simplex.verts[0] = sb;
+		simplex.bary[0] = 1.0f;
+		simplex.count = 1;
+		return;
+	}
+
+	float vc = d1 * d4 - d3 * d2;
+	if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+	{
+		float t = d1 / (d1 - d3);
+		simplex.bary[0] = 1.0f - t;
+		simplex.bary[1] = t;
+		simplex.count = 2;
+		return;
+	}
+
+	float d5 = -Vector3::Dot(ab, c);
+	float d6 = -Vector3::Dot(ac, c);
+	if (d6 >= 0.0f && d5 <= d6)
+	{
+		simplex.verts[0] = sc;
+		simplex.bary[0] = 1.0f;
+		simplex.count = 1;
+		return;
+	}
+
+	float vb = d5 * d2 - d1 * d6;
+	if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+	{
+		float t = d2 / (d2 - d6);
+		simplex.verts[1] = sc;
+		simplex.bary[0] = 1.0f - t;
+		simplex.bary[1] = t;
+		simplex.count = 2;
+		return;
+	}
+
+	float va = d3 * d6 - d5 * d4;
+	if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+	{
+		float t = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+		simplex.verts[0] = sb;
+		simplex.verts[1] = sc;
+		simplex.bary[0] = 1.0f - t;
+		simplex.bary[1] = t;
+		simplex.count = 2;
+		return;
+	}
+
+	float sum = va + vb + vc;
+	if (sum <= GJK_EPSILON_SQ)
+	{
+		//Degenerate (flat) triangle, so just use the closest of its edges
+		Simplex best;
+		float best_dist_sq = FLT_MAX;
+		const SupportVertex* edges[3][2] = { { &sa, &sb }, { &sb, &sc }, { &sc, &sa } };
+		for (int i = 0; i < 3; ++i)
+		{
+			Simplex line;
+			line.verts[0] = *edges[i][0];
+			line.verts[1] = *edges[i][1];
+			line.count = 2;
+
+			Vector3 closest = ReduceSimplex(line);
+			float dist_sq = Vector3::Dot(closest, closest);
+			if (dist_sq < best_dist_sq)
+			{
+				best_dist_sq = dist_sq;
+				best = line;
+			}
+		}
+		simplex = best;
+		return;
+	}
+
+	float denom = 1.0f / sum;
+	float v = vb * denom;
+	float w = vc * denom;
+	simplex.bary[0] = 1.0f - v - w;
+	simplex.bary[1] = v;
+	simplex.bary[2] = w;
+}
+
+void CollisionDetectionGJK::ReduceTetrahedron(Simplex& simplex)
+{
+	//Each face, followed by the vertex opposite it
+	static const int faces[4][4] = { { 0, 1, 2, 3 }, { 0, 2, 3, 1 }, { 0, 3, 1, 2 }, { 1, 3, 2, 0 } };
+
+	Simplex best;
+	float best_dist_sq = FLT_MAX;
+	for (int i = 0; i < 4; ++i)
+	{
+		const Vector3& a = simplex.verts[faces[i][0]].w;
+		const Vector3& b = simplex.verts[faces[i][1]].w;
+		const Vector3& c = simplex.verts[faces[i][2]].w;
+		const Vector3& d = simplex.verts[faces[i][3]].w;
+
+		//The origin is outside this face if it's on the other side of it to the opposite
+		// vertex. A flat tetrahedron counts as having the origin outside all of them.
+		Vector3 normal = Vector3::Cross(b - a, c - a);
+		Vector3 ad = d - a;
+		float side_origin = -Vector3::Dot(normal, a);
+		float side_opposite = Vector3::Dot(normal, ad);
+		bool flat = side_opposite * side_opposite <= GJK_FLAT_TOLERANCE * GJK_FLAT_TOLERANCE
+			* Vector3::Dot(normal, normal) * Vector3::Dot(ad, ad);
+		if (side_origin * side_opposite > 0.0f && !flat)
+			continue;
+
+		Simplex triangle;
+		triangle.verts[0] = simplex.verts[faces[i][0]];
+		triangle.verts[1] = simplex.verts[faces[i][1]];
+		triangle.verts[2] = simplex.verts[faces[i][2]];
+		triangle.count = 3;
+
+		Vector3 closest = ReduceSimplex(triangle);
+		float dist_sq = Vector3::Dot(closest, closest);
+		if (dist_sq < best_dist_sq)
+		{
+			best_dist_sq = dist_sq;
+			best = triangle;
+		}
+	}
+
+	//Otherwise the origin is inside the tetrahedron
+	if (best_dist_sq < FLT_MAX)
+		simplex = best;
+}
@@ -0,0 +1,110 @@
+/******************************************************************************
+Class: CollisionDetectionGJK
+Description: Collision detection between any two convex shapes, using only
+their support functions (CollisionShape::GetSupportPoint).
+
+GJK finds the point of the Minkowski difference (shape1 - shape2) closest to
+the origin, which gives the distance and closest points between the shapes,
+or tells us they intersect if the origin is inside it. When they do intersect,
+EPA then expands the final GJK simplex out to the surface of the Minkowski
+difference to find the penetration depth and normal.
+
+Both only run on the 'cores' of the shapes, with their margins (e.g. a
+sphere's radius) added on afterwards - so anything rounded only needs EPA once
+its core is actually inside the other shape.
+
+Contact points are generated by clipping the shapes' faces against each other
+around the EPA normal, exactly as CollisionDetectionSAT does. Has the same
+interface as CollisionDetectionSAT, and keeps the state of the current pair in
+the same way.
+******************************************************************************/
+#pragma once
+
+#include "CollisionDetectionSAT.h"
+
+#define GJK_MAX_ITERATIONS	64
+#define EPA_MAX_VERTICES	64
+#define EPA_MAX_FACES		128
+#define EPA_MAX_EDGES		64		//Most edges on the horizon of any one new vertex
+
+class CollisionDetectionGJK
+{
+public:
+	CollisionDetectionGJK();
+
+	//Start processing new (possible) collision pair
+	void BeginNewPair(PhysicsObject* obj1, PhysicsObject* obj2);
+
+	//Returns true if the objects are colliding or false otherwise
+	bool AreColliding(CollisionData* out_coldata = NULL);
+
+	//Adds the contact points of the colliding pair to the manifold
+	void GenContactPoints(Manifold* out_manifold);
+
+	//Distance between the two shapes (or 0 if they are touching), along with the
+	// closest points on each of them. Much cheaper than AreColliding when the shapes
+	// are apart, so can be used to look ahead for speculative contacts, AI etc.
+	float GetDistance(Vector3* out_closest1 = NULL, Vector3* out_closest2 = NULL);
+
+protected:
+	//A point on the Minkowski difference, along with the points on each shape that made it
+	struct SupportVertex
+	{
+		Vector3 p1;
+		Vector3 p2;
+		Vector3 w;			//p1 - p2
+	};
+
+	struct Simplex
+	{
+		SupportVertex	verts[4];
+		float			bary[4];	//Weight of each vertex in the point closest to the origin
+		int				count;
+	};
+
+	struct EPAFace
+	{
+		int		v[3];
+		Vector3	normal;		//Facing away from the origin
+		float	dist;		//Distance from the origin to the face's plane
+	};
+
+	//Support point of the Minkowski difference of the two cores
+	void Support(const Vector3& axis, SupportVertex* out_vertex) const;
+
+	//Runs GJK on the two cores, leaving the final simplex in m_Simplex. Returns true if
+	// they intersect, otherwise their closest points are left in out_closest1/2.
+	bool RunGJK(Vector3* out_closest1, Vector3* out_closest2);
+
+	//Runs EPA on the (intersecting) cores from the final GJK simplex, returning false if
+	// the intersection was too shallow to give a normal
+	bool RunEPA(Vector3* out_normal, float* out_depth, Vector3* out_closest1, Vector3* out_closest2);
+
+	//Adds vertices to the simplex until it is a tetrahedron, if the shapes are only just
+	// touching GJK may have stopped before it found one.
+	bool BuildTetrahedron();
+
+	//Reduces the simplex to the smallest part of it containing the point closest to the
+	// origin, setting the weights of the remaining vertices. Returns that point.
+	static Vector3 ReduceSimplex(Simplex& simplex);
+	static void ReduceLine(Simplex& simplex);
+	static void ReduceTriangle(Simplex& simplex);
+	static void ReduceTetrahedron(Simplex& simplex);
+
+	//Sets up an EPA face, with its normal following the winding order a->b->c
+	static void SetFace(EPAFace& face, const SupportVertex* verts, int a, int b, int c);
+
+protected:
+	PhysicsObject*			m_pObj1;
+	PhysicsObject*			m_pObj2;
+	const CollisionShape*	m_pShape1;
+	const CollisionShape*	m_pShape2;
+
+	Simplex					m_Simplex;
+	CollisionData			m_ColData;
+	bool					m_Colliding;
+	Vector3					m_ContactOn1;		//Deepest points of each shape inside the other
+	Vector3					m_ContactOn2;
+
+	CollisionDetectionSAT	m_SAT;				//Just used to clip the contact faces
+};
@@ -58,6 +58,12 @@ bool CollisionDetectionSAT::AreColliding(CollisionData* out_coldata)
 	return true;
 }
 
+void CollisionDetectionSAT::SetCollisionData(const CollisionData& coldata)
+{
+	m_BestColData = coldata;
+	m_Colliding = true;
+}
+
 void CollisionDetectionSAT::FindAllPossibleCollisionAxes()
 {
 	/* TUT 4 */
@@ -207,9 +213,10 @@ void CollisionDetectionSAT::GenContactPoints(Manifold* out_manifold)
 	// Get the required face information for the two shapes around
 	// the collision normal
 	
-	std::list < Vector3 > polygon1, polygon2;
+	// (All of these are fixed size, so nothing here touches the heap)
+	ContactPolygon polygon1, polygon2;
 	Vector3 normal1, normal2;
-	std::vector < Plane > adjPlanes1, adjPlanes2;
+	ContactClipPlanes adjPlanes1, adjPlanes2;
 	
 	m_pShape1 -> GetIncidentReferencePolygon(m_pObj1,
 	m_BestColData._normal, &polygon1, &normal1, &adjPlanes1);
@@ -221,22 +228,22 @@ void CollisionDetectionSAT::GenContactPoints(Manifold* out_manifold)
 	// must be on a curve and thus the only contact point to
 	// generate is already availble
 	
-	if (polygon1.size() == 0 || polygon2.size() == 0)
+	if (polygon1.count == 0 || polygon2.count == 0)
 	{
 		return; // No points returned , resulting in no possible
 			    // contact points
 	}
-	else if (polygon1.size() == 1)
+	else if (polygon1.count == 1)
 	{
-		out_manifold -> AddContact(polygon1.front(), polygon1.front()
+		out_manifold -> AddContact(polygon1.vertices[0], polygon1.vertices[0]
 		+ m_BestColData._normal * m_BestColData._penetration,
 		m_BestColData._normal, m_BestColData._penetration);
 	}
-	else if (polygon2.size() == 1)
+	else if (polygon2.count == 1)
 	{
-		out_manifold -> AddContact(polygon2.front()
+		out_manifold -> AddContact(polygon2.vertices[0]
 		+ m_BestColData._normal * m_BestColData._penetration,
-		polygon2.front(), m_BestColData._normal,
+		polygon2.vertices[0], m_BestColData._normal,
 		m_BestColData._penetration);
 	}
 	else
@@ -246,16 +253,16 @@ void CollisionDetectionSAT::GenContactPoints(Manifold* out_manifold)
 		// planes
 		
 		bool flipped;
-		std::list < Vector3 > * incPolygon;
+		ContactPolygon * incPolygon;
 		Vector3 * incNormal;
-		std::vector < Plane > * refAdjPlanes;
+		ContactClipPlanes * refAdjPlanes;
 		Plane refPlane;
 		
 		// Get the incident and reference polygons
 		if (fabs(Vector3::Dot(m_BestColData._normal, normal1))
 		> fabs(Vector3::Dot(m_BestColData._normal, normal2)))
 		{
-			float planeDist = -Vector3::Dot(-normal1, polygon1.front());
+			float planeDist = -Vector3::Dot(-normal1, polygon1.vertices[0]);
 			refPlane = Plane(-normal1, planeDist);
 			refAdjPlanes = &adjPlanes1;
 			
@@ -266,7 +273,7 @@ void CollisionDetectionSAT::GenContactPoints(Manifold* out_manifold)
 		}
 		else
 		{
-			float planeDist = -Vector3::Dot(-normal2, polygon2.front());
+			float planeDist = -Vector3::Dot(-normal2, polygon2.vertices[0]);
 			refPlane = Plane(-normal2, planeDist);
 			refAdjPlanes = &adjPlanes2;
 			
@@ -280,8 +287,8 @@ void CollisionDetectionSAT::GenContactPoints(Manifold* out_manifold)
 		// Clip the incident face to the adjacent edges of the reference
 		// face
 		
-		SutherlandHodgmanClipping(*incPolygon, refAdjPlanes -> size(),
-		& (*refAdjPlanes)[0], incPolygon, false);
+		SutherlandHodgmanClipping(*incPolygon, refAdjPlanes -> count,
+		refAdjPlanes -> planes, incPolygon, false);
 		
 		// Finally clip (and remove ) any contact points that are above
 		// the reference face
@@ -292,8 +299,9 @@ void CollisionDetectionSAT::GenContactPoints(Manifold* out_manifold)
 		// Now we are left with a selection of valid contact points to
 		// be used for the manifold
 		
-		for (const Vector3 & vertPos : *incPolygon)
+		for (int i = 0; i < incPolygon -> count; ++i)
 		{
+			const Vector3 & vertPos = incPolygon -> vertices[i];
 			float contact_penetration;
 			Vector3 globalOnA, globalOnB;
 			
@@ -303,7 +311,7 @@ void CollisionDetectionSAT::GenContactPoints(Manifold* out_manifold)
 				
 				contact_penetration =
 				- (Vector3::Dot(vertPos, m_BestColData._normal)
-				- Vector3::Dot(m_BestColData._normal, polygon2.front()));
+				- Vector3::Dot(m_BestColData._normal, polygon2.vertices[0]));
 				
 				globalOnA = vertPos
 				+ m_BestColData._normal * contact_penetration;
@@ -315,7 +323,7 @@ void CollisionDetectionSAT::GenContactPoints(Manifold* out_manifold)
 				
 				contact_penetration =
 				Vector3::Dot(vertPos, m_BestColData._normal)
-				- Vector3::Dot(m_BestColData._normal, polygon1.front());
+				- Vector3::Dot(m_BestColData._normal, polygon1.vertices[0]);
 				
 				globalOnA = vertPos;
 				globalOnB = vertPos
@@ -360,20 +368,20 @@ Vector3 CollisionDetectionSAT::PlaneEdgeIntersection(const Plane& plane, const V
 }
 
 void CollisionDetectionSAT::SutherlandHodgmanClipping(
-	const std::list<Vector3>& input_polygon,
+	const ContactPolygon& input_polygon,
 	int num_clip_planes,
 	const Plane* clip_planes,
-	std::list<Vector3>* out_polygon,
+	ContactPolygon* out_polygon,
 	bool removePoints) const
 {
 	if (!out_polygon)
 		return;
 
-	//Create temporary list of vertices
+	//Create temporary polygons
 	// - We will keep ping-pong'ing between 
-	//   the two lists updating them as we go.
-	std::list<Vector3> ppPolygon1, ppPolygon2;
-	std::list<Vector3> *input = &ppPolygon1, *output = &ppPolygon2;
+	//   the two updating them as we go.
+	ContactPolygon ppPolygon1, ppPolygon2;
+	ContactPolygon *input = &ppPolygon1, *output = &ppPolygon2;
 
 	*output = input_polygon;
 
@@ -382,22 +390,23 @@ void CollisionDetectionSAT::SutherlandHodgmanClipping(
 	for (int i = 0; i < num_clip_planes; ++i)
 	{
 		//If we every single point on our shape has already been removed, just exit
-		if (output->empty())
+		if (output->count == 0)
 			break;
 
 
 
 		const Plane& plane = clip_planes[i];
 
-		//Swap input/output polygons, and clear output list for us to generate afresh
+		//Swap input/output polygons, and clear output polygon for us to generate afresh
 		std::swap(input, output);
-		output->clear();
+		output->Clear();
 
 		//Loop through each edge of the polygon (see line_loop from gfx) and clips
 		// that edge against the plane.
-		Vector3 startPoint = input->back();
-		for (const Vector3& endPoint : *input)
+		Vector3 startPoint = input->vertices[input->count - 1];
+		for (int j = 0; j < input->count; ++j)
 		{
+			const Vector3& endPoint = input->vertices[j];
 			bool startInPlane = plane.PointInPlane(startPoint);
 			bool endInPlane = plane.PointInPlane(endPoint);
 
@@ -405,23 +414,23 @@ void CollisionDetectionSAT::SutherlandHodgmanClipping(
 			if (removePoints)
 			{
 				if (endInPlane)
-					output->push_back(endPoint);
+					output->Add(endPoint);
 			}
 			else
 			{
 				//if entire edge is within the clipping plane, keep it as it is
 				if (startInPlane && endInPlane)
-					output->push_back(endPoint);
+					output->Add(endPoint);
 
 				//if edge interesects the clipping plane, cut the edge along clip plane
 				else if (startInPlane && !endInPlane)
 				{
-					output->push_back(PlaneEdgeIntersection(plane, startPoint, endPoint));
+					output->Add(PlaneEdgeIntersection(plane, startPoint, endPoint));
 				}
 				else if (!startInPlane && endInPlane)
 				{
-					output->push_back(PlaneEdgeIntersection(plane, endPoint, startPoint));
-					output->push_back(endPoint);
+					output->Add(PlaneEdgeIntersection(plane, endPoint, startPoint));
+					output->Add(endPoint);
 				}
 			}
 			//..otherwise the edge is entirely outside the clipping plane and should be removed
@@ -431,4 +440,4 @@ void CollisionDetectionSAT::SutherlandHodgmanClipping(
 	}
 
 	*out_polygon = *output;
-}
+}
\ No newline at end of file
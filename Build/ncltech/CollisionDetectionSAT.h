@@ -79,6 +79,10 @@ public:
 	// - Uses clipping to construct a manifold describing the surface area
 	//   of the collision region
 	void GenContactPoints(Manifold* out_manifold);
+
+	// Skips the axis tests when the collision has already been found some other
+	//  way (see CollisionDispatch), so the contact points can still be clipped
+	void SetCollisionData(const CollisionData& coldata);
 	
 protected:
 //<---- SAT ---->
@@ -114,10 +118,10 @@ protected:
 	//Performs sutherland hodgeson clipping algorithm to clip the provided mesh
 	//    or polygon in regards to each of the provided clipping planes.
 	void SutherlandHodgmanClipping(
-		const std::list<Vector3>& input_polygon,
+		const ContactPolygon& input_polygon,
 		int num_clip_planes,
 		const Plane* clip_planes,
-		std::list<Vector3>* out_polygon,
+		ContactPolygon* out_polygon,
 		bool removeNotClipToPlane) const;
 
 private:
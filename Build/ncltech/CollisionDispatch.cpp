@@ -0,0 +1,259 @@
+#include "CollisionDispatch.h"
+#include "SphereCollisionShape.h"
+#include "CuboidCollisionShape.h"
+#include <nclgl\Matrix3.h>
+
+const CollisionDispatch::PairRoutine CollisionDispatch::s_Routines[COLLISION_SHAPE_MAX][COLLISION_SHAPE_MAX] =
+{
+	//GENERIC
+	{
+		{ &CollisionDispatch::CollideGJK,			&CollisionDispatch::ContactsGJK },		//GENERIC
+		{ &CollisionDispatch::CollideGJK,			&CollisionDispatch::ContactsGJK },		//SPHERE
+		{ &CollisionDispatch::CollideGJK,			&CollisionDispatch::ContactsGJK },		//CUBOID
+	},
+	//SPHERE
+	{
+		{ &CollisionDispatch::CollideGJK,			&CollisionDispatch::ContactsGJK },		//GENERIC
+		{ &CollisionDispatch::CollideSphereSphere,	&CollisionDispatch::ContactsSingle },	//SPHERE
+		{ &CollisionDispatch::CollideSphereCuboid,	&CollisionDispatch::ContactsSingle },	//CUBOID
+	},
+	//CUBOID
+	{
+		{ &CollisionDispatch::CollideGJK,			&CollisionDispatch::ContactsGJK },		//GENERIC
+		{ &CollisionDispatch::CollideCuboidSphere,	&CollisionDispatch::ContactsSingle },	//SPHERE
+		{ &CollisionDispatch::CollideCuboidCuboid,	&CollisionDispatch::ContactsClipped },	//CUBOID
+	},
+};
+
+CollisionDispatch::CollisionDispatch()
+	: m_pObj1(NULL)
+	, m_pObj2(NULL)
+	, m_pRoutine(NULL)
+{
+}
+
+void CollisionDispatch::BeginNewPair(PhysicsObject* obj1, PhysicsObject* obj2)
+{
+	m_pObj1 = obj1;
+	m_pObj2 = obj2;
+
+	const CollisionShape* shape1 = obj1->GetCollisionShape();
+	const CollisionShape* shape2 = obj2->GetCollisionShape();
+	m_pRoutine = (shape1 && shape2) ? &s_Routines[shape1->GetType()][shape2->GetType()] : NULL;
+}
+
+bool CollisionDispatch::AreColliding(CollisionData* out_coldata)
+{
+	if (!m_pRoutine || !(this->*m_pRoutine->collide)())
+		return false;
+
+	if (out_coldata) *out_coldata = m_ColData;
+	return true;
+}
+
+void CollisionDispatch::GenContactPoints(Manifold* out_manifold)
+{
+	if (out_manifold && m_pRoutine)
+		(this->*m_pRoutine->contacts)(out_manifold);
+}
+
+
+
+bool CollisionDispatch::CollideGJK()
+{
+	m_GJK.BeginNewPair(m_pObj1, m_pObj2);
+	return m_GJK.AreColliding(&m_ColData);
+}
+
+void CollisionDispatch::ContactsGJK(Manifold* out_manifold)
+{
+	m_GJK.GenContactPoints(out_manifold);
+}
+
+void CollisionDispatch::ContactsSingle(Manifold* out_manifold)
+{
+	out_manifold->AddContact(m_ContactOnA, m_ContactOnB, m_ColData._normal, m_ColData._penetration);
+}
+
+void CollisionDispatch::ContactsClipped(Manifold* out_manifold)
+{
+	m_SAT.BeginNewPair(m_pObj1, m_pObj2, m_pObj1->GetCollisionShape(), m_pObj2->GetCollisionShape());
+	m_SAT.SetCollisionData(m_ColData);
+	m_SAT.GenContactPoints(out_manifold);
+}
+
+
+
+bool CollisionDispatch::CollideSphereSphere()
+{
+	float r1 = static_cast<const SphereCollisionShape*>(m_pObj1->GetCollisionShape())->GetRadius();
+	float r2 = static_cast<const SphereCollisionShape*>(m_pObj2->GetCollisionShape())->GetRadius();
+
+	Vector3 ab = m_pObj2->GetPosition() - m_pObj1->GetPosition();
+	float distSq = Vector3::Dot(ab, ab);
+	float radii = r1 + r2;
+	if (distSq > radii * radii)
+		return false;
+
+	//Spheres sitting exactly on top of each other can be pushed apart in any direction
+	float dist = sqrtf(distSq);
+	Vector3 normal = (dist > 1e-6f) ? ab * (1.0f / dist) : Vector3(0.0f, 1.0f, 0.0f);
+
+	m_ColData._normal = normal;
+	m_ColData._penetration = dist - radii;
+	m_ColData._pointOnPlane = m_pObj2->GetPosition() - normal * r2;
+
+	m_ContactOnA = m_pObj1->GetPosition() + normal * r1;
+	m_ContactOnB = m_ColData._pointOnPlane;
+	return true;
+}
+
+bool CollisionDispatch::CollideSphereCuboid()
+{
+	return CollideSphereCuboid(m_pObj1, m_pObj2, false);
+}
+
+bool CollisionDispatch::CollideCuboidSphere()
+{
+	return CollideSphereCuboid(m_pObj2, m_pObj1, true);
+}
+
+bool CollisionDispatch::CollideSphereCuboid(const PhysicsObject* sphere, const PhysicsObject* cuboid, bool flipped)
+{
+	float radius = static_cast<const SphereCollisionShape*>(sphere->GetCollisionShape())->GetRadius();
+	const Vector3& halfDims = static_cast<const CuboidCollisionShape*>(cuboid->GetCollisionShape())->GetHalfDims();
+
+	//Work in the cuboid's local space, where it is just an axis aligned box around the origin
+	const Matrix3& rot = cuboid->GetRotation();
+	Vector3 local = Matrix3::Transpose(rot) * (sphere->GetPosition() - cuboid->GetPosition());
+
+	Vector3 closest = Vector3(
+		min(max(local.x, -halfDims.x), halfDims.x),
+		min(max(local.y, -halfDims.y), halfDims.y),
+		min(max(local.z, -halfDims.z), halfDims.z));
+
+	Vector3 normal;				//Local space, from the cuboid towards the sphere
+	float penetration;
+	Vector3 offset = local - closest;
+	float distSq = Vector3::Dot(offset, offset);
+	if (distSq > 1e-12f)
+	{
+		if (distSq > radius * radius)
+			return false;
+
+		float dist = sqrtf(distSq);
+		normal = offset * (1.0f / dist);
+		penetration = dist - radius;
+	}
+	else
+	{
+		//The centre of the sphere is inside the cuboid, so push it out through the nearest face
+		const float l[3] = { local.x, local.y, local.z };
+		const float h[3] = { halfDims.x, halfDims.y, halfDims.z };
+
+		int axis = 0;
+		for (int i = 1; i < 3; ++i)
+		{
+			if (h[i] - fabs(l[i]) < h[axis] - fabs(l[axis]))
+				axis = i;
+		}
+
+		float n[3] = { 0.0f, 0.0f, 0.0f };
+		float c[3] = { l[0], l[1], l[2] };
+		n[axis] = (l[axis] < 0.0f) ? -1.0f : 1.0f;
+		c[axis] = n[axis] * h[axis];
+
+		normal = Vector3(n[0], n[1], n[2]);
+		closest = Vector3(c[0], c[1], c[2]);
+		penetration = -(h[axis] - fabs(l[axis])) - radius;
+	}
+
+	Vector3 wsNormal = rot * normal;
+	Vector3 onCuboid = cuboid->GetPosition() + rot * closest;
+	Vector3 onSphere = sphere->GetPosition() - wsNormal * radius;
+
+	//The normal always has to point from obj1 to obj2
+	m_ColData._normal = flipped ? wsNormal : -wsNormal;
+	m_ColData._penetration = penetration;
+	m_ColData._pointOnPlane = onCuboid;
+
+	m_ContactOnA = flipped ? onCuboid : onSphere;
+	m_ContactOnB = flipped ? onSphere : onCuboid;
+	return true;
+}
+
+bool CollisionDispatch::CollideCuboidCuboid()
+{
+	const Vector3& halfDims1 = static_cast<const CuboidCollisionShape*>(m_pObj1->GetCollisionShape())->GetHalfDims();
+	const Vector3& halfDims2 = static_cast<const CuboidCollisionShape*>(m_pObj2->GetCollisionShape())->GetHalfDims();
+
+	const WorldSpaceHull& hull1 = m_pObj1->GetWorldSpaceHull();
+	const WorldSpaceHull& hull2 = m_pObj2->GetWorldSpaceHull();
+	const Vector3& pos1 = m_pObj1->GetPosition();
+	const Vector3& pos2 = m_pObj2->GetPosition();
+
+	//Same axes as CollisionDetectionSAT would use (the +X, +Y and +Z face normals of
+	// each cuboid, in the same order), but the extents along them are worked out directly
+	// from the axes rather than by searching the hull's vertices.
+	const Vector3 axes[6] = {
+		hull1.faceNormals[4], hull1.faceNormals[2], hull1.faceNormals[1],
+		hull2.faceNormals[4], hull2.faceNormals[2], hull2.faceNormals[1]
+	};
+
+	int best_axis = -1;
+	bool best_flipped = false;
+	float best_penetration = -FLT_MAX;
+	for (int i = 0; i < 6; ++i)
+	{
+		const Vector3& axis = axes[i];
+
+		float centre1 = Vector3::Dot(axis, pos1);
+		float centre2 = Vector3::Dot(axis, pos2);
+		float extent1 = fabs(Vector3::Dot(axis, axes[0])) * halfDims1.x
+			+ fabs(Vector3::Dot(axis, axes[1])) * halfDims1.y
+			+ fabs(Vector3::Dot(axis, axes[2])) * halfDims1.z;
+		float extent2 = fabs(Vector3::Dot(axis, axes[3])) * halfDims2.x
+			+ fabs(Vector3::Dot(axis, axes[4])) * halfDims2.y
+			+ fabs(Vector3::Dot(axis, axes[5])) * halfDims2.z;
+
+		float min1 = centre1 - extent1, max1 = centre1 + extent1;
+		float min2 = centre2 - extent2, max2 = centre2 + extent2;
+
+		float penetration;
+		bool flipped;
+		if (min1 <= min2 && max1 >= min2)
+		{
+			penetration = min2 - max1;
+			flipped = false;
+		}
+		else if (min2 <= min1 && max2 >= min1)
+		{
+			penetration = min1 - max2;
+			flipped = true;
+		}
+		else
+		{
+			return false;
+		}
+
+		if (penetration >= best_penetration)
+		{
+			best_axis = i;
+			best_flipped = flipped;
+			best_penetration = penetration;
+		}
+	}
+
+	//Furthest corner of obj1 along the collision normal, pushed back onto obj2's
+	// surface to give the point of collision
+	Vector3 normal = best_flipped ? -axes[best_axis] : axes[best_axis];
+	Vector3 corner = pos1;
+	corner = corner + axes[0] * ((Vector3::Dot(normal, axes[0]) < 0.0f) ? -halfDims1.x : halfDims1.x);
+	corner = corner + axes[1] * ((Vector3::Dot(normal, axes[1]) < 0.0f) ? -halfDims1.y : halfDims1.y);
+	corner = corner + axes[2] * ((Vector3::Dot(normal, axes[2]) < 0.0f) ? -halfDims1.z : halfDims1.z);
+
+	m_ColData._normal = normal;
+	m_ColData._penetration = best_penetration;
+	m_ColData._pointOnPlane = corner + normal * best_penetration;
+	return true;
+}
@@ -0,0 +1,71 @@
+/******************************************************************************
+Class: CollisionDispatch
+Description: Picks the narrowphase routine for a pair of objects from a table
+keyed on the types of their collision shapes.
+
+Sphere/sphere and sphere/cuboid collisions are found in closed form (the sphere
+against the closest point on the cuboid, in the cuboid's local space) and write
+their single contact straight into the manifold. Cuboid/cuboid pairs test the
+cuboids' face axes directly from their orientations, and then hand over to
+CollisionDetectionSAT just to clip the contact faces. Any other pair of shapes
+falls back to the generic CollisionDetectionGJK.
+
+Has the same interface as CollisionDetectionSAT, and like it keeps the state of
+the current pair - so each narrowphase thread needs its own.
+******************************************************************************/
+#pragma once
+
+#include "CollisionDetectionSAT.h"
+#include "CollisionDetectionGJK.h"
+
+class CollisionDispatch
+{
+public:
+	CollisionDispatch();
+
+	//Start processing new (possible) collision pair
+	void BeginNewPair(PhysicsObject* obj1, PhysicsObject* obj2);
+
+	//Returns true if the objects are colliding or false otherwise
+	bool AreColliding(CollisionData* out_coldata = NULL);
+
+	//Adds the contact points of the colliding pair to the manifold
+	void GenContactPoints(Manifold* out_manifold);
+
+protected:
+	typedef bool (CollisionDispatch::*CollideFunc)();
+	typedef void (CollisionDispatch::*ContactFunc)(Manifold*);
+
+	struct PairRoutine
+	{
+		CollideFunc	collide;
+		ContactFunc	contacts;
+	};
+
+	//Indexed by the shape types of [obj1][obj2]
+	static const PairRoutine s_Routines[COLLISION_SHAPE_MAX][COLLISION_SHAPE_MAX];
+
+	bool CollideGJK();
+	bool CollideSphereSphere();
+	bool CollideSphereCuboid();
+	bool CollideCuboidSphere();
+	bool CollideCuboidCuboid();
+
+	//Shared by both orderings, 'flipped' if the cuboid is obj1
+	bool CollideSphereCuboid(const PhysicsObject* sphere, const PhysicsObject* cuboid, bool flipped);
+
+	void ContactsGJK(Manifold* out_manifold);
+	void ContactsSingle(Manifold* out_manifold);
+	void ContactsClipped(Manifold* out_manifold);
+
+protected:
+	PhysicsObject*			m_pObj1;
+	PhysicsObject*			m_pObj2;
+	const PairRoutine*		m_pRoutine;
+
+	CollisionDetectionGJK	m_GJK;				//Fallback for anything without its own routine
+	CollisionDetectionSAT	m_SAT;				//Clips the contacts of cuboid pairs
+	CollisionData			m_ColData;
+	Vector3					m_ContactOnA;		//Only used by pairs with a single contact point
+	Vector3					m_ContactOnB;
+};
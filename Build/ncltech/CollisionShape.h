@@ -21,14 +21,69 @@ and a means to calculate collisions with other unknown collision shapes via Coll
 #pragma once
 
 #include "Hull.h"
+#include "BoundingBox.h"
 
 #include <nclgl\Vector3.h>
 #include <nclgl\Plane.h>
 #include <vector>
 #include <list>
+#include <assert.h>
 
 class PhysicsObject;
 
+//Used by CollisionDispatch to pick the collision routine for a pair of shapes
+enum CollisionShapeType
+{
+	COLLISION_SHAPE_GENERIC = 0,	//No dedicated routines, always collided with CollisionDetectionGJK
+	COLLISION_SHAPE_SPHERE,
+	COLLISION_SHAPE_CUBOID,
+	COLLISION_SHAPE_MAX
+};
+
+//A shape's hull transformed into world space for one object. Each object keeps its own,
+// which is only rebuilt when the object has moved or the shape has been resized (see PhysicsObject::GetWorldSpaceHull)
+// so that all of the collision queries below can share it.
+struct WorldSpaceHull
+{
+	std::vector<Vector3>	vertices;		//Same order as the hull's vertices
+	std::vector<Vector3>	faceNormals;	//Same order as the hull's faces
+	std::vector<Plane>		facePlanes;		//Plane of each face, facing into the shape (to clip against)
+};
+
+//Most vertices any one face of a collision shape's hull can have
+#define MAX_HULL_FACE_VERTICES 16
+
+//Fixed size polygon, so that contact points can be generated without touching the heap.
+// Clipping a convex face down to fit inside another convex face can at most give one
+// vertex for each of the edges of the two faces. Shapes must keep their faces within
+// MAX_HULL_FACE_VERTICES, anything past the end would be lost (and asserts in debug builds).
+struct ContactPolygon
+{
+	ContactPolygon() : count(0) {}
+
+	void Clear()						{ count = 0; }
+	void Add(const Vector3& v)			{ assert(count < MAX_POLYGON_VERTICES); if (count < MAX_POLYGON_VERTICES) vertices[count++] = v; }
+
+	enum { MAX_POLYGON_VERTICES = MAX_HULL_FACE_VERTICES * 2 };
+
+	int		count;
+	Vector3	vertices[MAX_POLYGON_VERTICES];
+};
+
+//The planes around a face to clip against - one for each edge, plus the face itself
+struct ContactClipPlanes
+{
+	ContactClipPlanes() : count(0) {}
+
+	void Clear()						{ count = 0; }
+	void Add(const Plane& p)			{ assert(count < MAX_CLIP_PLANES); if (count < MAX_CLIP_PLANES) planes[count++] = p; }
+
+	enum { MAX_CLIP_PLANES = MAX_HULL_FACE_VERTICES + 1 };
+
+	int		count;
+	Plane	planes[MAX_CLIP_PLANES];
+};
+
 struct CollisionEdge
 {
 	CollisionEdge(const Vector3& a, const Vector3& b) 
@@ -41,9 +96,16 @@ struct CollisionEdge
 class CollisionShape
 {
 public:
-	CollisionShape()	{}
+	CollisionShape() : m_Type(COLLISION_SHAPE_GENERIC), m_Version(0)	{}
+	CollisionShape(CollisionShapeType type) : m_Type(type), m_Version(0)	{}
 	virtual ~CollisionShape()	{}
 
+	CollisionShapeType GetType() const { return m_Type; }
+
+	// Bumped whenever the shape's dimensions are changed, so that the objects using it
+	//   know their cached world space hull (and broadphase bounds) are out of date
+	unsigned int GetVersion() const { return m_Version; }
+
 	// Constructs an inverse inertia matrix of the given collision volume. This is the equivilant of the inverse mass of an object for rotation,
 	//   a good source for non-inverse inertia matricies can be found here: https://en.wikipedia.org/wiki/List_of_moments_of_inertia
 	virtual Matrix3 BuildInverseInertia(float invMass) const = 0;
@@ -51,9 +113,27 @@ public:
 	// Draws this collision shape to the debug renderer
 	virtual void DebugDraw(const PhysicsObject* currentObject) const = 0;
 
+	// Computes the tightest world-space axis aligned bounding box that fully encloses the shape.
+	//  - Used by the broadphase to quickly cull pairs of objects that can't possibly be colliding
+	virtual void GetWorldSpaceAABB(const PhysicsObject* currentObject, BoundingBox* out_aabb) const = 0;
+
+	// Transforms the shape's hull into world space for the given object
+	//  - Shapes without a hull (e.g. spheres) just leave it empty
+	virtual void BuildWorldSpaceHull(const PhysicsObject* currentObject, WorldSpaceHull* out_hull) const {}
+
 
 
 //<----- USED BY COLLISION DETECTION ----->
+	// Get the furthest point of the shape along a given (world space) axis
+	//  - Used by CollisionDetectionGJK. Rounded shapes give the furthest point of their 'core'
+	//    and the radius swept around that core as their margin, e.g. a sphere is just its
+	//    centre point with a margin of its radius.
+	virtual Vector3 GetSupportPoint(
+		const PhysicsObject* currentObject,
+		const Vector3& axis) const = 0;
+
+	virtual float GetSupportMargin() const { return 0.0f; }
+
 	// Get all possible collision axes
 	//	- This is a list of all the face normals ignoring any duplicates and parallel vectors.
 	virtual void GetCollisionAxes(
@@ -81,8 +161,14 @@ public:
 	//    of all adjacent faces in order to clip against.
 	virtual void GetIncidentReferencePolygon(const PhysicsObject* currentObject,
 		const Vector3& axis,
-		std::list<Vector3>* out_face,
+		ContactPolygon* out_face,
 		Vector3* out_normal,
-		std::vector<Plane>* out_adjacent_planes) const = 0;
+		ContactClipPlanes* out_adjacent_planes) const = 0;
+
+protected:
+	void MarkChanged() { ++m_Version; }
 
+protected:
+	CollisionShapeType m_Type;
+	unsigned int m_Version;
 };
\ No newline at end of file
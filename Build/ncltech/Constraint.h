@@ -33,6 +33,7 @@ which you may want to implement yourselves.
 *//////////////////////////////////////////////////////////////////////////////
 #pragma once
 #include "PhysicsObject.h"
+#include "VelocityDelta.h"
 #include <nclgl\Vector3.h>
 
 class Constraint
@@ -44,6 +45,13 @@ public:
 	// Apply Velocity Impulse to object(s) in order to satisfy given constraint
 	//  - Called by PhysicsEngine upon resolving constraints
 	virtual void ApplyImpulse() = 0;
+
+
+	// Optional: Same as above, but returns the size of the impulse applied - the solver
+	//			 stops iterating once this (and the contacts' change in impulse) gets small enough
+	//  - By default the constraint never holds the solver back, so it is only iterated for as
+	//    long as the rest of its island needs (and at least the minimum number of iterations)
+	virtual float ApplyImpulseResidual() { ApplyImpulse(); return 0.0f; }
 	
 
 	// Optional: Pre-solver step will be triggered before any calls to ApplyImpulse
@@ -53,6 +61,22 @@ public:
 	virtual void PreSolverStep(float dt) {}
 
 
+	// Optional: Objects the constraint acts upon
+	//  - Used by the PhysicsEngine to group connected objects into islands
+	//  - If both are left as NULL the constraint could be acting on anything, so every
+	//    dynamic object is put in one shared island that is solved on a single thread
+	virtual PhysicsObject* GetObjectA() const { return NULL; }
+	virtual PhysicsObject* GetObjectB() const { return NULL; }
+
+
+	// Where the impulses go - constraints should apply their impulses through
+	//  this, so that they can be accumulated by the jacobi solver
+	VelocityDelta& GetVelocityDelta() { return m_VelocityDelta; }
+
+
 	// Visually Debug Constraint 
 	virtual void DebugDraw() const {}
+
+protected:
+	VelocityDelta m_VelocityDelta;
 };
\ No newline at end of file
@@ -0,0 +1,145 @@
+/******************************************************************************
+Class: ConstraintPool
+Description: Contiguous storage for every constraint of one type (e.g. all of the
+distance constraints), so that the solver can run through them in a tight loop
+without chasing pointers or making virtual calls.
+
+Constraints are copied into the pool when added, and are referred to from
+outside through a ConstraintHandle. Removing a constraint moves the last one in
+the pool into its place, so the handle goes through a table of slots that
+always knows where each constraint currently is. Every slot has a generation
+that is bumped when its constraint is removed, so a handle to a constraint
+that has since been removed is never mistaken for whatever reuses its slot.
+******************************************************************************/
+#pragma once
+
+#include <vector>
+#include <stdint.h>
+
+//Which pool a handle belongs to
+enum ConstraintType
+{
+	CONSTRAINT_DISTANCE = 0,
+	CONSTRAINT_BALLSOCKET,
+	CONSTRAINT_HINGE,
+	CONSTRAINT_SLIDER,
+	CONSTRAINT_MAX
+};
+
+struct ConstraintHandle
+{
+	ConstraintHandle() : type(CONSTRAINT_MAX), slot(0), generation(0) {}
+	ConstraintHandle(ConstraintType t, uint32_t s, uint32_t g) : type(t), slot(s), generation(g) {}
+
+	bool IsValid() const { return type != CONSTRAINT_MAX; }		//Could still have been removed since
+
+	ConstraintType	type;
+	uint32_t		slot;
+	uint32_t		generation;
+};
+
+template <class T>
+class ConstraintPool
+{
+public:
+	ConstraintPool(ConstraintType type) : m_Type(type) {}
+
+	ConstraintType GetType() const				{ return m_Type; }
+
+	ConstraintHandle Add(const T& constraint)
+	{
+		uint32_t slot;
+		if (!m_FreeSlots.empty())
+		{
+			slot = m_FreeSlots.back();
+			m_FreeSlots.pop_back();
+		}
+		else
+		{
+			slot = (uint32_t)m_Slots.size();
+			m_Slots.push_back(Slot());
+			m_Slots.back().generation = 0;
+		}
+
+		m_Slots[slot].index = (int)m_Constraints.size();
+		m_Constraints.push_back(constraint);
+		m_IndexSlots.push_back(slot);
+
+		return ConstraintHandle(m_Type, slot, m_Slots[slot].generation);
+	}
+
+	//Returns false if the handle doesn't refer to a constraint in this pool (any more)
+	bool Remove(const ConstraintHandle& handle)
+	{
+		int idx = GetIndex(handle);
+		if (idx < 0)
+			return false;
+
+		//Move the last constraint into the gap, and point its slot at the new location
+		int last = (int)m_Constraints.size() - 1;
+		if (idx != last)
+		{
+			m_Constraints[idx] = m_Constraints[last];
+			m_IndexSlots[idx] = m_IndexSlots[last];
+			m_Slots[m_IndexSlots[idx]].index = idx;
+		}
+		m_Constraints.pop_back();
+		m_IndexSlots.pop_back();
+
+		m_Slots[handle.slot].generation++;
+		m_FreeSlots.push_back(handle.slot);
+		return true;
+	}
+
+	void Clear()
+	{
+		//Every slot is freed, but keeps its generation so old handles stay invalid
+		m_FreeSlots.clear();
+		for (uint32_t i = 0; i < (uint32_t)m_Slots.size(); ++i)
+		{
+			m_Slots[i].generation++;
+			m_FreeSlots.push_back(i);
+		}
+
+		m_Constraints.clear();
+		m_IndexSlots.clear();
+	}
+
+	//Position of the constraint in the pool, or -1 if the handle is no longer valid. Only
+	// stays the same until a constraint is removed.
+	int GetIndex(const ConstraintHandle& handle) const
+	{
+		if (handle.type != m_Type || handle.slot >= (uint32_t)m_Slots.size())
+			return -1;
+
+		const Slot& s = m_Slots[handle.slot];
+		return (s.generation == handle.generation) ? s.index : -1;
+	}
+
+	//Pointer is only valid until the next constraint is added/removed
+	T* Get(const ConstraintHandle& handle)
+	{
+		int idx = GetIndex(handle);
+		return (idx >= 0) ? &m_Constraints[idx] : NULL;
+	}
+
+	int Size() const							{ return (int)m_Constraints.size(); }
+	T& operator[](int idx)						{ return m_Constraints[idx]; }
+	const T& operator[](int idx) const			{ return m_Constraints[idx]; }
+
+	typename std::vector<T>::iterator begin()	{ return m_Constraints.begin(); }
+	typename std::vector<T>::iterator end()		{ return m_Constraints.end(); }
+
+protected:
+	struct Slot
+	{
+		int			index;			//Where the constraint is in m_Constraints
+		uint32_t	generation;
+	};
+
+	ConstraintType			m_Type;
+	std::vector<T>			m_Constraints;
+	std::vector<uint32_t>	m_IndexSlots;		//Slot of each constraint, to update when it is moved
+	std::vector<Slot>		m_Slots;
+	std::vector<uint32_t>	m_FreeSlots;
+};
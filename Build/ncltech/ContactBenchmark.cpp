@@ -0,0 +1,135 @@
+#include "ContactBenchmark.h"
+#include "CollisionDetectionSAT.h"
+#include "CollisionDispatch.h"
+#include "CuboidCollisionShape.h"
+#include <nclgl\GameTimer.h>
+#include <vector>
+#include <cstdlib>
+#include <cstdio>
+
+#define BENCHMARK_NUM_PAIRS 256
+
+//The debug CRT can report every heap allocation as it happens
+#if defined(_MSC_VER) && defined(_DEBUG)
+#include <crtdbg.h>
+#define BENCHMARK_COUNT_ALLOCATIONS
+
+static long s_NumAllocations = 0;
+
+static int __cdecl CountAllocations(int allocType, void* userData, size_t size, int blockType,
+	long requestNumber, const unsigned char* filename, int lineNumber)
+{
+	if (allocType == _HOOK_ALLOC || allocType == _HOOK_REALLOC)
+		++s_NumAllocations;
+	return TRUE;
+}
+#endif
+
+static float RandomFloat()
+{
+	return (rand() / (float)RAND_MAX) * 2.0f - 1.0f;
+}
+
+//Generates the contacts of every pair 'repeats' times. Each detector must have
+// already found its pair (objects [i*2] and [i*2+1]) to be colliding.
+template <typename Detector>
+static void TimeContacts(std::ostream& out, const char* name, std::vector<Detector>& detectors,
+	const std::vector<PhysicsObject*>& objects, unsigned int repeats)
+{
+	std::vector<Manifold> manifolds(detectors.size());
+
+	//Two untimed passes first, so that both of each manifold's contact lists (this
+	// frame's and last frame's, which swap every Initiate) have already been allocated
+	for (int pass = 0; pass < 2; ++pass)
+	{
+		for (size_t i = 0; i < detectors.size(); ++i)
+		{
+			manifolds[i].Initiate(objects[i * 2], objects[i * 2 + 1]);
+			detectors[i].GenContactPoints(&manifolds[i]);
+		}
+	}
+
+#ifdef BENCHMARK_COUNT_ALLOCATIONS
+	s_NumAllocations = 0;
+	_CRT_ALLOC_HOOK prev_hook = _CrtSetAllocHook(CountAllocations);
+#endif
+
+	GameTimer timer;
+	size_t num_contacts = 0;
+	for (unsigned int r = 0; r < repeats; ++r)
+	{
+		for (size_t i = 0; i < detectors.size(); ++i)
+		{
+			manifolds[i].Initiate(objects[i * 2], objects[i * 2 + 1]);
+			detectors[i].GenContactPoints(&manifolds[i]);
+			num_contacts += manifolds[i].GetNumContacts();
+		}
+	}
+	float ms = timer.GetMS();
+
+	char allocations[32];
+#ifdef BENCHMARK_COUNT_ALLOCATIONS
+	_CrtSetAllocHook(prev_hook);
+	snprintf(allocations, sizeof(allocations), "%ld", s_NumAllocations);
+#else
+	snprintf(allocations, sizeof(allocations), "n/a (debug only)");
+#endif
+
+	char line[256];
+	snprintf(line, sizeof(line), "    %-24s %10.2f %10.2f %s",
+		name, ms, num_contacts / (float)(repeats * detectors.size()), allocations);
+	out << line << std::endl;
+}
+
+void ContactBenchmark::Run(std::ostream& out, unsigned int repeats)
+{
+	//Pairs of cuboids resting on top of one another, each slightly rotated so that
+	// the incident face has to be clipped against the sides of the reference face
+	std::vector<PhysicsObject*> objects;
+	srand(12345);
+	for (unsigned int i = 0; i < BENCHMARK_NUM_PAIRS; ++i)
+	{
+		Vector3 base = Vector3(i * 4.0f, 0.0f, 0.0f);
+
+		PhysicsObject* lower = new PhysicsObject();
+		lower->SetCollisionShape(new CuboidCollisionShape(Vector3(0.5f, 0.5f, 0.5f)));
+		lower->SetPosition(base);
+
+		PhysicsObject* upper = new PhysicsObject();
+		upper->SetCollisionShape(new CuboidCollisionShape(Vector3(0.5f, 0.25f, 0.5f)));
+		upper->SetPosition(base + Vector3(RandomFloat() * 0.3f, 0.74f, RandomFloat() * 0.3f));
+		upper->SetOrientation(Quaternion::EulerAnglesToQuaternion(RandomFloat() * 3.0f, RandomFloat() * 45.0f, RandomFloat() * 3.0f));
+
+		objects.push_back(lower);
+		objects.push_back(upper);
+	}
+
+	std::vector<CollisionDetectionSAT> sat(BENCHMARK_NUM_PAIRS);
+	std::vector<CollisionDispatch> dispatch(BENCHMARK_NUM_PAIRS);
+	unsigned int num_colliding = 0;
+	for (unsigned int i = 0; i < BENCHMARK_NUM_PAIRS; ++i)
+	{
+		PhysicsObject* objA = objects[i * 2];
+		PhysicsObject* objB = objects[i * 2 + 1];
+
+		sat[i].BeginNewPair(objA, objB, objA->GetCollisionShape(), objB->GetCollisionShape());
+		bool sat_colliding = sat[i].AreColliding();
+
+		dispatch[i].BeginNewPair(objA, objB);
+		bool dispatch_colliding = dispatch[i].AreColliding();
+
+		if (sat_colliding && dispatch_colliding)
+			++num_colliding;
+	}
+
+	out << "Contact generation benchmark, " << repeats << " x " << BENCHMARK_NUM_PAIRS << " cuboid pairs ("
+		<< num_colliding << " colliding)" << std::endl;
+	out << "    Detector                   Time(ms)   Contacts   Heap allocations" << std::endl;
+	TimeContacts(out, "CollisionDetectionSAT", sat, objects, repeats);
+	TimeContacts(out, "CollisionDispatch", dispatch, objects, repeats);
+
+	for (PhysicsObject* obj : objects)
+	{
+		delete obj;
+	}
+}
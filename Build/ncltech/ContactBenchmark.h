@@ -0,0 +1,23 @@
+/******************************************************************************
+Class: ContactBenchmark
+Description: Times contact generation (clipping the incident face of one
+cuboid against the reference face of another) over a set of resting and
+slightly rotated cuboid pairs, through both CollisionDetectionSAT and
+CollisionDispatch.
+
+Contact generation shouldn't touch the heap at all once a manifold has been
+used once. In debug builds with the MSVC runtime every heap allocation made
+while generating contacts is counted and printed alongside the times, which
+should always come out as 0.
+******************************************************************************/
+#pragma once
+
+#include <iostream>
+
+class ContactBenchmark
+{
+public:
+	//Generates the contacts of every pair 'repeats' times, and prints the time
+	// taken (in ms), the number of contacts and the heap allocations to 'out'
+	static void Run(std::ostream& out, unsigned int repeats = 1000);
+};
@@ -3,9 +3,12 @@
 #include <nclgl/Matrix3.h>
 #include <nclgl/OGLRenderer.h>
 
+#define CUBOID_NUM_VERTICES 8
+
 Hull CuboidCollisionShape::m_CubeHull = Hull();
 
 CuboidCollisionShape::CuboidCollisionShape()
+	: CollisionShape(COLLISION_SHAPE_CUBOID)
 {
 	m_CuboidHalfDimensions = Vector3(0.5f, 0.5f, 0.5f);
 
@@ -16,6 +19,7 @@ CuboidCollisionShape::CuboidCollisionShape()
 }
 
 CuboidCollisionShape::CuboidCollisionShape(const Vector3& halfdims)
+	: CollisionShape(COLLISION_SHAPE_CUBOID)
 {
 	m_CuboidHalfDimensions = halfdims;
 
@@ -44,14 +48,60 @@ Matrix3 CuboidCollisionShape::BuildInverseInertia(float invMass) const
 	return inertia;
 }
 
+void CuboidCollisionShape::GetWorldSpaceAABB(const PhysicsObject* currentObject, BoundingBox* out_aabb) const
+{
+	// The world-space half extents of a rotated box are the sum of each of its
+	// (scaled) local axes projected onto the world axes.
+	const Matrix3& rot = currentObject->GetRotation();
+	const Vector3& h = m_CuboidHalfDimensions;
+
+	Vector3 extents = Vector3(
+		fabs(rot(0, 0)) * h.x + fabs(rot(0, 1)) * h.y + fabs(rot(0, 2)) * h.z,
+		fabs(rot(1, 0)) * h.x + fabs(rot(1, 1)) * h.y + fabs(rot(1, 2)) * h.z,
+		fabs(rot(2, 0)) * h.x + fabs(rot(2, 1)) * h.y + fabs(rot(2, 2)) * h.z);
+
+	out_aabb->_min = currentObject->GetPosition() - extents;
+	out_aabb->_max = currentObject->GetPosition() + extents;
+}
+
+void CuboidCollisionShape::BuildWorldSpaceHull(const PhysicsObject* currentObject, WorldSpaceHull* out_hull) const
+{
+	const Matrix4& objTransform = currentObject->GetWorldSpaceTransform();
+	Matrix4 wsTransform = objTransform * Matrix4::Scale(m_CuboidHalfDimensions);
+
+	//Only allocates the first time, after that the arrays are just overwritten
+	out_hull->vertices.resize(CUBOID_NUM_VERTICES);
+	out_hull->faceNormals.resize(m_CubeHull.GetNumFaces());
+	out_hull->facePlanes.resize(m_CubeHull.GetNumFaces());
+
+	wsTransform.TransformPoints(m_CubeHull.GetVertexPositions(), &out_hull->vertices[0], CUBOID_NUM_VERTICES);
+
+	//The unit cube's planes are scaled by the half dimensions too, so they are transformed by the
+	// normal matrix of rotation * scale - the rotation with each column divided by the half dimension along it
+	const Vector3& h = m_CuboidHalfDimensions;
+	Matrix3 rot = Matrix3(objTransform);
+	Matrix3 normalMatrix = Matrix3(
+		Vector3(rot(0, 0), rot(1, 0), rot(2, 0)) * (1.0f / h.x),
+		Vector3(rot(0, 1), rot(1, 1), rot(2, 1)) * (1.0f / h.y),
+		Vector3(rot(0, 2), rot(1, 2), rot(2, 2)) * (1.0f / h.z));
+	Plane::TransformPlanes(normalMatrix, objTransform.GetPositionVector(),
+		m_CubeHull.GetFacePlanes(), &out_hull->facePlanes[0], m_CubeHull.GetNumFaces());
+
+	for (unsigned int i = 0; i < m_CubeHull.GetNumFaces(); ++i)
+	{
+		out_hull->faceNormals[i] = -out_hull->facePlanes[i].GetNormal();
+	}
+}
+
 void CuboidCollisionShape::GetCollisionAxes(const PhysicsObject* currentObject, std::vector<Vector3>* out_axes) const
 {
 	if (out_axes)
 	{
-		Matrix3 objOrientation = currentObject->GetOrientation().ToMatrix3();
-		out_axes->push_back(objOrientation * Vector3(1.0f, 0.0f, 0.0f)); //X - Axis
-		out_axes->push_back(objOrientation * Vector3(0.0f, 1.0f, 0.0f)); //Y - Axis
-		out_axes->push_back(objOrientation * Vector3(0.0f, 0.0f, 1.0f)); //Z - Axis
+		//Normals of the +X, +Y and +Z faces, as ordered in ConstructCubeHull
+		const WorldSpaceHull& hull = currentObject->GetWorldSpaceHull();
+		out_axes->push_back(hull.faceNormals[4]); //X - Axis
+		out_axes->push_back(hull.faceNormals[2]); //Y - Axis
+		out_axes->push_back(hull.faceNormals[1]); //Z - Axis
 	}
 }
 
@@ -59,39 +109,38 @@ void CuboidCollisionShape::GetEdges(const PhysicsObject* currentObject, std::vec
 {
 	if (out_edges)
 	{
-		Matrix4 transform = currentObject->GetWorldSpaceTransform() * Matrix4::Scale(Vector3(m_CuboidHalfDimensions));
+		const WorldSpaceHull& hull = currentObject->GetWorldSpaceHull();
 		for (unsigned int i = 0; i < m_CubeHull.GetNumEdges(); ++i)
 		{
 			const HullEdge& edge = m_CubeHull.GetEdge(i);
-			Vector3 A = transform * m_CubeHull.GetVertex(edge.vStart).pos;
-			Vector3 B = transform * m_CubeHull.GetVertex(edge.vEnd).pos;
-
-			out_edges->push_back(CollisionEdge(A, B));
+			out_edges->push_back(CollisionEdge(hull.vertices[edge.vStart], hull.vertices[edge.vEnd]));
 		}
 	}
 }
 
+Vector3 CuboidCollisionShape::GetSupportPoint(const PhysicsObject* currentObject, const Vector3& axis) const
+{
+	const WorldSpaceHull& hull = currentObject->GetWorldSpaceHull();
+
+	int vMax;
+	GetMinMaxVerticesInAxis(hull, axis, NULL, &vMax);
+	return hull.vertices[vMax];
+}
+
 void CuboidCollisionShape::GetMinMaxVertexOnAxis(
 	const PhysicsObject* currentObject,
 	const Vector3& axis,
 	Vector3* out_min,
 	Vector3* out_max) const
 {
-	// Build World Transform
-	Matrix4 wsTransform = currentObject->GetWorldSpaceTransform() * Matrix4::Scale(m_CuboidHalfDimensions);
-
-	// Convert world space axis into model space (Axis Aligned Cuboid)
-	Matrix3 invNormalMatrix = Matrix3::Transpose(Matrix3(wsTransform));
-	Vector3 local_axis = invNormalMatrix * axis;
-	local_axis.Normalise();
+	const WorldSpaceHull& hull = currentObject->GetWorldSpaceHull();
 
 	// Get closest and furthest vertex id's
 	int vMin, vMax;
-	m_CubeHull.GetMinMaxVerticesInAxis(local_axis, &vMin, &vMax);
+	GetMinMaxVerticesInAxis(hull, axis, &vMin, &vMax);
 
-	// Return closest and furthest vertices in world-space
-	if (out_min) *out_min = wsTransform * m_CubeHull.GetVertex(vMin).pos;
-	if (out_max) *out_max = wsTransform * m_CubeHull.GetVertex(vMax).pos;
+	if (out_min) *out_min = hull.vertices[vMin];
+	if (out_max) *out_max = hull.vertices[vMax];
 }
 
 
@@ -99,40 +148,30 @@ void CuboidCollisionShape::GetMinMaxVertexOnAxis(
 void CuboidCollisionShape::GetIncidentReferencePolygon(
 	const PhysicsObject* currentObject,
 	const Vector3& axis,
-	std::list<Vector3>* out_face,
+	ContactPolygon* out_face,
 	Vector3* out_normal,
-	std::vector<Plane>* out_adjacent_planes) const
+	ContactClipPlanes* out_adjacent_planes) const
 {
-	//Get the world-space transform
-	Matrix4 wsTransform = currentObject->GetWorldSpaceTransform() * Matrix4::Scale(m_CuboidHalfDimensions);
-
-	//Get normal and inverse-normal matrices to transfom the collision axis to and from modelspace
-	Matrix3 invNormalMatrix = Matrix3::Transpose(Matrix3(wsTransform));
-	Matrix3 normalMatrix = Matrix3::Inverse(invNormalMatrix);
-	
-
-	Vector3 local_axis = invNormalMatrix * axis;
-
+	//Everything below is already in world-space
+	const WorldSpaceHull& hull = currentObject->GetWorldSpaceHull();
 
 	//Get the furthest vertex along axis - this will be part of the further face
 	int undefined, maxVertex;
-	m_CubeHull.GetMinMaxVerticesInAxis(local_axis, &undefined, &maxVertex);
-	const HullVertex& vert = m_CubeHull.GetVertex(maxVertex);
+	GetMinMaxVerticesInAxis(hull, axis, &undefined, &maxVertex);
 
 
 	//Compute which face (that contains the furthest vertex above)
 	// is the furthest along the given axis. This is defined by
 	// it's normal being closest to parallel with the collision axis.
-	const HullFace* best_face = 0;
+	int best_face = 0;
 	float best_correlation = -FLT_MAX;
-	for (int faceIdx : vert.enclosing_faces)
+	for (int faceIdx : m_CubeHull.GetVertexFaces(maxVertex))
 	{
-		const HullFace* face = &m_CubeHull.GetFace(faceIdx);
-		float temp_correlation = Vector3::Dot(local_axis, face->_normal);
+		float temp_correlation = Vector3::Dot(axis, hull.faceNormals[faceIdx]);
 		if (temp_correlation > best_correlation)
 		{
 			best_correlation = temp_correlation;
-			best_face = face;
+			best_face = faceIdx;
 		}
 	}
 
@@ -140,17 +179,15 @@ void CuboidCollisionShape::GetIncidentReferencePolygon(
 	// Output face normal
 	if (out_normal)
 	{
-		*out_normal = normalMatrix * best_face->_normal;
-		(*out_normal).Normalise();
+		*out_normal = hull.faceNormals[best_face];
 	}
 
-	// Output face vertices (transformed back into world-space)
+	// Output face vertices
 	if (out_face)
 	{
-		for (int vertIdx : best_face->vert_ids)
+		for (int vertIdx : m_CubeHull.GetFaceVertices(best_face))
 		{
-			const HullVertex& vert = m_CubeHull.GetVertex(vertIdx);
-			out_face->push_back(wsTransform * vert.pos);
+			out_face->Add(hull.vertices[vertIdx]);
 		}
 	}
 
@@ -160,47 +197,53 @@ void CuboidCollisionShape::GetIncidentReferencePolygon(
 	// adjacent faces along with the reference face itself.
 	if (out_adjacent_planes)
 	{
-		Vector3 wsPointOnPlane = wsTransform * m_CubeHull.GetVertex(m_CubeHull.GetEdge(best_face->edge_ids[0]).vStart).pos;
-
-		// First, form a plane around the reference face
-		{
-			//We use the negated normal here for the plane, as we want to clip geometry left outside the shape not inside it.
-			Vector3 planeNrml = -(normalMatrix * best_face->_normal);	
-			planeNrml.Normalise();
-
-			float planeDist = -Vector3::Dot(planeNrml, wsPointOnPlane);
-			out_adjacent_planes->push_back(Plane(planeNrml, planeDist));
-		}
+		// First, the plane around the reference face
+		out_adjacent_planes->Add(hull.facePlanes[best_face]);
 		
-		// Now we need to loop over all adjacent faces, and form a similar
-		// clip plane around those too.
+		// Now we need to loop over all adjacent faces, and add their planes too.
 		// - The way that the HULL object is constructed means each edge can only
 		//   ever have two adjoining faces. This means we can iterate through all
-		//   edges of the face and then build a plane around the other face that
-		//   also shares that edge.
-		for (int edgeIdx : best_face->edge_ids)
+		//   edges of the face and then take the other face that also shares that edge.
+		for (int edgeIdx : m_CubeHull.GetFaceEdges(best_face))
 		{
-			const HullEdge& edge = m_CubeHull.GetEdge(edgeIdx);
-
-			wsPointOnPlane = wsTransform * m_CubeHull.GetVertex(edge.vStart).pos;
-
-			for (int adjFaceIdx : edge.enclosing_faces)
+			for (int adjFaceIdx : m_CubeHull.GetEdgeFaces(edgeIdx))
 			{
-				if (adjFaceIdx != best_face->idx)
+				if (adjFaceIdx != best_face)
 				{
-					const HullFace& adjFace = m_CubeHull.GetFace(adjFaceIdx);
-
-					Vector3 planeNrml = -(normalMatrix * adjFace._normal);
-					planeNrml.Normalise();
-					float planeDist = -Vector3::Dot(planeNrml, wsPointOnPlane);
-
-					out_adjacent_planes->push_back(Plane(planeNrml, planeDist));
+					out_adjacent_planes->Add(hull.facePlanes[adjFaceIdx]);
 				}
 			}	
 		}
 	}
 }
 
+void CuboidCollisionShape::GetMinMaxVerticesInAxis(const WorldSpaceHull& hull, const Vector3& axis, int* out_min_vert, int* out_max_vert)
+{
+	//Same as Hull::GetMinMaxVerticesInAxis, only on the world-space vertices
+	float minCorrelation = FLT_MAX, maxCorrelation = -FLT_MAX;
+	int minVertex = 0, maxVertex = 0;
+
+	for (int i = 0; i < CUBOID_NUM_VERTICES; ++i)
+	{
+		float cCorrelation = Vector3::Dot(axis, hull.vertices[i]);
+
+		if (cCorrelation > maxCorrelation)
+		{
+			maxCorrelation = cCorrelation;
+			maxVertex = i;
+		}
+
+		if (cCorrelation <= minCorrelation)
+		{
+			minCorrelation = cCorrelation;
+			minVertex = i;
+		}
+	}
+
+	if (out_min_vert) *out_min_vert = minVertex;
+	if (out_max_vert) *out_max_vert = maxVertex;
+}
+
 
 void CuboidCollisionShape::DebugDraw(const PhysicsObject* currentObject) const
 {
@@ -237,4 +280,6 @@ void CuboidCollisionShape::ConstructCubeHull()
 	m_CubeHull.AddFace(Vector3(0.0f, -1.0f, 0.0f), 4, face4);
 	m_CubeHull.AddFace(Vector3(1.0f, 0.0f, 0.0f), 4, face5);
 	m_CubeHull.AddFace(Vector3(-1.0f, 0.0f, 0.0f), 4, face6);
+
+	m_CubeHull.Finalize();
 }
\ No newline at end of file
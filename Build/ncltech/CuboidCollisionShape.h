@@ -33,9 +33,10 @@ public:
 	virtual ~CuboidCollisionShape();
 
 	// Set Cuboid Dimensions
-	void SetHalfWidth(float half_width) { m_CuboidHalfDimensions.x = fabs(half_width); }
-	void SetHalfHeight(float half_height) { m_CuboidHalfDimensions.y = fabs(half_height); }
-	void SetHalfDepth(float half_depth) { m_CuboidHalfDimensions.z = fabs(half_depth); }
+	void SetHalfWidth(float half_width) { m_CuboidHalfDimensions.x = fabs(half_width); MarkChanged(); }
+	void SetHalfHeight(float half_height) { m_CuboidHalfDimensions.y = fabs(half_height); MarkChanged(); }
+	void SetHalfDepth(float half_depth) { m_CuboidHalfDimensions.z = fabs(half_depth); MarkChanged(); }
+	void SetHalfDims(const Vector3& half_dims) { m_CuboidHalfDimensions = Vector3(fabs(half_dims.x), fabs(half_dims.y), fabs(half_dims.z)); MarkChanged(); }
 
 	// Get Cuboid Dimensions
 	const Vector3& GetHalfDims() const { return m_CuboidHalfDimensions; }
@@ -50,6 +51,17 @@ public:
 	// Build Inertia Matrix for rotational mass
 	virtual Matrix3 BuildInverseInertia(float invMass) const override;
 
+	// Cube hull scaled by the half dimensions and moved into world-space
+	virtual void BuildWorldSpaceHull(const PhysicsObject* currentObject, WorldSpaceHull* out_hull) const override;
+
+	// World-space bounding box used by the broadphase
+	virtual void GetWorldSpaceAABB(const PhysicsObject* currentObject, BoundingBox* out_aabb) const override;
+
+
+	// Support function used by CollisionDetectionGJK
+	virtual Vector3 GetSupportPoint(
+		const PhysicsObject* currentObject,
+		const Vector3& axis) const override;
 
 	// Generic Collision Detection Routines
 	//  - Used in CollisionDetectionSAT to identify if two shapes overlap
@@ -70,9 +82,9 @@ public:
 	virtual void GetIncidentReferencePolygon(
 		const PhysicsObject* currentObject,
 		const Vector3& axis,
-		std::list<Vector3>* out_face,
+		ContactPolygon* out_face,
 		Vector3* out_normal,
-		std::vector<Plane>* out_adjacent_planes) const override;
+		ContactClipPlanes* out_adjacent_planes) const override;
 
 
 
@@ -80,6 +92,9 @@ protected:
 	//Constructs the static cube hull 
 	static void ConstructCubeHull();
 
+	//Closest and furthest of the world-space vertices along a world-space axis
+	static void GetMinMaxVerticesInAxis(const WorldSpaceHull& hull, const Vector3& axis, int* out_min_vert, int* out_max_vert);
+
 protected:
 	Vector3				 m_CuboidHalfDimensions;
 	static Hull			 m_CubeHull;			//Static cube descriptor, as all cuboid instances will have the same underlying model format
@@ -22,10 +22,11 @@ the two objects never changes.
 #pragma once
 
 #include "Constraint.h"
+#include "JacobianRow.h"
 #include "NCLDebug.h"
-#include "PhysicsEngine.h"
 
-class DistanceConstraint : public Constraint
+//Final, so that the PhysicsEngine's pool of distance constraints can call it without going through the vtable
+class DistanceConstraint final : public Constraint
 {
 public:
 	DistanceConstraint(PhysicsObject* obj1, PhysicsObject* obj2,
@@ -33,62 +34,98 @@ public:
 	{
 		m_pObj1 = obj1;
 		m_pObj2 = obj2;
+		m_Bias = 0.0f;
+		m_PositionError = 0.0f;
+		m_Row.effectiveMass = 0.0f;
 
 		Vector3 ab = globalOnB - globalOnA;
 		m_Distance = ab.Length();
 
 		Vector3 r1 = (globalOnA - m_pObj1->GetPosition());
 		Vector3 r2 = (globalOnB - m_pObj2->GetPosition());
-		m_LocalOnA = Matrix3::Transpose(m_pObj1->GetOrientation().ToMatrix3()) * r1;
-		m_LocalOnB = Matrix3::Transpose(m_pObj2->GetOrientation().ToMatrix3()) * r2;
+		m_LocalOnA = Matrix3::Transpose(m_pObj1->GetRotation()) * r1;
+		m_LocalOnB = Matrix3::Transpose(m_pObj2->GetRotation()) * r2;
 	}
 
-	virtual void ApplyImpulse() override
+	virtual void PreSolverStep(float dt) override
 	{
-		/* TUT 3 */
-		if (m_pObj1->GetInverseMass () + m_pObj2->GetInverseMass () == 0.0f)
-			return;
+		PreSolverStep(dt, true);
+	}
 
-		Vector3 r1 = m_pObj1->GetOrientation ().ToMatrix3 () * m_LocalOnA;
-		Vector3 r2 = m_pObj2->GetOrientation ().ToMatrix3 () * m_LocalOnB;
+	//If velocity_baumgarte is false, any drift is left for the position correction pass to fix
+	void PreSolverStep(float dt, bool velocity_baumgarte)
+	{
+		//The anchors only move once the objects are integrated, so everything but
+		// the objects' velocities stays the same for the whole solve
+		Vector3 r1 = m_pObj1->GetRotation() * m_LocalOnA;
+		Vector3 r2 = m_pObj2->GetRotation() * m_LocalOnB;
 
-		Vector3 globalOnA = r1 + m_pObj1->GetPosition ();
-		Vector3 globalOnB = r2 + m_pObj2->GetPosition ();
+		Vector3 globalOnA = r1 + m_pObj1->GetPosition();
+		Vector3 globalOnB = r2 + m_pObj2->GetPosition();
 
 		Vector3 ab = globalOnB - globalOnA;
 		Vector3 abn = ab;
-		abn.Normalise ();
+		abn.Normalise();
+
+		m_Row.Build(m_pObj1, m_pObj2, abn, r1, r2);
+
+		float distance_offset = ab.Length() - m_Distance;
+		float baumgarte_scalar = velocity_baumgarte ? 0.1f : 0.0f;
+		m_Bias = -(baumgarte_scalar / dt) * distance_offset;
+	}
 
-		Vector3 v0 = m_pObj1->GetLinearVelocity () + Vector3::Cross (m_pObj1->GetAngularVelocity (), r1);
-		Vector3 v1 = m_pObj2->GetLinearVelocity () + Vector3::Cross (m_pObj2->GetAngularVelocity (), r2);
+	//Position correction pass, same as Manifold - rebuilds the row for the integrated
+	// positions, then each iteration moves the objects back towards the right distance
+	void PrePositionStep()
+	{
+		Vector3 r1 = m_pObj1->GetRotation() * m_LocalOnA;
+		Vector3 r2 = m_pObj2->GetRotation() * m_LocalOnB;
 
-		{
-			float constraintMass = (m_pObj1->GetInverseMass () + m_pObj2->GetInverseMass ()) + 
-				Vector3::Dot (abn, 
-					Vector3::Cross (m_pObj1->GetInverseInertia () * Vector3::Cross (r1, abn), r1)
-				+ Vector3::Cross (m_pObj2->GetInverseInertia () * Vector3::Cross (r2, abn), r2));
+		Vector3 ab = (m_pObj2->GetPosition() + r2) - (m_pObj1->GetPosition() + r1);
+		Vector3 abn = ab;
+		abn.Normalise();
 
-			float b = 0.0f;
-			{
-				float distance_offset = ab.Length () - m_Distance;
-				float baumgarte_scalar = 0.1f;
-				b = -(baumgarte_scalar / PhysicsEngine::Instance ()->GetDeltaTime ()) * distance_offset;
-			}
+		m_Row.Build(m_pObj1, m_pObj2, abn, r1, r2);
+		m_PositionError = ab.Length() - m_Distance;
+	}
 
-			float jn = -(Vector3::Dot (v0 - v1, abn) + b) / constraintMass;
+	float SolvePosition()
+	{
+		if (m_Row.effectiveMass == 0.0f)
+			return 0.0f;
 
-			m_pObj1->SetLinearVelocity (m_pObj1->GetLinearVelocity () + abn * (jn * m_pObj1->GetInverseMass ()));
-			m_pObj2->SetLinearVelocity (m_pObj2->GetLinearVelocity () - abn * (jn * m_pObj2->GetInverseMass ()));
+		//Moving A towards B shortens the distance between them
+		float error = m_PositionError - m_Row.GetRelativeCorrection(m_pObj1, m_pObj2);
+		float correction = min(max(NGS_BAUMGARTE_SCALAR * error, -NGS_MAX_CORRECTION), NGS_MAX_CORRECTION);
 
-			m_pObj1->SetAngularVelocity (m_pObj1->GetAngularVelocity () + m_pObj1->GetInverseInertia () * Vector3::Cross (r1, abn * jn));
-			m_pObj2->SetAngularVelocity (m_pObj2->GetAngularVelocity () - m_pObj2->GetInverseInertia () * Vector3::Cross (r2, abn * jn));
-		}
+		m_Row.ApplyCorrection(m_pObj1, m_pObj2, correction * m_Row.effectiveMass);
+		return fabs(error);
 	}
 
-	virtual void DebugDraw() const
+	virtual void ApplyImpulse() override
 	{
-		Vector3 globalOnA = m_pObj1->GetOrientation().ToMatrix3() * m_LocalOnA + m_pObj1->GetPosition();
-		Vector3 globalOnB = m_pObj2->GetOrientation().ToMatrix3() * m_LocalOnB + m_pObj2->GetPosition();
+		ApplyImpulseResidual();
+	}
+
+	virtual float ApplyImpulseResidual() override
+	{
+		/* TUT 3 */
+		if (m_Row.effectiveMass == 0.0f)
+			return 0.0f;
+
+		float jn = -(m_Row.GetRelativeVelocity(m_pObj1, m_pObj2) + m_Bias) * m_Row.effectiveMass;
+
+		m_VelocityDelta.ApplyImpulse(m_pObj1, m_pObj2, m_Row, jn);
+		return fabs(jn);
+	}
+
+	virtual PhysicsObject* GetObjectA() const override	{ return m_pObj1; }
+	virtual PhysicsObject* GetObjectB() const override	{ return m_pObj2; }
+
+	virtual void DebugDraw() const override
+	{
+		Vector3 globalOnA = m_pObj1->GetRotation() * m_LocalOnA + m_pObj1->GetPosition();
+		Vector3 globalOnB = m_pObj2->GetRotation() * m_LocalOnB + m_pObj2->GetPosition();
 
 		NCLDebug::DrawThickLine(globalOnA, globalOnB, 0.02f, Vector4(0.0f, 0.0f, 0.0f, 1.0f));
 		NCLDebug::DrawPointNDT(globalOnA, 0.05f, Vector4(1.0f, 0.8f, 1.0f, 1.0f));
@@ -100,4 +137,9 @@ protected:
 	float   m_Distance;
 	Vector3 m_LocalOnA;
 	Vector3 m_LocalOnB;
+
+	//Set up by PreSolverStep
+	JacobianRow	m_Row;
+	float		m_Bias;
+	float		m_PositionError;	//Distance too long by, once the objects have been integrated
 };
\ No newline at end of file
@@ -0,0 +1,504 @@
+#include "DynamicAABBTree.h"
+#include "PhysicsObject.h"
+#include "PhysicsEngine.h"
+#include "NCLDebug.h"
+
+static inline BoundingBox CombineAABB(const BoundingBox& a, const BoundingBox& b)
+{
+	BoundingBox out = a;
+	out.ExpandToFit(b);
+	return out;
+}
+
+DynamicAABBTree::DynamicAABBTree()
+	: m_Root(AABBTREE_NULL_NODE)
+	, m_FreeList(AABBTREE_NULL_NODE)
+	, m_NumReinserts(0)
+{
+}
+
+DynamicAABBTree::~DynamicAABBTree()
+{
+	Clear();
+}
+
+void DynamicAABBTree::AddObject(PhysicsObject* obj)
+{
+	if (m_ObjectLookup.find(obj) != m_ObjectLookup.end())
+		return;
+
+	//The leaf itself is created on the next update, as the object
+	// may not have been given a collision shape yet
+	TreeObject to;
+	to.obj = obj;
+	to.leaf = AABBTREE_NULL_NODE;
+
+	m_ObjectLookup[obj] = m_Objects.size();
+	m_Objects.push_back(to);
+}
+
+void DynamicAABBTree::RemoveObject(PhysicsObject* obj)
+{
+	auto found_loc = m_ObjectLookup.find(obj);
+	if (found_loc == m_ObjectLookup.end())
+		return;
+
+	size_t idx = found_loc->second;
+	m_ObjectLookup.erase(found_loc);
+
+	int leaf = m_Objects[idx].leaf;
+	if (leaf != AABBTREE_NULL_NODE)
+	{
+		RemoveLeaf(leaf);
+		FreeNode(leaf);
+	}
+
+	//Swap with the last object and pop
+	if (idx != m_Objects.size() - 1)
+	{
+		m_Objects[idx] = m_Objects.back();
+		m_ObjectLookup[m_Objects[idx].obj] = idx;
+	}
+	m_Objects.pop_back();
+}
+
+void DynamicAABBTree::Clear()
+{
+	m_Nodes.clear();
+	m_Root = AABBTREE_NULL_NODE;
+	m_FreeList = AABBTREE_NULL_NODE;
+
+	m_Objects.clear();
+	m_ObjectLookup.clear();
+}
+
+void DynamicAABBTree::UpdateObjects(float dt)
+{
+	m_NumReinserts = 0;
+
+	BoundingBox aabb, fat_aabb;
+	for (TreeObject& to : m_Objects)
+	{
+		//Sleeping objects have not moved, so can never have left their fat aabb
+		if (to.leaf != AABBTREE_NULL_NODE && to.obj->IsSleeping())
+			continue;
+
+		to.obj->GetWorldSpaceAABB(&aabb);
+		Vector3 displacement = to.obj->GetLinearVelocity() * (dt * AABBTREE_DISPLACEMENT_MULTIPLIER);
+
+		if (to.leaf == AABBTREE_NULL_NODE)
+		{
+			BuildFatAABB(aabb, displacement, &fat_aabb);
+			to.leaf = CreateLeaf(to.obj, fat_aabb);
+			continue;
+		}
+
+		const BoundingBox& tree_aabb = m_Nodes[to.leaf].aabb;
+		if (tree_aabb.Contains(aabb))
+		{
+			// Still inside the fat bounds, though if the object has slowed down
+			// the fat bounds may now be much larger than they need to be.
+			BoundingBox huge_aabb;
+			BuildFatAABB(aabb, displacement, &huge_aabb);
+			Vector3 huge_margin = Vector3(1.0f, 1.0f, 1.0f) * (4.0f * AABBTREE_FAT_MARGIN);
+			huge_aabb._min = huge_aabb._min - huge_margin;
+			huge_aabb._max = huge_aabb._max + huge_margin;
+
+			if (huge_aabb.Contains(tree_aabb))
+				continue;
+		}
+
+		RemoveLeaf(to.leaf);
+		BuildFatAABB(aabb, displacement, &m_Nodes[to.leaf].aabb);
+		InsertLeaf(to.leaf);
+		m_NumReinserts++;
+	}
+}
+
+void DynamicAABBTree::GenerateCPs(std::vector<CollisionPair>& cpList)
+{
+	if (m_Root == AABBTREE_NULL_NODE)
+		return;
+
+	// Collide the tree against itself:
+	//  - A node vs itself recurses into both of its children and the pair of them
+	//  - Two different nodes are only descended into if their bounds overlap
+	m_TraversalStack.clear();
+	m_TraversalStack.push_back(std::make_pair(m_Root, m_Root));
+
+	while (!m_TraversalStack.empty())
+	{
+		int a = m_TraversalStack.back().first;
+		int b = m_TraversalStack.back().second;
+		m_TraversalStack.pop_back();
+
+		const TreeNode& nodeA = m_Nodes[a];
+		const TreeNode& nodeB = m_Nodes[b];
+
+		if (a == b)
+		{
+			if (!nodeA.IsLeaf())
+			{
+				m_TraversalStack.push_back(std::make_pair(nodeA.child1, nodeA.child2));
+				m_TraversalStack.push_back(std::make_pair(nodeA.child2, nodeA.child2));
+				m_TraversalStack.push_back(std::make_pair(nodeA.child1, nodeA.child1));
+			}
+			continue;
+		}
+
+		if (!nodeA.aabb.Intersects(nodeB.aabb))
+			continue;
+
+		if (nodeA.IsLeaf() && nodeB.IsLeaf())
+		{
+			//Check they both atleast have collision shapes
+			if (nodeA.obj->GetCollisionShape() != NULL
+				&& nodeB.obj->GetCollisionShape() != NULL)
+			{
+				CollisionPair cp;
+				cp.pObjectA = nodeA.obj;
+				cp.pObjectB = nodeB.obj;
+				cpList.push_back(cp);
+			}
+		}
+		else if (nodeB.IsLeaf() || (!nodeA.IsLeaf() && nodeA.aabb.SurfaceArea() > nodeB.aabb.SurfaceArea()))
+		{
+			//Descend into the larger node
+			m_TraversalStack.push_back(std::make_pair(nodeA.child2, b));
+			m_TraversalStack.push_back(std::make_pair(nodeA.child1, b));
+		}
+		else
+		{
+			m_TraversalStack.push_back(std::make_pair(a, nodeB.child2));
+			m_TraversalStack.push_back(std::make_pair(a, nodeB.child1));
+		}
+	}
+}
+
+void DynamicAABBTree::BuildFatAABB(const BoundingBox& aabb, const Vector3& displacement, BoundingBox* out_fat_aabb) const
+{
+	Vector3 margin = Vector3(AABBTREE_FAT_MARGIN, AABBTREE_FAT_MARGIN, AABBTREE_FAT_MARGIN);
+	out_fat_aabb->_min = aabb._min - margin;
+	out_fat_aabb->_max = aabb._max + margin;
+
+	//Stretch the bounds in the direction of travel
+	if (displacement.x < 0.0f) out_fat_aabb->_min.x += displacement.x; else out_fat_aabb->_max.x += displacement.x;
+	if (displacement.y < 0.0f) out_fat_aabb->_min.y += displacement.y; else out_fat_aabb->_max.y += displacement.y;
+	if (displacement.z < 0.0f) out_fat_aabb->_min.z += displacement.z; else out_fat_aabb->_max.z += displacement.z;
+}
+
+int DynamicAABBTree::AllocateNode()
+{
+	int node;
+	if (m_FreeList != AABBTREE_NULL_NODE)
+	{
+		node = m_FreeList;
+		m_FreeList = m_Nodes[node].parent;
+	}
+	else
+	{
+		node = (int)m_Nodes.size();
+		m_Nodes.push_back(TreeNode());
+	}
+
+	TreeNode& n = m_Nodes[node];
+	n.obj = NULL;
+	n.parent = AABBTREE_NULL_NODE;
+	n.child1 = AABBTREE_NULL_NODE;
+	n.child2 = AABBTREE_NULL_NODE;
+	n.height = 0;
+	return node;
+}
+
+void DynamicAABBTree::FreeNode(int node)
+{
+	m_Nodes[node].parent = m_FreeList;
+	m_Nodes[node].height = -1;
+	m_FreeList = node;
+}
+
+int DynamicAABBTree::CreateLeaf(PhysicsObject* obj, const BoundingBox& fat_aabb)
+{
+	int leaf = AllocateNode();
+	m_Nodes[leaf].obj = obj;
+	m_Nodes[leaf].aabb = fat_aabb;
+
+	InsertLeaf(leaf);
+	return leaf;
+}
+
+void DynamicAABBTree::InsertLeaf(int leaf)
+{
+	if (m_Root == AABBTREE_NULL_NODE)
+	{
+		m_Root = leaf;
+		m_Nodes[leaf].parent = AABBTREE_NULL_NODE;
+		return;
+	}
+
+	// Find the best sibling for this leaf, using the surface area heuristic:
+	//  - Making a new parent at 'index' costs the area of the combined bounds
+	//  - Every ancestor above it also grows, which is inherited by both children
+	BoundingBox leaf_aabb = m_Nodes[leaf].aabb;
+	int index = m_Root;
+	while (!m_Nodes[index].IsLeaf())
+	{
+		const TreeNode& node = m_Nodes[index];
+
+		float area = node.aabb.SurfaceArea();
+		float combined_area = CombineAABB(node.aabb, leaf_aabb).SurfaceArea();
+
+		float cost = 2.0f * combined_area;
+		float inheritance_cost = 2.0f * (combined_area - area);
+
+		float child_cost[2];
+		int children[2] = { node.child1, node.child2 };
+		for (int i = 0; i < 2; ++i)
+		{
+			const TreeNode& child = m_Nodes[children[i]];
+			float new_area = CombineAABB(child.aabb, leaf_aabb).SurfaceArea();
+			child_cost[i] = (child.IsLeaf() ? new_area : new_area - child.aabb.SurfaceArea()) + inheritance_cost;
+		}
+
+		//Cheaper to just pair up with this node?
+		if (cost < child_cost[0] && cost < child_cost[1])
+			break;
+
+		index = (child_cost[0] < child_cost[1]) ? children[0] : children[1];
+	}
+
+	int sibling = index;
+
+	//Create a new parent for the sibling and the leaf
+	int new_parent = AllocateNode();
+	int old_parent = m_Nodes[sibling].parent;
+
+	m_Nodes[new_parent].parent = old_parent;
+	m_Nodes[new_parent].aabb = CombineAABB(leaf_aabb, m_Nodes[sibling].aabb);
+	m_Nodes[new_parent].height = m_Nodes[sibling].height + 1;
+	m_Nodes[new_parent].child1 = sibling;
+	m_Nodes[new_parent].child2 = leaf;
+	m_Nodes[sibling].parent = new_parent;
+	m_Nodes[leaf].parent = new_parent;
+
+	if (old_parent != AABBTREE_NULL_NODE)
+	{
+		if (m_Nodes[old_parent].child1 == sibling)
+			m_Nodes[old_parent].child1 = new_parent;
+		else
+			m_Nodes[old_parent].child2 = new_parent;
+	}
+	else
+	{
+		m_Root = new_parent;
+	}
+
+	//Walk back up the tree refitting and rebalancing
+	index = m_Nodes[leaf].parent;
+	while (index != AABBTREE_NULL_NODE)
+	{
+		index = Balance(index);
+
+		TreeNode& node = m_Nodes[index];
+		node.height = 1 + max(m_Nodes[node.child1].height, m_Nodes[node.child2].height);
+		node.aabb = CombineAABB(m_Nodes[node.child1].aabb, m_Nodes[node.child2].aabb);
+
+		index = node.parent;
+	}
+}
+
+void DynamicAABBTree::RemoveLeaf(int leaf)
+{
+	if (leaf == m_Root)
+	{
+		m_Root = AABBTREE_NULL_NODE;
+		return;
+	}
+
+	int parent = m_Nodes[leaf].parent;
+	int grand_parent = m_Nodes[parent].parent;
+	int sibling = (m_Nodes[parent].child1 == leaf) ? m_Nodes[parent].child2 : m_Nodes[parent].child1;
+
+	if (grand_parent != AABBTREE_NULL_NODE)
+	{
+		//Destroy the parent and connect the sibling to the grand parent
+		if (m_Nodes[grand_parent].child1 == parent)
+			m_Nodes[grand_parent].child1 = sibling;
+		else
+			m_Nodes[grand_parent].child2 = sibling;
+
+		m_Nodes[sibling].parent = grand_parent;
+		FreeNode(parent);
+
+		//Walk back up the tree refitting and rebalancing
+		int index = grand_parent;
+		while (index != AABBTREE_NULL_NODE)
+		{
+			index = Balance(index);
+
+			TreeNode& node = m_Nodes[index];
+			node.height = 1 + max(m_Nodes[node.child1].height, m_Nodes[node.child2].height);
+			node.aabb = CombineAABB(m_Nodes[node.child1].aabb, m_Nodes[node.child2].aabb);
+
+			index = node.parent;
+		}
+	}
+	else
+	{
+		m_Root = sibling;
+		m_Nodes[sibling].parent = AABBTREE_NULL_NODE;
+		FreeNode(parent);
+	}
+
+	m_Nodes[leaf].parent = AABBTREE_NULL_NODE;
+}
+
+int DynamicAABBTree::Balance(int iA)
+{
+	// Performs a left or right rotation if node A is imbalanced,
+	// returning the index of the node that now sits in A's place.
+	TreeNode& A = m_Nodes[iA];
+	if (A.IsLeaf() || A.height < 2)
+		return iA;
+
+	int iB = A.child1;
+	int iC = A.child2;
+	TreeNode& B = m_Nodes[iB];
+	TreeNode& C = m_Nodes[iC];
+
+	int balance = C.height - B.height;
+
+	//Rotate C up
+	if (balance > 1)
+	{
+		int iF = C.child1;
+		int iG = C.child2;
+		TreeNode& F = m_Nodes[iF];
+		TreeNode& G = m_Nodes[iG];
+
+		//Swap A and C
+		C.child1 = iA;
+		C.parent = A.parent;
+		A.parent = iC;
+
+		if (C.parent != AABBTREE_NULL_NODE)
+		{
+			if (m_Nodes[C.parent].child1 == iA)
+				m_Nodes[C.parent].child1 = iC;
+			else
+				m_Nodes[C.parent].child2 = iC;
+		}
+		else
+		{
+			m_Root = iC;
+		}
+
+		//Rotate
+		if (F.height > G.height)
+		{
+			C.child2 = iF;
+			A.child2 = iG;
+			G.parent = iA;
+			A.aabb = CombineAABB(B.aabb, G.aabb);
+			C.aabb = CombineAABB(A.aabb, F.aabb);
+
+			A.height = 1 + max(B.height, G.height);
+			C.height = 1 + max(A.height, F.height);
+		}
+		else
+		{
+			C.child2 = iG;
+			A.child2 = iF;
+			F.parent = iA;
+			A.aabb = CombineAABB(B.aabb, F.aabb);
+			C.aabb = CombineAABB(A.aabb, G.aabb);
+
+			A.height = 1 + max(B.height, F.height);
+			C.height = 1 + max(A.height, G.height);
+		}
+
+		return iC;
+	}
+
+	//Rotate B up
+	if (balance < -1)
+	{
+		int iD = B.child1;
+		int iE = B.child2;
+		TreeNode& D = m_Nodes[iD];
+		TreeNode& E = m_Nodes[iE];
+
+		//Swap A and B
+		B.child1 = iA;
+		B.parent = A.parent;
+		A.parent = iB;
+
+		if (B.parent != AABBTREE_NULL_NODE)
+		{
+			if (m_Nodes[B.parent].child1 == iA)
+				m_Nodes[B.parent].child1 = iB;
+			else
+				m_Nodes[B.parent].child2 = iB;
+		}
+		else
+		{
+			m_Root = iB;
+		}
+
+		//Rotate
+		if (D.height > E.height)
+		{
+			B.child2 = iD;
+			A.child1 = iE;
+			E.parent = iA;
+			A.aabb = CombineAABB(C.aabb, E.aabb);
+			B.aabb = CombineAABB(A.aabb, D.aabb);
+
+			A.height = 1 + max(C.height, E.height);
+			B.height = 1 + max(A.height, D.height);
+		}
+		else
+		{
+			B.child2 = iE;
+			A.child1 = iD;
+			D.parent = iA;
+			A.aabb = CombineAABB(C.aabb, D.aabb);
+			B.aabb = CombineAABB(A.aabb, E.aabb);
+
+			A.height = 1 + max(C.height, D.height);
+			B.height = 1 + max(A.height, E.height);
+		}
+
+		return iB;
+	}
+
+	return iA;
+}
+
+void DynamicAABBTree::DebugDraw() const
+{
+	for (const TreeNode& node : m_Nodes)
+	{
+		if (node.height < 0)
+			continue;
+
+		const Vector3& lo = node.aabb._min;
+		const Vector3& hi = node.aabb._max;
+		Vector4 colour = node.IsLeaf() ? Vector4(0.2f, 1.0f, 0.2f, 1.0f) : Vector4(1.0f, 0.6f, 0.2f, 1.0f);
+
+		NCLDebug::DrawHairLine(Vector3(lo.x, lo.y, lo.z), Vector3(hi.x, lo.y, lo.z), colour);
+		NCLDebug::DrawHairLine(Vector3(lo.x, hi.y, lo.z), Vector3(hi.x, hi.y, lo.z), colour);
+		NCLDebug::DrawHairLine(Vector3(lo.x, lo.y, hi.z), Vector3(hi.x, lo.y, hi.z), colour);
+		NCLDebug::DrawHairLine(Vector3(lo.x, hi.y, hi.z), Vector3(hi.x, hi.y, hi.z), colour);
+
+		NCLDebug::DrawHairLine(Vector3(lo.x, lo.y, lo.z), Vector3(lo.x, hi.y, lo.z), colour);
+		NCLDebug::DrawHairLine(Vector3(hi.x, lo.y, lo.z), Vector3(hi.x, hi.y, lo.z), colour);
+		NCLDebug::DrawHairLine(Vector3(lo.x, lo.y, hi.z), Vector3(lo.x, hi.y, hi.z), colour);
+		NCLDebug::DrawHairLine(Vector3(hi.x, lo.y, hi.z), Vector3(hi.x, hi.y, hi.z), colour);
+
+		NCLDebug::DrawHairLine(Vector3(lo.x, lo.y, lo.z), Vector3(lo.x, lo.y, hi.z), colour);
+		NCLDebug::DrawHairLine(Vector3(hi.x, lo.y, lo.z), Vector3(hi.x, lo.y, hi.z), colour);
+		NCLDebug::DrawHairLine(Vector3(lo.x, hi.y, lo.z), Vector3(lo.x, hi.y, hi.z), colour);
+		NCLDebug::DrawHairLine(Vector3(hi.x, hi.y, lo.z), Vector3(hi.x, hi.y, hi.z), colour);
+	}
+}
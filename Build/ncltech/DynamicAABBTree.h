@@ -0,0 +1,91 @@
+/******************************************************************************
+Class: DynamicAABBTree
+Description: Dynamic bounding volume hierarchy broadphase. Each physics object
+is stored as a leaf holding a 'fat' AABB - its real bounds grown by a small
+margin and stretched in the direction it is travelling. The leaf is only removed
+and reinserted when the object leaves its fat bounds, so resting or slow moving
+objects (and static objects) cost nothing to update.
+
+Leaves are inserted by walking down the tree choosing the child with the lowest
+surface area cost, and the tree is kept balanced with AVL style rotations on the
+way back up. Collision pairs are then found by colliding the tree against itself,
+skipping whole subtrees whose bounds do not overlap.
+******************************************************************************/
+#pragma once
+
+#include "BoundingBox.h"
+#include <vector>
+#include <unordered_map>
+
+class PhysicsObject;
+struct CollisionPair;
+
+#define AABBTREE_NULL_NODE				-1
+#define AABBTREE_FAT_MARGIN				0.1f	//Padding added to every leaf aabb (in meters)
+#define AABBTREE_DISPLACEMENT_MULTIPLIER	2.0f	//How many timesteps worth of velocity to extend the fat aabb by
+
+class DynamicAABBTree
+{
+public:
+	DynamicAABBTree();
+	~DynamicAABBTree();
+
+	//Add/Remove objects from the broadphase - called by the PhysicsEngine
+	void AddObject(PhysicsObject* obj);
+	void RemoveObject(PhysicsObject* obj);
+	void Clear();
+
+	//Refits the tree - any object that has left its fat aabb is reinserted
+	void UpdateObjects(float dt);
+
+	//Finds all overlapping leaves with a tree vs tree traversal
+	// and appends them (if both have collision shapes) to the given list.
+	void GenerateCPs(std::vector<CollisionPair>& cpList);
+
+	//Draws the bounds of every node in the tree
+	void DebugDraw() const;
+
+	int GetHeight() const				{ return (m_Root == AABBTREE_NULL_NODE) ? 0 : m_Nodes[m_Root].height; }
+	int GetNumReinserts() const			{ return m_NumReinserts; }
+
+protected:
+	struct TreeNode
+	{
+		BoundingBox		aabb;
+		PhysicsObject*	obj;		//Only set for leaves
+
+		int parent;					//Also used as the 'next' index while in the free list
+		int child1;
+		int child2;
+		int height;					//Leaf = 0, free node = -1
+
+		inline bool IsLeaf() const	{ return child1 == AABBTREE_NULL_NODE; }
+	};
+
+	struct TreeObject
+	{
+		PhysicsObject*	obj;
+		int				leaf;
+	};
+
+	int  AllocateNode();
+	void FreeNode(int node);
+
+	int  CreateLeaf(PhysicsObject* obj, const BoundingBox& fat_aabb);
+	void InsertLeaf(int leaf);
+	void RemoveLeaf(int leaf);
+	int  Balance(int node);
+
+	void BuildFatAABB(const BoundingBox& aabb, const Vector3& displacement, BoundingBox* out_fat_aabb) const;
+
+protected:
+	std::vector<TreeNode>	m_Nodes;
+	int						m_Root;
+	int						m_FreeList;
+
+	std::vector<TreeObject>						m_Objects;
+	std::unordered_map<PhysicsObject*, size_t>	m_ObjectLookup;		//PhysicsObject -> index into m_Objects
+
+	std::vector<std::pair<int, int>>			m_TraversalStack;	//Reused between frames to avoid allocations
+	int											m_NumReinserts;
+};
@@ -0,0 +1,77 @@
+/******************************************************************************
+Class: HingeConstraint
+Description: Pins a point on one object to a point on another (as the ball and
+socket), and also keeps an axis fixed in each of them lined up - so the only
+movement left is rotation about that axis (doors, wheels, elbows etc).
+
+Five rows solved together as one block, see BlockConstraint: three for the
+pivot, and two stopping rotation about the axes perpendicular to the hinge.
+******************************************************************************/
+#pragma once
+
+#include "BlockConstraint.h"
+#include "NCLDebug.h"
+
+//Final, so that the PhysicsEngine's pool of hinge joints can call it without going through the vtable
+class HingeConstraint final : public BlockConstraint<5>
+{
+public:
+	HingeConstraint(PhysicsObject* obj1, PhysicsObject* obj2, const Vector3& globalPivot, const Vector3& globalAxis)
+		: BlockConstraint<5>(obj1, obj2)
+	{
+		Vector3 axis = globalAxis;
+		axis.Normalise();
+
+		Matrix3 invRotA = Matrix3::Transpose(m_pObj1->GetRotation());
+		Matrix3 invRotB = Matrix3::Transpose(m_pObj2->GetRotation());
+		m_LocalOnA = invRotA * (globalPivot - m_pObj1->GetPosition());
+		m_LocalOnB = invRotB * (globalPivot - m_pObj2->GetPosition());
+		m_LocalAxisA = invRotA * axis;
+		m_LocalAxisB = invRotB * axis;
+	}
+
+	virtual void DebugDraw() const override
+	{
+		Vector3 globalOnA = m_pObj1->GetRotation() * m_LocalOnA + m_pObj1->GetPosition();
+		Vector3 axis = m_pObj1->GetRotation() * m_LocalAxisA;
+
+		NCLDebug::DrawThickLine(m_pObj1->GetPosition(), globalOnA, 0.02f, Vector4(0.0f, 0.0f, 0.0f, 1.0f));
+		NCLDebug::DrawThickLine(m_pObj2->GetPosition(), globalOnA, 0.02f, Vector4(0.0f, 0.0f, 0.0f, 1.0f));
+		NCLDebug::DrawThickLine(globalOnA - axis * 0.5f, globalOnA + axis * 0.5f, 0.02f, Vector4(1.0f, 0.8f, 1.0f, 1.0f));
+	}
+
+protected:
+	virtual void BuildRows() override
+	{
+		//Pivot
+		Vector3 r1 = m_pObj1->GetRotation() * m_LocalOnA;
+		Vector3 r2 = m_pObj2->GetRotation() * m_LocalOnB;
+		Vector3 error = (m_pObj1->GetPosition() + r1) - (m_pObj2->GetPosition() + r2);
+
+		m_Rows[0].Build(m_pObj1, m_pObj2, Vector3(1.0f, 0.0f, 0.0f), r1, r2);
+		m_Rows[1].Build(m_pObj1, m_pObj2, Vector3(0.0f, 1.0f, 0.0f), r1, r2);
+		m_Rows[2].Build(m_pObj1, m_pObj2, Vector3(0.0f, 0.0f, 1.0f), r1, r2);
+		m_Error[0] = error.x;
+		m_Error[1] = error.y;
+		m_Error[2] = error.z;
+
+		//Axis - for small angles, b x a is the rotation (of A relative to B) that has moved B's
+		// axis away from A's. Only its parts perpendicular to the hinge are constrained.
+		Vector3 a = m_pObj1->GetRotation() * m_LocalAxisA;
+		Vector3 b = m_pObj2->GetRotation() * m_LocalAxisB;
+		Vector3 t1 = GetPerpendicular(a);
+		Vector3 t2 = Vector3::Cross(a, t1);
+		Vector3 axis_error = Vector3::Cross(b, a);
+
+		m_Rows[3].BuildAngular(m_pObj1, m_pObj2, t1);
+		m_Rows[4].BuildAngular(m_pObj1, m_pObj2, t2);
+		m_Error[3] = Vector3::Dot(axis_error, t1);
+		m_Error[4] = Vector3::Dot(axis_error, t2);
+	}
+
+protected:
+	Vector3 m_LocalOnA;		//Pivot in each object's local space
+	Vector3 m_LocalOnB;
+	Vector3 m_LocalAxisA;	//Hinge axis in each object's local space
+	Vector3 m_LocalAxisB;
+};
@@ -1,9 +1,35 @@
 #include "Hull.h"
 #include "NCLDebug.h"
+#include <algorithm>
+#include <unordered_map>
 
-Hull::Hull()
+//Packs the values into one list per key (in the order they are given), returning the
+// offset of each key's list in out_offsets
+static void BuildLists(int num_keys, const std::vector<int>& keys, const std::vector<int>& values,
+	std::vector<int>* out_offsets, std::vector<int>* out_values)
 {
+	out_offsets->assign(num_keys + 1, 0);
+	for (int key : keys)
+	{
+		(*out_offsets)[key + 1]++;
+	}
+	for (int i = 0; i < num_keys; ++i)
+	{
+		(*out_offsets)[i + 1] += (*out_offsets)[i];
+	}
+
+	std::vector<int> next(out_offsets->begin(), out_offsets->end() - 1);
+	out_values->resize(values.size());
+	for (size_t i = 0; i < keys.size(); ++i)
+	{
+		(*out_values)[next[keys[i]]++] = values[i];
+	}
+}
 
+Hull::Hull()
+	: m_Finalized(false)
+{
+	m_vFaceVertexOffsets.push_back(0);
 }
 
 Hull::~Hull()
@@ -14,139 +40,159 @@ Hull::~Hull()
 
 void Hull::AddVertex(const Vector3& v)
 {
-	HullVertex new_vertex;
-	new_vertex.idx = m_vVertices.size();
-	new_vertex.pos = v;
+	if (m_Finalized)
+	{
+		NCLERROR("Hull: Can't add vertices once finalized");
+		return;
+	}
 
-	m_vVertices.push_back(new_vertex);
+	m_vVertexPositions.push_back(v);
 }
 
-int Hull::FindEdge(int v0_idx, int v1_idx)
+void Hull::AddFace(const Vector3& _normal, int nVerts, const int* verts)
 {
-	for (const HullEdge& edge : m_vEdges)
+	if (m_Finalized)
 	{
-		if ((edge.vStart == v0_idx && edge.vEnd == v1_idx)
-			|| (edge.vStart == v1_idx && edge.vEnd == v0_idx))
-		{
-			return edge.idx;
-		}
+		NCLERROR("Hull: Can't add faces once finalized");
+		return;
 	}
 
-	return -1; //Not Found
+	Vector3 normal = _normal;
+	normal.Normalise();
+	m_vFaceNormals.push_back(normal);
+
+	m_vFaceVertices.insert(m_vFaceVertices.end(), verts, verts + nVerts);
+	m_vFaceVertexOffsets.push_back(m_vFaceVertices.size());
+}
+
+uint64_t Hull::EdgeKey(int v0_idx, int v1_idx)
+{
+	uint32_t lo = (uint32_t)min(v0_idx, v1_idx);
+	uint32_t hi = (uint32_t)max(v0_idx, v1_idx);
+	return ((uint64_t)hi << 32) | lo;
 }
 
-int Hull::ConstructNewEdge(int parent_face_idx, int vert_start, int vert_end)
+void Hull::Finalize()
 {
-	int out_idx = FindEdge(vert_start, vert_end);
+	if (m_Finalized)
+		return;
 
+	int num_vertices = m_vVertexPositions.size();
+	int num_faces = m_vFaceNormals.size();
 
-	//Edge not already within the Hull, 
-	if (out_idx == -1)
+	//Which face each entry of the face vertex (and edge) lists belongs to
+	std::vector<int> entry_faces(m_vFaceVertices.size());
+	for (int i = 0; i < num_faces; ++i)
 	{
-		out_idx = m_vEdges.size();
+		std::fill(entry_faces.begin() + m_vFaceVertexOffsets[i], entry_faces.begin() + m_vFaceVertexOffsets[i + 1], i);
+	}
 
-		HullEdge new_edge;
-		new_edge.idx = m_vEdges.size();
-		new_edge.vStart = vert_start;
-		new_edge.vEnd = vert_end;
-		m_vEdges.push_back(new_edge);
 
-		HullEdge* new_edge_ptr = &m_vEdges[new_edge.idx];
+	//Construct all edges, in the order they are first found going around each face
+	std::unordered_map<uint64_t, int> edge_lookup;
+	edge_lookup.reserve(m_vFaceVertices.size());
 
-		//Find Adjacent Edges
-		for (int i = 0; i < new_edge.idx; ++i)
+	m_vEdges.clear();
+	m_vFaceEdges.resize(m_vFaceVertices.size());
+	for (int i = 0; i < num_faces; ++i)
+	{
+		int first = m_vFaceVertexOffsets[i];
+		int last = m_vFaceVertexOffsets[i + 1];
+
+		int p0 = last - 1;
+		for (int p1 = first; p1 < last; ++p1)
 		{
-			if (m_vEdges[i].vStart == vert_start
-				|| m_vEdges[i].vStart == vert_end
-				|| m_vEdges[i].vEnd == vert_start
-				|| m_vEdges[i].vEnd == vert_end)
+			HullEdge edge;
+			edge.vStart = m_vFaceVertices[p0];
+			edge.vEnd = m_vFaceVertices[p1];
+
+			auto found = edge_lookup.insert(std::make_pair(EdgeKey(edge.vStart, edge.vEnd), (int)m_vEdges.size()));
+			if (found.second)
 			{
-				m_vEdges[i].adjoining_edge_ids.push_back(new_edge.idx);
-				new_edge_ptr->adjoining_edge_ids.push_back(i);
+				m_vEdges.push_back(edge);
 			}
-		}
 
-		//Update Contained Vertices
-		m_vVertices[vert_start].enclosing_edges.push_back(new_edge.idx);
-		m_vVertices[vert_end].enclosing_edges.push_back(new_edge.idx);
+			m_vFaceEdges[p1] = found.first->second;
+			p0 = p1;
+		}
 	}
 
-	m_vEdges[out_idx].enclosing_faces.push_back(parent_face_idx);
-	return out_idx;
-}
-
-void Hull::AddFace(const Vector3& _normal, int nVerts, const int* verts)
-{
-	HullFace new_face;
-	new_face.idx = m_vFaces.size();
-	new_face._normal = _normal;
-	new_face._normal.Normalise();
-
-	m_vFaces.push_back(new_face);
-	HullFace* new_face_ptr = &m_vFaces[new_face.idx];
 
+	//Everything else is just the other way round: the faces around each vertex and edge,
+	// and the edges around each vertex
+	BuildLists(num_vertices, m_vFaceVertices, entry_faces, &m_vVertexFaceOffsets, &m_vVertexFaces);
+	BuildLists(m_vEdges.size(), m_vFaceEdges, entry_faces, &m_vEdgeFaceOffsets, &m_vEdgeFaces);
 
-
-	//Construct all contained edges
-	int p0 = nVerts - 1;
-	for (int p1 = 0; p1 < nVerts; ++p1)
+	std::vector<int> edge_vertices, edge_ids;
+	for (size_t i = 0; i < m_vEdges.size(); ++i)
 	{
-		new_face_ptr->vert_ids.push_back(verts[p1]);
-		new_face_ptr->edge_ids.push_back(ConstructNewEdge(new_face.idx, verts[p0], verts[p1]));
-		p0 = p1;
+		edge_vertices.push_back(m_vEdges[i].vStart);
+		edge_vertices.push_back(m_vEdges[i].vEnd);
+		edge_ids.push_back(i);
+		edge_ids.push_back(i);
 	}
+	BuildLists(num_vertices, edge_vertices, edge_ids, &m_vVertexEdgeOffsets, &m_vVertexEdges);
 
 
-	//Find Adjacent Faces
-	for (int i = 0; i < new_face.idx; ++i)
+	//Adjacent faces are any others sharing one of the face's edges
+	std::vector<int> adjacent;
+	m_vFaceAdjOffsets.assign(1, 0);
+	m_vFaceAdjFaces.clear();
+	for (int i = 0; i < num_faces; ++i)
 	{
-		HullFace& cFace = m_vFaces[i];
-		bool found = false;
-		for (size_t j = 0; found == false && j < cFace.edge_ids.size(); ++j)
+		adjacent.clear();
+		for (int edgeIdx : GetFaceEdges(i))
 		{
-			for (int k = 0; found == false && k < nVerts; ++k)
+			for (int faceIdx : GetEdgeFaces(edgeIdx))
 			{
-				if (new_face_ptr->edge_ids[k] == cFace.edge_ids[j])
-				{
-					found = true;
-					cFace.adjoining_face_ids.push_back(new_face.idx);
-					new_face_ptr->adjoining_face_ids.push_back(i);
-				}
+				if (faceIdx != i)
+					adjacent.push_back(faceIdx);
 			}
 		}
+		std::sort(adjacent.begin(), adjacent.end());
+		adjacent.erase(std::unique(adjacent.begin(), adjacent.end()), adjacent.end());
+
+		m_vFaceAdjFaces.insert(m_vFaceAdjFaces.end(), adjacent.begin(), adjacent.end());
+		m_vFaceAdjOffsets.push_back(m_vFaceAdjFaces.size());
 	}
 
-	//Update Contained Vertices
-	for (int i = 0; i < nVerts; ++i)
+
+	//Negated normals for the planes, as we want to clip geometry left outside the shape not inside it
+	m_vFacePlanes.resize(num_faces);
+	for (int i = 0; i < num_faces; ++i)
 	{
-		HullVertex* cVertStart	= &m_vVertices[m_vEdges[new_face_ptr->edge_ids[i]].vStart];
-		HullVertex* cVertEnd	= &m_vVertices[m_vEdges[new_face_ptr->edge_ids[i]].vEnd];
+		const Vector3& pointOnPlane = m_vVertexPositions[GetFaceVertices(i)[0]];
+		m_vFacePlanes[i] = Plane(-m_vFaceNormals[i], Vector3::Dot(m_vFaceNormals[i], pointOnPlane));
+	}
 
-		auto foundLocStart = std::find(cVertStart->enclosing_faces.begin(), cVertStart->enclosing_faces.end(), new_face.idx);
-		if (foundLocStart == cVertStart->enclosing_faces.end())
-		{
-			cVertStart->enclosing_faces.push_back(new_face.idx);
-		}
+	m_Finalized = true;
+}
 
-		auto foundLocEnd = std::find(cVertEnd->enclosing_faces.begin(), cVertEnd->enclosing_faces.end(), new_face.idx);
-		if (foundLocEnd == cVertEnd->enclosing_faces.end())
+int Hull::FindEdge(int v0_idx, int v1_idx) const
+{
+	for (int edgeIdx : GetVertexEdges(v0_idx))
+	{
+		const HullEdge& edge = m_vEdges[edgeIdx];
+		if (edge.vStart == v1_idx || edge.vEnd == v1_idx)
 		{
-			cVertEnd->enclosing_faces.push_back(new_face.idx);
+			return edgeIdx;
 		}
 	}
+
+	return -1; //Not Found
 }
 
 
-void Hull::GetMinMaxVerticesInAxis(const Vector3& local_axis, int* out_min_vert, int* out_max_vert)
+void Hull::GetMinMaxVerticesInAxis(const Vector3& local_axis, int* out_min_vert, int* out_max_vert) const
 {
 	float cCorrelation;
-	int minVertex, maxVertex;
+	int minVertex = 0, maxVertex = 0;
 
 	float minCorrelation = FLT_MAX, maxCorrelation = -FLT_MAX;
 
-	for (size_t i = 0; i < m_vVertices.size(); ++i)
+	for (size_t i = 0; i < m_vVertexPositions.size(); ++i)
 	{
-		cCorrelation = Vector3::Dot(local_axis, m_vVertices[i].pos);
+		cCorrelation = Vector3::Dot(local_axis, m_vVertexPositions[i]);
 
 		if (cCorrelation > maxCorrelation)
 		{
@@ -166,20 +212,22 @@ void Hull::GetMinMaxVerticesInAxis(const Vector3& local_axis, int* out_min_vert,
 }
 
 
-void Hull::DebugDraw(const Matrix4& transform)
+void Hull::DebugDraw(const Matrix4& transform) const
 {
 	//Draw all Hull Polygons
-	for (HullFace& face : m_vFaces)
+	for (size_t i = 0; i < GetNumFaces(); ++i)
 	{
+		HullIndexList face = GetFaceVertices(i);
+
 		//Render Polygon as triangle fan
-		if (face.vert_ids.size() > 2)
+		if (face.size() > 2)
 		{
-			Vector3 polygon_start = transform * m_vVertices[face.vert_ids[0]].pos;
-			Vector3 polygon_last = transform * m_vVertices[face.vert_ids[1]].pos;
+			Vector3 polygon_start = transform * m_vVertexPositions[face[0]];
+			Vector3 polygon_last = transform * m_vVertexPositions[face[1]];
 
-			for (size_t idx = 2; idx < face.vert_ids.size(); ++idx)
+			for (int idx = 2; idx < face.size(); ++idx)
 			{
-				Vector3 polygon_next = transform * m_vVertices[face.vert_ids[idx]].pos;
+				Vector3 polygon_next = transform * m_vVertexPositions[face[idx]];
 
 				NCLDebug::DrawTriangleNDT(polygon_start, polygon_last, polygon_next, Vector4(1.0f, 1.0f, 1.0f, 0.2f));
 				polygon_last = polygon_next;
@@ -188,8 +236,8 @@ void Hull::DebugDraw(const Matrix4& transform)
 	}
 
 	//Draw all Hull Edges
-	for (HullEdge& edge : m_vEdges)
+	for (const HullEdge& edge : m_vEdges)
 	{
-		NCLDebug::DrawThickLineNDT(transform * m_vVertices[edge.vStart].pos, transform * m_vVertices[edge.vEnd].pos, 0.02f, Vector4(1.0f, 0.2f, 1.0f, 1.0f));
+		NCLDebug::DrawThickLineNDT(transform * m_vVertexPositions[edge.vStart], transform * m_vVertexPositions[edge.vEnd], 0.02f, Vector4(1.0f, 0.2f, 1.0f, 1.0f));
 	}
-}
\ No newline at end of file
+}
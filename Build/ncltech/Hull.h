@@ -2,22 +2,30 @@
 Class: Hull
 Implements:
 Author: Pieran Marris      <p.marris@newcastle.ac.uk> and YOU!
-Description: 
+Description:
 
-This is an elaborate and /slow/ version of the Mesh class from Graphics for Games.
+This is an elaborate version of the Mesh class from Graphics for Games.
 It keeps track of faces, vertices and edges of a given mesh aswell as all the adjancy
 information.
 
-This means that you can retrieve a face and instanty have a list of all of it's 
+This means that you can retrieve a face and instanty have a list of all of it's
 adjancent faces and contained vertices/edges without having to do expensive lookups.
-Yep.. the expensive part is that these are all precomputed when the hull is first created O(n^3).
 
-They can be quite useful for debugging shapes and experimenting with new 3D algorithms. 
-In this framework they are used to represent discrete collision shapes which have distinct non-curved, 
+A hull is built by adding all of its vertices and faces, and then calling Finalize(). This
+works out all the edges (found through a hash table) and the adjacency between everything,
+after which the hull is read only. Each kind of adjacency is stored as one packed array of
+indices along with the offset of each vertex/edge/face's list into it ('compressed sparse
+row' form), so the whole hull lives in a handful of contiguous blocks of memory rather than
+a tiny heap allocation for every list.
+
+To build a hull from a cloud of points (such as the vertices of a loaded mesh) see QuickHull.
+
+They can be quite useful for debugging shapes and experimenting with new 3D algorithms.
+In this framework they are used to represent discrete collision shapes which have distinct non-curved,
 faces such as the CuboidCollisionShape.
 
 Note: One of the big changes from a normal Mesh is that the faces can have any number of vertices,
-so you could represent your mesh as a series of pentagons, quads etc or any combination of these. 
+so you could represent your mesh as a series of pentagons, quads etc or any combination of these.
 
 		(\_/)
 		( '_')
@@ -31,34 +39,28 @@ so you could represent your mesh as a series of pentagons, quads etc or any comb
 
 #include <nclgl\Vector3.h>
 #include <nclgl\Matrix4.h>
+#include <nclgl\Plane.h>
 #include <vector>
+#include <stdint.h>
 
-struct HullEdge;
-struct HullFace;
-
-struct HullVertex
+//A list of vertex/edge/face indices, pointing straight into one of the hull's packed arrays.
+// Can be used in range-based for loops, and is only valid for as long as the hull is.
+struct HullIndexList
 {
-	int idx;
-	Vector3 pos;
-	std::vector<int> enclosing_edges;
-	std::vector<int> enclosing_faces;
+	HullIndexList(const int* first, const int* last) : _first(first), _last(last) {}
+
+	const int* begin() const		{ return _first; }
+	const int* end() const			{ return _last; }
+	int size() const				{ return (int)(_last - _first); }
+	int operator[](int i) const		{ return _first[i]; }
+
+	const int* _first;
+	const int* _last;
 };
 
 struct HullEdge
 {
-	int idx;
 	int vStart, vEnd;
-	std::vector<int> adjoining_edge_ids;
-	std::vector<int> enclosing_faces;
-};
-
-struct HullFace
-{
-	int idx;
-	Vector3 _normal;
-	std::vector<int> vert_ids;
-	std::vector<int> edge_ids;
-	std::vector<int> adjoining_face_ids;
 };
 
 class Hull
@@ -68,35 +70,76 @@ public:
 	~Hull();
 
 	void AddVertex(const Vector3& v);
-	
 
+
+	//Vertices MUST be given in ccw winding order
 	void AddFace(const Vector3& _normal, int nVerts, const int* verts);
 	void AddFace(const Vector3& _normal, const std::vector<int>& vert_ids)		{ AddFace(_normal, vert_ids.size(), &vert_ids[0]); }
 
+	//Builds all of the edges and adjacency lists, after which no more vertices or faces
+	// can be added. Must be called before using any of the edge or adjacency queries.
+	void Finalize();
+	bool IsFinalized() const						{ return m_Finalized; }
+
 
-	int FindEdge(int v0_idx, int v1_idx);
-	
+	size_t GetNumVertices() const					{ return m_vVertexPositions.size(); }
+	size_t GetNumEdges() const						{ return m_vEdges.size(); }
+	size_t GetNumFaces() const						{ return m_vFaceNormals.size(); }
 
-	const HullVertex& GetVertex(int idx)		{ return m_vVertices[idx]; }
-	const HullEdge& GetEdge(int idx)			{ return m_vEdges[idx]; }
-	const HullFace& GetFace(int idx)			{ return m_vFaces[idx]; }
 
-	size_t GetNumVertices()					{ return m_vVertices.size(); }
-	size_t GetNumEdges()					{ return m_vEdges.size(); }
-	size_t GetNumFaces()					{ return m_vFaces.size(); }
+	//Positions of all vertices, packed together so they can be transformed in one go
+	const Vector3* GetVertexPositions() const		{ return m_vVertexPositions.data(); }
+	const Vector3& GetVertexPosition(int idx) const	{ return m_vVertexPositions[idx]; }
+	HullIndexList GetVertexEdges(int idx) const		{ return List(m_vVertexEdgeOffsets, m_vVertexEdges, idx); }
+	HullIndexList GetVertexFaces(int idx) const		{ return List(m_vVertexFaceOffsets, m_vVertexFaces, idx); }
 
+	const HullEdge& GetEdge(int idx) const			{ return m_vEdges[idx]; }
+	HullIndexList GetEdgeFaces(int idx) const		{ return List(m_vEdgeFaceOffsets, m_vEdgeFaces, idx); }
+	int FindEdge(int v0_idx, int v1_idx) const;
 
-	void GetMinMaxVerticesInAxis(const Vector3& local_axis, int* out_min_vert, int* out_max_vert);
+	const Vector3& GetFaceNormal(int idx) const		{ return m_vFaceNormals[idx]; }
+	HullIndexList GetFaceVertices(int idx) const	{ return List(m_vFaceVertexOffsets, m_vFaceVertices, idx); }
+	HullIndexList GetFaceEdges(int idx) const		{ return List(m_vFaceVertexOffsets, m_vFaceEdges, idx); }	//Edge i runs from vertex i-1 to vertex i
+	HullIndexList GetFaceAdjacentFaces(int idx) const { return List(m_vFaceAdjOffsets, m_vFaceAdjFaces, idx); }
 
+	//Plane of each face facing into the hull (to clip against), packed together so they can be
+	// transformed in one go with Plane::TransformPlanes. Built by Finalize().
+	const Plane* GetFacePlanes() const				{ return m_vFacePlanes.data(); }
 
-	void DebugDraw(const Matrix4& transform);
+
+	void GetMinMaxVerticesInAxis(const Vector3& local_axis, int* out_min_vert, int* out_max_vert) const;
+
+
+	void DebugDraw(const Matrix4& transform) const;
 
 protected:
-	int ConstructNewEdge(int parent_face_idx, int vert_start, int vert_end); //Called by AddFace
-	
+	static HullIndexList List(const std::vector<int>& offsets, const std::vector<int>& indices, int idx)
+	{
+		return HullIndexList(indices.data() + offsets[idx], indices.data() + offsets[idx + 1]);
+	}
+
+	//Same key for both directions of an edge
+	static uint64_t EdgeKey(int v0_idx, int v1_idx);
+
 protected:
-	std::vector<HullVertex>		m_vVertices;
-	std::vector<HullEdge>		m_vEdges;
-	std::vector<HullFace>		m_vFaces;
+	bool						m_Finalized;
+
+	//Each list 'i' is indices[offsets[i]] to indices[offsets[i + 1] - 1]
+	std::vector<Vector3>		m_vVertexPositions;
+	std::vector<int>			m_vVertexEdgeOffsets;
+	std::vector<int>			m_vVertexEdges;
+	std::vector<int>			m_vVertexFaceOffsets;
+	std::vector<int>			m_vVertexFaces;
 
-};
\ No newline at end of file
+	std::vector<HullEdge>		m_vEdges;
+	std::vector<int>			m_vEdgeFaceOffsets;
+	std::vector<int>			m_vEdgeFaces;
+
+	std::vector<Vector3>		m_vFaceNormals;
+	std::vector<Plane>			m_vFacePlanes;
+	std::vector<int>			m_vFaceVertexOffsets;		//Shared by the face vertex and edge lists
+	std::vector<int>			m_vFaceVertices;
+	std::vector<int>			m_vFaceEdges;
+	std::vector<int>			m_vFaceAdjOffsets;
+	std::vector<int>			m_vFaceAdjFaces;
+};
@@ -0,0 +1,290 @@
+#include "HullCollisionShape.h"
+#include "QuickHull.h"
+#include "PhysicsObject.h"
+#include "NCLDebug.h"
+
+#define HULL_PARALLEL_AXIS_TOLERANCE 1e-4f		//Face normals closer than this to (anti-)parallel give the same SAT axis
+
+HullCollisionShape::HullCollisionShape(const Vector3* points, size_t num_points)
+	: CollisionShape(COLLISION_SHAPE_GENERIC)
+	, m_Volume(0.0f)
+{
+	if (!QuickHull::Build(points, num_points, &m_Hull))
+	{
+		NCLERROR("HullCollisionShape: %d points don't enclose any volume", (int)num_points);
+	}
+
+	ComputeShapeProperties();
+}
+
+HullCollisionShape::~HullCollisionShape()
+{
+
+}
+
+void HullCollisionShape::ComputeShapeProperties()
+{
+	m_UnitInertia.ToZero();
+	m_AxisFaces.clear();
+	m_LocalCentre = Vector3(0.0f, 0.0f, 0.0f);
+	m_LocalHalfDims = Vector3(0.0f, 0.0f, 0.0f);
+
+	if (m_Hull.GetNumVertices() == 0)
+		return;
+
+	//Bounding box
+	Vector3 vMin = m_Hull.GetVertexPosition(0);
+	Vector3 vMax = vMin;
+	for (size_t i = 1; i < m_Hull.GetNumVertices(); ++i)
+	{
+		const Vector3& pos = m_Hull.GetVertexPosition(i);
+		vMin = Vector3(min(vMin.x, pos.x), min(vMin.y, pos.y), min(vMin.z, pos.z));
+		vMax = Vector3(max(vMax.x, pos.x), max(vMax.y, pos.y), max(vMax.z, pos.z));
+	}
+	m_LocalCentre = (vMin + vMax) * 0.5f;
+	m_LocalHalfDims = (vMax - vMin) * 0.5f;
+
+
+	//Split the hull into tetrahedra from the origin to each (fan triangulated) face and sum up their
+	// volumes and second moments (the integral of x*x^T over the volume). For a tetrahedron
+	// (0, a, b, c) that is det/120 * (aa^T + bb^T + cc^T + (a+b+c)(a+b+c)^T), with det = 6 * volume.
+	Matrix3 covariance = Matrix3::ZeroMatrix;
+	for (size_t i = 0; i < m_Hull.GetNumFaces(); ++i)
+	{
+		HullIndexList face = m_Hull.GetFaceVertices(i);
+		const Vector3& a = m_Hull.GetVertexPosition(face[0]);
+		for (int j = 2; j < face.size(); ++j)
+		{
+			const Vector3& b = m_Hull.GetVertexPosition(face[j - 1]);
+			const Vector3& c = m_Hull.GetVertexPosition(face[j]);
+
+			float det = Vector3::Dot(a, Vector3::Cross(b, c));
+			Vector3 sum = a + b + c;
+
+			m_Volume += det / 6.0f;
+			covariance += (Matrix3::OuterProduct(a, a) + Matrix3::OuterProduct(b, b)
+				+ Matrix3::OuterProduct(c, c) + Matrix3::OuterProduct(sum, sum)) * (det / 120.0f);
+		}
+	}
+
+	if (m_Volume > 0.0f)
+	{
+		covariance *= 1.0f / m_Volume;
+		m_UnitInertia = Matrix3::Identity * covariance.Trace() - covariance;
+	}
+
+
+	//SAT only needs to check one of any faces that are parallel to each other
+	for (size_t i = 0; i < m_Hull.GetNumFaces(); ++i)
+	{
+		const Vector3& normal = m_Hull.GetFaceNormal(i);
+
+		bool found = false;
+		for (int axisFace : m_AxisFaces)
+		{
+			if (fabs(Vector3::Dot(normal, m_Hull.GetFaceNormal(axisFace))) >= 1.0f - HULL_PARALLEL_AXIS_TOLERANCE)
+			{
+				found = true;
+				break;
+			}
+		}
+
+		if (!found)
+			m_AxisFaces.push_back(i);
+	}
+}
+
+Matrix3 HullCollisionShape::BuildInverseInertia(float invMass) const
+{
+	if (m_Volume <= 0.0f)
+		return Matrix3::ZeroMatrix;
+
+	return Matrix3::Inverse(m_UnitInertia) * invMass;
+}
+
+void HullCollisionShape::GetWorldSpaceAABB(const PhysicsObject* currentObject, BoundingBox* out_aabb) const
+{
+	// Same as the cuboid, only around the hull's local bounding box
+	const Matrix3& rot = currentObject->GetRotation();
+	const Vector3& h = m_LocalHalfDims;
+
+	Vector3 extents = Vector3(
+		fabs(rot(0, 0)) * h.x + fabs(rot(0, 1)) * h.y + fabs(rot(0, 2)) * h.z,
+		fabs(rot(1, 0)) * h.x + fabs(rot(1, 1)) * h.y + fabs(rot(1, 2)) * h.z,
+		fabs(rot(2, 0)) * h.x + fabs(rot(2, 1)) * h.y + fabs(rot(2, 2)) * h.z);
+
+	Vector3 centre = currentObject->GetPosition() + rot * m_LocalCentre;
+	out_aabb->_min = centre - extents;
+	out_aabb->_max = centre + extents;
+}
+
+void HullCollisionShape::BuildWorldSpaceHull(const PhysicsObject* currentObject, WorldSpaceHull* out_hull) const
+{
+	const Matrix4& wsTransform = currentObject->GetWorldSpaceTransform();
+
+	//Only allocates the first time, after that the arrays are just overwritten
+	out_hull->vertices.resize(m_Hull.GetNumVertices());
+	out_hull->faceNormals.resize(m_Hull.GetNumFaces());
+	out_hull->facePlanes.resize(m_Hull.GetNumFaces());
+
+	if (m_Hull.GetNumVertices() == 0)
+		return;
+
+	wsTransform.TransformPoints(m_Hull.GetVertexPositions(), &out_hull->vertices[0], m_Hull.GetNumVertices());
+
+	//The object's transform is only a rotation and translation, so the rotation is its own normal matrix
+	Plane::TransformPlanes(Matrix3(wsTransform), wsTransform.GetPositionVector(),
+		m_Hull.GetFacePlanes(), &out_hull->facePlanes[0], m_Hull.GetNumFaces());
+
+	for (unsigned int i = 0; i < m_Hull.GetNumFaces(); ++i)
+	{
+		out_hull->faceNormals[i] = -out_hull->facePlanes[i].GetNormal();
+	}
+}
+
+void HullCollisionShape::GetCollisionAxes(const PhysicsObject* currentObject, std::vector<Vector3>* out_axes) const
+{
+	if (out_axes)
+	{
+		const WorldSpaceHull& hull = currentObject->GetWorldSpaceHull();
+		for (int faceIdx : m_AxisFaces)
+		{
+			out_axes->push_back(hull.faceNormals[faceIdx]);
+		}
+	}
+}
+
+void HullCollisionShape::GetEdges(const PhysicsObject* currentObject, std::vector<CollisionEdge>* out_edges) const
+{
+	if (out_edges)
+	{
+		const WorldSpaceHull& hull = currentObject->GetWorldSpaceHull();
+		for (unsigned int i = 0; i < m_Hull.GetNumEdges(); ++i)
+		{
+			const HullEdge& edge = m_Hull.GetEdge(i);
+			out_edges->push_back(CollisionEdge(hull.vertices[edge.vStart], hull.vertices[edge.vEnd]));
+		}
+	}
+}
+
+Vector3 HullCollisionShape::GetSupportPoint(const PhysicsObject* currentObject, const Vector3& axis) const
+{
+	const WorldSpaceHull& hull = currentObject->GetWorldSpaceHull();
+	if (hull.vertices.empty())
+		return currentObject->GetPosition();
+
+	int vMax;
+	GetMinMaxVerticesInAxis(hull, axis, NULL, &vMax);
+	return hull.vertices[vMax];
+}
+
+void HullCollisionShape::GetMinMaxVertexOnAxis(
+	const PhysicsObject* currentObject,
+	const Vector3& axis,
+	Vector3* out_min,
+	Vector3* out_max) const
+{
+	const WorldSpaceHull& hull = currentObject->GetWorldSpaceHull();
+	if (hull.vertices.empty())
+	{
+		if (out_min) *out_min = currentObject->GetPosition();
+		if (out_max) *out_max = currentObject->GetPosition();
+		return;
+	}
+
+	int vMin, vMax;
+	GetMinMaxVerticesInAxis(hull, axis, &vMin, &vMax);
+
+	if (out_min) *out_min = hull.vertices[vMin];
+	if (out_max) *out_max = hull.vertices[vMax];
+}
+
+void HullCollisionShape::GetIncidentReferencePolygon(
+	const PhysicsObject* currentObject,
+	const Vector3& axis,
+	ContactPolygon* out_face,
+	Vector3* out_normal,
+	ContactClipPlanes* out_adjacent_planes) const
+{
+	const WorldSpaceHull& hull = currentObject->GetWorldSpaceHull();
+	if (hull.vertices.empty())
+		return;
+
+	//Exactly as CuboidCollisionShape - the face around the furthest vertex along the
+	// axis whose normal is closest to parallel with it..
+	int maxVertex;
+	GetMinMaxVerticesInAxis(hull, axis, NULL, &maxVertex);
+
+	int best_face = 0;
+	float best_correlation = -FLT_MAX;
+	for (int faceIdx : m_Hull.GetVertexFaces(maxVertex))
+	{
+		float temp_correlation = Vector3::Dot(axis, hull.faceNormals[faceIdx]);
+		if (temp_correlation > best_correlation)
+		{
+			best_correlation = temp_correlation;
+			best_face = faceIdx;
+		}
+	}
+
+	if (out_normal)
+	{
+		*out_normal = hull.faceNormals[best_face];
+	}
+
+	if (out_face)
+	{
+		for (int vertIdx : m_Hull.GetFaceVertices(best_face))
+		{
+			out_face->Add(hull.vertices[vertIdx]);
+		}
+	}
+
+	//..clipped by its own plane and those of the faces across each of its edges
+	if (out_adjacent_planes)
+	{
+		out_adjacent_planes->Add(hull.facePlanes[best_face]);
+
+		for (int edgeIdx : m_Hull.GetFaceEdges(best_face))
+		{
+			for (int adjFaceIdx : m_Hull.GetEdgeFaces(edgeIdx))
+			{
+				if (adjFaceIdx != best_face)
+				{
+					out_adjacent_planes->Add(hull.facePlanes[adjFaceIdx]);
+				}
+			}
+		}
+	}
+}
+
+void HullCollisionShape::GetMinMaxVerticesInAxis(const WorldSpaceHull& hull, const Vector3& axis, int* out_min_vert, int* out_max_vert)
+{
+	float minCorrelation = FLT_MAX, maxCorrelation = -FLT_MAX;
+	int minVertex = 0, maxVertex = 0;
+
+	for (size_t i = 0; i < hull.vertices.size(); ++i)
+	{
+		float cCorrelation = Vector3::Dot(axis, hull.vertices[i]);
+
+		if (cCorrelation > maxCorrelation)
+		{
+			maxCorrelation = cCorrelation;
+			maxVertex = i;
+		}
+
+		if (cCorrelation <= minCorrelation)
+		{
+			minCorrelation = cCorrelation;
+			minVertex = i;
+		}
+	}
+
+	if (out_min_vert) *out_min_vert = minVertex;
+	if (out_max_vert) *out_max_vert = maxVertex;
+}
+
+void HullCollisionShape::DebugDraw(const PhysicsObject* currentObject) const
+{
+	m_Hull.DebugDraw(currentObject->GetWorldSpaceTransform());
+}
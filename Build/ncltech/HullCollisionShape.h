@@ -0,0 +1,92 @@
+/******************************************************************************
+Class: HullCollisionShape
+Implements: CollisionShape
+Description: A convex collision shape of any form, built from the convex hull
+of a set of points - e.g. the vertices of a mesh loaded from an OBJ file:
+
+	OBJMesh* mesh = new OBJMesh(MESHDIR"rock.obj");
+	obj->SetCollisionShape(new HullCollisionShape(mesh->GetVertices(), mesh->GetNumVertices()));
+
+The hull is built once with QuickHull when the shape is created, and then works
+in the same way as the cuboid's: it's transformed into world space (once per
+step, see PhysicsObject::GetWorldSpaceHull) and its faces are clipped against
+each other to find contact points. Collisions themselves are found by
+CollisionDetectionGJK through the shape's support function.
+
+The inertia tensor is integrated over the volume of the hull, assuming it is a
+solid of uniform density.
+******************************************************************************/
+#pragma once
+
+#include "CollisionShape.h"
+#include "Hull.h"
+#include <nclgl\Matrix3.h>
+
+class HullCollisionShape : public CollisionShape
+{
+public:
+	//Builds the convex hull of the given points, which are relative to the centre of mass
+	// of the object. If they don't enclose any volume the shape is left empty and never collides.
+	HullCollisionShape(const Vector3* points, size_t num_points);
+	virtual ~HullCollisionShape();
+
+	const Hull& GetHull() const { return m_Hull; }
+
+	// Debug Collision Shape
+	virtual void DebugDraw(const PhysicsObject* currentObject) const override;
+
+
+	// Build Inertia Matrix for rotational mass
+	virtual Matrix3 BuildInverseInertia(float invMass) const override;
+
+	// Hull vertices, normals and face planes moved into world-space
+	virtual void BuildWorldSpaceHull(const PhysicsObject* currentObject, WorldSpaceHull* out_hull) const override;
+
+	// World-space bounding box used by the broadphase
+	virtual void GetWorldSpaceAABB(const PhysicsObject* currentObject, BoundingBox* out_aabb) const override;
+
+
+	// Support function used by CollisionDetectionGJK
+	virtual Vector3 GetSupportPoint(
+		const PhysicsObject* currentObject,
+		const Vector3& axis) const override;
+
+	// Generic Collision Detection Routines
+	virtual void GetCollisionAxes(
+		const PhysicsObject* currentObject,
+		std::vector<Vector3>* out_axes) const override;
+
+	virtual void GetEdges(
+		const PhysicsObject* currentObject,
+		std::vector<CollisionEdge>* out_edges) const override;
+
+	virtual void GetMinMaxVertexOnAxis(
+		const PhysicsObject* currentObject,
+		const Vector3& axis,
+		Vector3* out_min,
+		Vector3* out_max) const override;
+
+	virtual void GetIncidentReferencePolygon(
+		const PhysicsObject* currentObject,
+		const Vector3& axis,
+		ContactPolygon* out_face,
+		Vector3* out_normal,
+		ContactClipPlanes* out_adjacent_planes) const override;
+
+protected:
+	//Integrates the volume and inertia of the hull, and finds its bounds and unique face normals
+	void ComputeShapeProperties();
+
+	//Closest and furthest of the world-space vertices along a world-space axis
+	static void GetMinMaxVerticesInAxis(const WorldSpaceHull& hull, const Vector3& axis, int* out_min_vert, int* out_max_vert);
+
+protected:
+	Hull				m_Hull;
+	std::vector<int>	m_AxisFaces;		//One face for each distinct (non-parallel) face normal
+
+	Matrix3				m_UnitInertia;		//Inertia tensor for a mass of 1, about the object's origin
+	float				m_Volume;
+
+	Vector3				m_LocalCentre;		//Local space bounding box of the hull
+	Vector3				m_LocalHalfDims;
+};
@@ -0,0 +1,111 @@
+/******************************************************************************
+Class: JacobianRow
+Description: One row of a constraint between two objects - a direction to push
+them apart along, at an offset from each of their centres of mass.
+
+Everything about the row that doesn't change while the solver iterates (the
+angular parts of the jacobian, how much each object's angular velocity changes
+for a unit impulse and the effective mass) is built once in PreSolverStep. Each
+iteration then only needs a handful of dot products to find the relative
+velocity along the row, and a couple of multiply-adds to apply the impulse (see
+VelocityDelta::ApplyImpulse).
+
+The same rows are used by the position correction pass, which pushes the objects'
+positions apart rather than their velocities.
+******************************************************************************/
+#pragma once
+
+#include "PhysicsObject.h"
+#include <nclgl\Vector3.h>
+
+//Nonlinear gauss-seidel position correction (PhysicsEngine::SolvePositions)
+#define NGS_BAUMGARTE_SCALAR	0.2f	//Fraction of the remaining error removed by each position iteration
+#define NGS_SLOP				0.005f	//Error left alone, so that resting contacts stay touching from one frame to the next
+#define NGS_MAX_CORRECTION		0.2f	//Furthest (m) a single row can move the objects per iteration, to avoid overshooting
+
+//Any unit vector perpendicular to the given (unit) one
+inline Vector3 GetPerpendicular(const Vector3& v)
+{
+	//Cross with whichever axis is furthest from being parallel
+	Vector3 p = (fabs(v.x) > 0.57735f) ? Vector3(v.y, -v.x, 0.0f) : Vector3(0.0f, v.z, -v.y);
+	p.Normalise();
+	return p;
+}
+
+struct JacobianRow
+{
+	Vector3	linear;				//Direction of the impulse - applied to A, and the opposite way to B
+	Vector3	angularA;			//r1 x linear
+	Vector3	angularB;			//r2 x linear
+	Vector3	impulseAngularA;	//Change in A's angular velocity for a unit impulse (world inverse inertia * angularA)
+	Vector3	impulseAngularB;
+	float	invMassA;
+	float	invMassB;
+	float	effectiveMass;		//1 / (J * M^-1 * J^T), or zero if neither object can move
+
+	void Build(const PhysicsObject* objA, const PhysicsObject* objB, const Vector3& dir, const Vector3& r1, const Vector3& r2)
+	{
+		linear = dir;
+		angularA = Vector3::Cross(r1, dir);
+		angularB = Vector3::Cross(r2, dir);
+		impulseAngularA = objA->GetWorldInverseInertia() * angularA;
+		impulseAngularB = objB->GetWorldInverseInertia() * angularB;
+		invMassA = objA->GetInverseMass();
+		invMassB = objB->GetInverseMass();
+
+		float k = invMassA + invMassB
+			+ Vector3::Dot(angularA, impulseAngularA)
+			+ Vector3::Dot(angularB, impulseAngularB);
+		effectiveMass = (k > 0.0f) ? 1.0f / k : 0.0f;
+	}
+
+	//Row that only constrains rotation - the relative angular velocity about the axis
+	void BuildAngular(const PhysicsObject* objA, const PhysicsObject* objB, const Vector3& axis)
+	{
+		linear = Vector3(0.0f, 0.0f, 0.0f);
+		angularA = axis;
+		angularB = axis;
+		impulseAngularA = objA->GetWorldInverseInertia() * axis;
+		impulseAngularB = objB->GetWorldInverseInertia() * axis;
+		invMassA = objA->GetInverseMass();
+		invMassB = objB->GetInverseMass();
+
+		float k = Vector3::Dot(axis, impulseAngularA) + Vector3::Dot(axis, impulseAngularB);
+		effectiveMass = (k > 0.0f) ? 1.0f / k : 0.0f;
+	}
+
+	//Entry of the effective mass matrix (J * M^-1 * J^T) coupling this row with another
+	float GetCoupling(const JacobianRow& other) const
+	{
+		return (invMassA + invMassB) * Vector3::Dot(linear, other.linear)
+			+ Vector3::Dot(angularA, other.impulseAngularA)
+			+ Vector3::Dot(angularB, other.impulseAngularB);
+	}
+
+	//Velocity of A relative to B along the row (J * v)
+	float GetRelativeVelocity(const PhysicsObject* objA, const PhysicsObject* objB) const
+	{
+		return Vector3::Dot(linear, objA->GetLinearVelocity() - objB->GetLinearVelocity())
+			+ Vector3::Dot(angularA, objA->GetAngularVelocity())
+			- Vector3::Dot(angularB, objB->GetAngularVelocity());
+	}
+
+	//Same as above, for the displacements made so far by the position correction pass - i.e. how
+	// far A has moved along the row relative to B since the pass started
+	float GetRelativeCorrection(const PhysicsObject* objA, const PhysicsObject* objB) const
+	{
+		return Vector3::Dot(linear, objA->GetLinearCorrection() - objB->GetLinearCorrection())
+			+ Vector3::Dot(angularA, objA->GetAngularCorrection())
+			- Vector3::Dot(angularB, objB->GetAngularCorrection());
+	}
+
+	//Moves the objects as VelocityDelta::ApplyImpulse would change their velocities
+	void ApplyCorrection(PhysicsObject* objA, PhysicsObject* objB, float impulse) const
+	{
+		if (invMassA > 0.0f)
+			objA->AddCorrection(linear * (impulse * invMassA), impulseAngularA * impulse);
+
+		if (invMassB > 0.0f)
+			objB->AddCorrection(linear * (-impulse * invMassB), impulseAngularB * -impulse);
+	}
+};
@@ -5,12 +5,10 @@
 
 #define persistentThresholdSq 0.025f
 
-typedef std::list<ContactPoint> ContactList;
-typedef ContactList::iterator ContactListItr;
-
 Manifold::Manifold() 
 	: m_pNodeA(NULL)
 	, m_pNodeB(NULL)
+	, m_FrictionCoef(0.0f)
 {
 }
 
@@ -21,151 +19,127 @@ Manifold::~Manifold()
 
 void Manifold::Initiate(PhysicsObject* nodeA, PhysicsObject* nodeB)
 {
+	if (nodeA == m_pNodeA && nodeB == m_pNodeB)
+	{
+		m_vPrevContacts.swap(m_vContacts);
+	}
+	else
+	{
+		m_vPrevContacts.clear();
+	}
 	m_vContacts.clear();
 
 	m_pNodeA = nodeA;
 	m_pNodeB = nodeB;
 }
 
-void Manifold::ApplyImpulse()
+float Manifold::ApplyImpulse(float factor)
 {
 	/* TUT 6 CODE HERE */
+	float residual = 0.0f;
 	for (ContactPoint & contact : m_vContacts)
 	{
-		SolveContactPoint(contact);
+		float change = SolveContactPoint(contact, factor);
+		residual = max(residual, change);
 	}
+	return residual;
 }
 
 
-void Manifold::SolveContactPoint(ContactPoint& c)
+float Manifold::SolveContactPoint(ContactPoint& c, float factor)
 {
 	/* TUT 6 CODE HERE */
-	if (m_pNodeA -> GetInverseMass() + m_pNodeB -> GetInverseMass() == 0.0f)
-	return;
-	
-	Vector3 r1 = c.relPosA;
-	Vector3 r2 = c.relPosB;
-	
-	Vector3 v0 = m_pNodeA -> GetLinearVelocity()
-	+ Vector3::Cross(m_pNodeA -> GetAngularVelocity(), r1);
-	Vector3 v1 = m_pNodeB -> GetLinearVelocity()
-	+ Vector3::Cross(m_pNodeB -> GetAngularVelocity(), r2);
-	
-	Vector3 normal = c.collisionNormal;
-	Vector3 dv = v0 - v1;
+	if (c.normalRow.effectiveMass == 0.0f)
+		return 0.0f;
+
+	float residual = 0.0f;
 
 	// Collision Resolution
 	{
-		float constraintMass = (m_pNodeA -> GetInverseMass()
-			+ m_pNodeB -> GetInverseMass())
-			+ Vector3::Dot(normal,
-			Vector3::Cross(m_pNodeA -> GetInverseInertia()
-			* Vector3::Cross(r1, normal), r1)
-			+ Vector3::Cross(m_pNodeB -> GetInverseInertia()
-			* Vector3::Cross(r2, normal), r2));
-		// Baumgarte Offset ( Adds energy to the system to counter
-		// slight solving errors that accumulate over time
-		// called as constraint drift )
-		
-		float b = 0.0f;
-		{
-			float distance_offset = c.collisionPenetration;
-			float baumgarte_scalar = 0.3f; // Amount of force to
-			// add to the system to solve error
-			
-			float baumgarte_slop = 0.001f; // Amount of a l l o w e d
-			// penetration , ensures a complete manifold each frame
-			
-			float penetration_slop =
-			min(c.collisionPenetration + baumgarte_slop, 0.0f);
-			
-			b = -(baumgarte_scalar
-			/ PhysicsEngine::Instance() -> GetDeltaTime())
-			* penetration_slop;
-		}
-
-		float b_real = max(b, c.elatisity_term + b * 0.2f);
-		float jn = -(Vector3::Dot(dv, normal) + b_real) / constraintMass;
+		float jn = -(c.normalRow.GetRelativeVelocity(m_pNodeA, m_pNodeB) + c.bias) * c.normalRow.effectiveMass * factor;
 
 		//jn = min(jn, 0.0f);
 		float oldSumImpulseContact = c.sumImpulseContact;
 		c.sumImpulseContact = min(c.sumImpulseContact + jn, 0.0f);
 		jn = c.sumImpulseContact - oldSumImpulseContact;
 
-		m_pNodeA -> SetLinearVelocity(m_pNodeA -> GetLinearVelocity()
-		+ normal * (jn * m_pNodeA -> GetInverseMass()));
-		m_pNodeB -> SetLinearVelocity(m_pNodeB -> GetLinearVelocity()
-		- normal * (jn * m_pNodeB -> GetInverseMass()));
-		
-		m_pNodeA -> SetAngularVelocity(m_pNodeA -> GetAngularVelocity()
-		+ m_pNodeA -> GetInverseInertia()
-		* Vector3::Cross(r1, normal * jn));
-		m_pNodeB -> SetAngularVelocity(m_pNodeB -> GetAngularVelocity()
-		- m_pNodeB -> GetInverseInertia()
-		* Vector3::Cross(r2, normal * jn));
+		m_VelocityDelta.ApplyImpulse(m_pNodeA, m_pNodeB, c.normalRow, jn);
+		residual = fabs(jn);
 	}
 	// Friction
 	{
-		Vector3 tangent = dv - normal * Vector3::Dot(dv, normal);
-		float tangent_len = tangent.Length();
-		
-		if (tangent_len > 0.001f)
+		// Clamp friction to never apply more force than the main collision
+		// resolution force
+		float maxJt = m_FrictionCoef * c.sumImpulseContact;
+
+		for (int i = 0; i < 2; ++i)
 		{
-			tangent = tangent * (1.0f / tangent_len);
-			
-			float frictionalMass =
-			(m_pNodeA -> GetInverseMass()
-			+ m_pNodeB -> GetInverseMass())
-			+ Vector3::Dot(tangent,
-			Vector3::Cross(m_pNodeA -> GetInverseInertia()
-			* Vector3::Cross(r1, tangent), r1)
-			+ Vector3::Cross(m_pNodeB -> GetInverseInertia()
-			* Vector3::Cross(r2, tangent), r2));
-			
-			float frictionCoef = sqrtf(m_pNodeA -> GetFriction()
-			* m_pNodeB -> GetFriction());
-			
-			float jt = -1 * frictionCoef * Vector3::Dot(dv, tangent)
-			/ frictionalMass;
-			
-			// Clamp friction to never apply more force than the main collision
-			// resolution force
-			
-			float oldImpulseTangent = c.sumImpulseFriction; //( < - - This should
-			// be a float not a Vector3 )
-			float maxJt = frictionCoef * c.sumImpulseContact;
-			c.sumImpulseFriction =
-			min(max(oldImpulseTangent + jt, maxJt), -maxJt);
-			jt = c.sumImpulseFriction - oldImpulseTangent;
-
-			m_pNodeA -> SetLinearVelocity(m_pNodeA -> GetLinearVelocity()
-			+ tangent *(jt * m_pNodeA -> GetInverseMass()));
-			m_pNodeB -> SetLinearVelocity(m_pNodeB -> GetLinearVelocity()
-			 - tangent *(jt * m_pNodeB -> GetInverseMass()));
-			
-			m_pNodeA -> SetAngularVelocity(m_pNodeA -> GetAngularVelocity()
-			+ m_pNodeA -> GetInverseInertia()
-			* Vector3::Cross(r1, tangent * jt));
-			m_pNodeB -> SetAngularVelocity(m_pNodeB -> GetAngularVelocity()
-			- m_pNodeB -> GetInverseInertia()
-			* Vector3::Cross(r2, tangent * jt));
-		 }
+			const JacobianRow& row = c.frictionRows[i];
+
+			float jt = -m_FrictionCoef * row.GetRelativeVelocity(m_pNodeA, m_pNodeB) * row.effectiveMass * factor;
+
+			float oldImpulseTangent = c.sumImpulseFriction[i];
+			c.sumImpulseFriction[i] = min(max(oldImpulseTangent + jt, maxJt), -maxJt);
+			jt = c.sumImpulseFriction[i] - oldImpulseTangent;
+
+			m_VelocityDelta.ApplyImpulse(m_pNodeA, m_pNodeB, row, jt);
+		}
 	}
+	return residual;
 }
 
-void Manifold::PreSolverStep(float dt)
+void Manifold::PreSolverStep(float dt, bool velocity_baumgarte)
 {
+	m_FrictionCoef = sqrtf(m_pNodeA->GetFriction() * m_pNodeB->GetFriction());
+
 	for (ContactPoint& contact : m_vContacts)
 	{
-		UpdateConstraint(contact);
+		MatchPersistentContact(contact);
+		UpdateConstraint(contact, dt, velocity_baumgarte);
 	}
+	m_vPrevContacts.clear();
 }
 
-void Manifold::UpdateConstraint(ContactPoint& contact)
+void Manifold::MatchPersistentContact(ContactPoint& contact)
 {
-	//Reset total impulse forces computed this physics timestep 
+	//Find the closest contact from last frame (in the local space of both objects)
+	// and carry over its accumulated impulse as a starting guess for this frame.
 	contact.sumImpulseContact = 0.0f;
-	contact.sumImpulseFriction = 0.0f;
+
+	float best_distsq = persistentThresholdSq;
+	for (const ContactPoint& prev : m_vPrevContacts)
+	{
+		Vector3 da = prev.localPosA - contact.localPosA;
+		Vector3 db = prev.localPosB - contact.localPosB;
+		float distsq = max(Vector3::Dot(da, da), Vector3::Dot(db, db));
+
+		if (distsq < best_distsq)
+		{
+			best_distsq = distsq;
+			contact.sumImpulseContact = prev.sumImpulseContact;
+		}
+	}
+}
+
+void Manifold::WarmStart()
+{
+	for (ContactPoint& c : m_vContacts)
+	{
+		if (c.sumImpulseContact == 0.0f)
+			continue;
+
+		m_VelocityDelta.ApplyImpulse(m_pNodeA, m_pNodeB, c.normalRow, c.sumImpulseContact);
+	}
+}
+
+void Manifold::UpdateConstraint(ContactPoint& contact, float dt, bool velocity_baumgarte)
+{
+	//Reset friction impulse computed this physics timestep 
+	// - The contact impulse is kept, as it has been warm started from last frame.
+	//   Friction is not, as its tangents are picked again each step from the relative
+	//   velocity so there is no fixed direction to carry it over in.
+	contact.sumImpulseFriction[0] = 0.0f;
+	contact.sumImpulseFriction[1] = 0.0f;
 
 
 	/* TUT 6 CODE HERE */
@@ -207,6 +181,40 @@ void Manifold::UpdateConstraint(ContactPoint& contact)
 			contact.elatisity_term = elatisity_term;
 		}
 	}
+
+	// Baumgarte Offset ( Adds energy to the system to counter
+	// slight solving errors that accumulate over time
+	// called as constraint drift )
+	float b = 0.0f;
+	if (velocity_baumgarte)
+	{
+		float baumgarte_scalar = 0.3f; // Amount of force to
+		// add to the system to solve error
+
+		float baumgarte_slop = 0.001f; // Amount of a l l o w e d
+		// penetration , ensures a complete manifold each frame
+
+		float penetration_slop =
+		min(contact.collisionPenetration + baumgarte_slop, 0.0f);
+
+		b = -(baumgarte_scalar / dt) * penetration_slop;
+	}
+	contact.bias = max(b, contact.elatisity_term + b * 0.2f);
+
+
+	// Jacobians - the normal, and two tangents to apply friction along. The first
+	// is picked to oppose any sliding, so most of the friction goes along one row.
+	const Vector3& normal = contact.collisionNormal;
+	contact.normalRow.Build(m_pNodeA, m_pNodeB, normal, contact.relPosA, contact.relPosB);
+
+	Vector3 dv = m_pNodeA->GetLinearVelocity() + Vector3::Cross(m_pNodeA->GetAngularVelocity(), contact.relPosA)
+		- m_pNodeB->GetLinearVelocity() - Vector3::Cross(m_pNodeB->GetAngularVelocity(), contact.relPosB);
+	Vector3 tangent = dv - normal * Vector3::Dot(dv, normal);
+	float tangent_len = tangent.Length();
+
+	tangent = (tangent_len > 0.001f) ? tangent * (1.0f / tangent_len) : GetPerpendicular(normal);
+	contact.frictionRows[0].Build(m_pNodeA, m_pNodeB, tangent, contact.relPosA, contact.relPosB);
+	contact.frictionRows[1].Build(m_pNodeA, m_pNodeB, Vector3::Cross(normal, tangent), contact.relPosA, contact.relPosB);
 }
 
 void Manifold::AddContact(const Vector3& globalOnA, const Vector3& globalOnB, const Vector3& _normal, const float& _penetration)
@@ -222,6 +230,18 @@ void Manifold::AddContact(const Vector3& globalOnA, const Vector3& globalOnB, co
 	contact.relPosB = r2;
 	contact.collisionNormal = _normal;
 	contact.collisionPenetration = _penetration;
+	contact.sumImpulseContact = 0.0f;
+	contact.sumImpulseFriction[0] = 0.0f;
+	contact.sumImpulseFriction[1] = 0.0f;
+	contact.elatisity_term = 0.0f;
+	contact.bias = 0.0f;
+	contact.separationOffset = _penetration - Vector3::Dot(_normal, globalOnB - globalOnA);
+	contact.separation = _penetration;
+
+	//Store the contact in each object's local space, so it can be matched up with
+	// the same contact next frame even if the objects have moved.
+	contact.localPosA = Matrix3::Transpose(m_pNodeA->GetRotation()) * r1;
+	contact.localPosB = Matrix3::Transpose(m_pNodeB->GetRotation()) * r2;
 
 
 	//Check to see if we already contain a contact point almost in that location
@@ -257,6 +277,45 @@ void Manifold::AddContact(const Vector3& globalOnA, const Vector3& globalOnB, co
 		m_vContacts.push_back(contact);
 }
 
+void Manifold::PrePositionStep()
+{
+	for (ContactPoint& contact : m_vContacts)
+	{
+		//The contact points move with the objects, so measure the penetration between them again
+		Vector3 r1 = m_pNodeA->GetRotation() * contact.localPosA;
+		Vector3 r2 = m_pNodeB->GetRotation() * contact.localPosB;
+
+		Vector3 ab = (m_pNodeB->GetPosition() + r2) - (m_pNodeA->GetPosition() + r1);
+		contact.separation = contact.separationOffset + Vector3::Dot(contact.collisionNormal, ab);
+
+		contact.normalRow.Build(m_pNodeA, m_pNodeB, contact.collisionNormal, r1, r2);
+	}
+}
+
+float Manifold::SolvePosition()
+{
+	float max_error = 0.0f;
+	for (ContactPoint& c : m_vContacts)
+	{
+		if (c.normalRow.effectiveMass == 0.0f)
+			continue;
+
+		//Moving A towards B along the normal makes the penetration worse
+		float separation = c.separation - c.normalRow.GetRelativeCorrection(m_pNodeA, m_pNodeB);
+		float error = -(separation + NGS_SLOP);
+		if (error <= 0.0f)
+			continue;
+
+		max_error = max(max_error, error);
+
+		//Only ever pushes apart - unlike the velocity solver nothing is accumulated, the
+		// (linearised) penetration is just measured again each iteration
+		float correction = min(NGS_BAUMGARTE_SCALAR * error, NGS_MAX_CORRECTION);
+		c.normalRow.ApplyCorrection(m_pNodeA, m_pNodeB, -correction * c.normalRow.effectiveMass);
+	}
+	return max_error;
+}
+
 void Manifold::DebugDraw() const
 {
 	if (m_vContacts.size() > 0)
@@ -24,6 +24,8 @@ additional energy to the system or negate existing velocity.
 #pragma once
 
 #include "PhysicsObject.h"
+#include "VelocityDelta.h"
+#include "JacobianRow.h"
 #include <nclgl\Vector3.h>
 
 /* A contact constraint is actually the summation of a normal distance constraint
@@ -33,8 +35,7 @@ additional energy to the system or negate existing velocity.
 struct ContactPoint
 {
 	float   sumImpulseContact;
-	float	sumImpulseFriction;
-	//Vector3 sumImpulseFriction;
+	float	sumImpulseFriction[2];	//Along each of the two friction rows
 
 	float	elatisity_term;
 
@@ -43,6 +44,19 @@ struct ContactPoint
 
 	Vector3 relPosA;			//Position relative to objectA
 	Vector3 relPosB;			//Position relative to objectB
+
+	Vector3 localPosA;			//Position in objectA's local space - used to match contacts between frames
+	Vector3 localPosB;			//Position in objectB's local space
+
+	//Built once in PreSolverStep, so that solving the contact each iteration
+	// is just a few dot products and clamps
+	JacobianRow normalRow;
+	JacobianRow frictionRows[2];	//Two tangents, perpendicular to the normal and each other
+	float	bias;					//Separating velocity to aim for (baumgarte and elasticity terms)
+
+	//Position correction - the normal row is rebuilt for the objects' new positions first
+	float	separationOffset;		//Penetration minus the distance between the two contact points along the normal
+	float	separation;				//Penetration once the objects have been integrated
 };
 
 
@@ -54,14 +68,32 @@ public:
 	~Manifold();
 
 	//Initiate for collision pair
+	// - If the manifold was already used for this pair last frame, its contacts are
+	//   kept aside so their impulses can be carried over to any matching new contacts
 	void Initiate(PhysicsObject* nodeA, PhysicsObject* nodeB);
 
 	//Called whenever a new collision contact between A & B are found
 	void AddContact(const Vector3& globalOnA, const Vector3& globalOnB, const Vector3& _normal, const float& _penetration);	
 
-	//Sequentially solves each contact constraint
-	void ApplyImpulse();
-	void PreSolverStep(float dt);
+	//Sequentially solves each contact constraint - the change in each contact's impulse
+	// is scaled by 'factor' (used for relaxation by the jacobi solver). Returns the largest
+	// change made to any contact's accumulated impulse, for checking convergence.
+	float ApplyImpulse(float factor = 1.0f);
+
+	//If velocity_baumgarte is false, penetration is not fed back into the velocities
+	// and is left for the position correction pass instead
+	void PreSolverStep(float dt, bool velocity_baumgarte = true);
+
+	//Applies the impulses carried over from last frame - called once all manifolds
+	// have finished their PreSolverStep
+	void WarmStart();
+
+	//Position correction pass - after the objects have been integrated, PrePositionStep finds
+	// how far each contact still penetrates, and every iteration of SolvePosition then pushes
+	// the objects apart a bit more. Returns the largest penetration (past the slop) left before
+	// it was run.
+	void PrePositionStep();
+	float SolvePosition();
 	
 
 	//Debug draws the manifold surface area
@@ -70,12 +102,21 @@ public:
 	//Get the physics objects
 	PhysicsObject* NodeA() { return m_pNodeA; }
 	PhysicsObject* NodeB() { return m_pNodeB; }
+
+	size_t GetNumContacts() const { return m_vContacts.size(); }
+
+	//Where the impulses go - see VelocityDelta
+	VelocityDelta& GetVelocityDelta() { return m_VelocityDelta; }
 protected:
-	void SolveContactPoint(ContactPoint& c);
-	void UpdateConstraint(ContactPoint& c);
+	float SolveContactPoint(ContactPoint& c, float factor);
+	void UpdateConstraint(ContactPoint& c, float dt, bool velocity_baumgarte);
+	void MatchPersistentContact(ContactPoint& c);
 
 protected:
 	PhysicsObject*				m_pNodeA;
 	PhysicsObject*				m_pNodeB;
 	std::vector<ContactPoint>	m_vContacts;
+	std::vector<ContactPoint>	m_vPrevContacts;		//Last frame's contacts, only kept until PreSolverStep
+	VelocityDelta				m_VelocityDelta;
+	float						m_FrictionCoef;			//Combined friction of both objects, set in PreSolverStep
 };
\ No newline at end of file
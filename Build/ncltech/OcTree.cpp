@@ -3,198 +3,357 @@
 #include "PhysicsObject.h"
 #include "PhysicsEngine.h"
 
-OcTree::OcTree (Vector3 pos, float size, std::vector<PhysicsObject*> &v)
+OcTree::OcTree ()
+	: m_Root (OCTREE_NULL_NODE)
+	, m_FreeList (OCTREE_NULL_NODE)
+	, m_NumNodes (0)
+	, m_NumMoves (0)
 {
-	m_region = new AABB (pos, size);
-
-	m_parent = nullptr;
-
-	// The same meaning as m_physicsObjects = v;
-	// but this way is more clear
-	for (unsigned i = 0; i < v.size (); i++)
-		m_physicsObjects.push_back (v[i]);
 }
 
 OcTree::~OcTree ()
 {
-	//Delete ();
+	Clear ();
 }
 
-void OcTree::BulidOcTree ()
+void OcTree::AddObject (PhysicsObject* obj)
 {
-	if (m_physicsObjects.size () <= 1)
-		return;
-
-	if (m_region->GetSize ().x < 1.f)
+	if (m_EntryLookup.find (obj) != m_EntryLookup.end ())
 		return;
 
-	Vector3 size = m_region->GetSize ();
-	float radius = size.x / 2;	// every AABB is a cube
-	Vector3 AABBPos = m_region->GetPosition ();
-	Vector3 center = AABBPos + Vector3 (size.x / 2.0f, size.y / 2.0f, size.z / 2.0f);
-
-	// Divide the current region to subAABBs
-	AABB octant[8] {
-		AABB (AABBPos, radius),
-		AABB (Vector3 (AABBPos.x, AABBPos.y, AABBPos.z + radius), radius),
-		AABB (Vector3 (AABBPos.x + radius, AABBPos.y, AABBPos.z), radius),
-		AABB (Vector3 (AABBPos.x + radius, AABBPos.y, AABBPos.z + radius), radius),
+	// The object is placed into the tree on the next update, as it
+	// may not have been given a collision shape or position yet
+	OcTreeEntry entry;
+	entry.obj = obj;
+	entry.node = OCTREE_NULL_NODE;
+	entry.prev = OCTREE_NULL_NODE;
+	entry.next = OCTREE_NULL_NODE;
 
-		AABB (Vector3 (AABBPos.x, AABBPos.y + radius, AABBPos.z), radius),
-		AABB (Vector3 (AABBPos.x, AABBPos.y + radius, AABBPos.z + radius), radius),
-		AABB (Vector3 (AABBPos.x + radius, AABBPos.y + radius, AABBPos.z), radius),
-		AABB (Vector3 (AABBPos.x + radius, AABBPos.y + radius, AABBPos.z + radius), radius)
-	};
+	m_EntryLookup[obj] = m_Entries.size ();
+	m_Entries.push_back (entry);
+}
 
-	std::vector< std::vector <PhysicsObject*> > octantVectorArr;
+void OcTree::RemoveObject (PhysicsObject* obj)
+{
+	auto found_loc = m_EntryLookup.find (obj);
+	if (found_loc == m_EntryLookup.end ())
+		return;
 
-	for (int i = 0; i < 8; i++)
-		octantVectorArr.push_back (std::vector <PhysicsObject*> ());
+	int idx = (int)found_loc->second;
+	m_EntryLookup.erase (found_loc);
 
-	std::vector<int> deleteVector;
+	if (m_Entries[idx].node != OCTREE_NULL_NODE)
+		UnlinkEntry (idx);
 
-	// Check if some physics objects can be contained by subAABB
-	for (unsigned i = 0; i < m_physicsObjects.size (); i++)
+	// Swap with the last entry and pop, fixing up the links that pointed at it
+	int last = (int)m_Entries.size () - 1;
+	if (idx != last)
 	{
-		if (radius > 0.0f)
+		OcTreeEntry& moved = m_Entries[idx];
+		moved = m_Entries[last];
+		m_EntryLookup[moved.obj] = idx;
+
+		if (moved.node != OCTREE_NULL_NODE)
 		{
-			for (int j = 0; j < 8; j++)
-			{
-				if (octant[j].Contains (m_physicsObjects[i]))
-				{
-					octantVectorArr[j].push_back (m_physicsObjects[i]);
-					deleteVector.push_back (i);
-				}
-			}
+			if (moved.prev != OCTREE_NULL_NODE)
+				m_Entries[moved.prev].next = idx;
+			else
+				m_Nodes[moved.node].head = idx;
+
+			if (moved.next != OCTREE_NULL_NODE)
+				m_Entries[moved.next].prev = idx;
 		}
 	}
+	m_Entries.pop_back ();
+}
 
-	// Remove physical object which can be contained by subAABB from this OcTree
-	for (unsigned i = 0; i < deleteVector.size (); i++)
-	{
-		m_physicsObjects.erase (m_physicsObjects.begin () + (deleteVector[i] - i));
-	}
+void OcTree::Clear ()
+{
+	m_Nodes.clear ();
+	m_Root = OCTREE_NULL_NODE;
+	m_FreeList = OCTREE_NULL_NODE;
+	m_NumNodes = 0;
 
-	for (int i = 0; i < 8; i++)
+	m_Entries.clear ();
+	m_EntryLookup.clear ();
+}
+
+void OcTree::Update ()
+{
+	m_NumMoves = 0;
+
+	for (int i = 0; i < (int)m_Entries.size (); ++i)
 	{
-		if (octantVectorArr[i].size () > 0)
-		{
-			m_childNodes[i] = CreateNode (octant[i], octantVectorArr[i]);
-			m_childNodes[i]->m_parent = this;
-			m_childNodes[i]->BulidOcTree ();
-		}
-		else
+		OcTreeEntry& entry = m_Entries[i];
+
+		// Sleeping objects have not moved since they were last placed
+		if (entry.node != OCTREE_NULL_NODE && entry.obj->IsSleeping ())
+			continue;
+
+		entry.obj->GetWorldSpaceAABB (&entry.aabb);
+
+		if (entry.node != OCTREE_NULL_NODE)
 		{
-			m_childNodes[i] = nullptr;
+			// Still inside the loose bounds of the node - nothing to do
+			if (IsInLooseBounds (m_Nodes[entry.node], entry.aabb))
+				continue;
+
+			// Already as high up as it can go - reinserting would just put it straight back
+			if (entry.node == m_Root && !CanGrowRoot ())
+				continue;
+
+			UnlinkEntry (i);
+			m_NumMoves++;
 		}
+
+		InsertEntry (i);
 	}
 }
 
-OcTree* OcTree::CreateNode (AABB octant, std::vector<PhysicsObject*> &physicsObjectVector)
+void OcTree::GenerateCPs (std::vector<CollisionPair> &cpList)
 {
-	if (physicsObjectVector.size () == 0)
-		return nullptr;
+	if (m_Root == OCTREE_NULL_NODE)
+		return;
+
+	// Query the tree with each object's bounds in turn. As loose nodes overlap
+	// their neighbours, this has to descend into every node whose loose bounds
+	// touch the object - not just the object's own node and its parents.
+	// Pairs are only reported from the object with the lower index.
+	for (int i = 0; i < (int)m_Entries.size (); ++i)
+	{
+		const OcTreeEntry& entryA = m_Entries[i];
+		if (entryA.obj->GetCollisionShape () == NULL)
+			continue;
+
+		m_TraversalStack.clear ();
+		m_TraversalStack.push_back (m_Root);
+
+		while (!m_TraversalStack.empty ())
+		{
+			const int nodeIdx = m_TraversalStack.back ();
+			const OcTreeNode& node = m_Nodes[nodeIdx];
+			m_TraversalStack.pop_back ();
+
+			// The root is never culled, as objects beyond the furthest it can grow
+			// are still kept in it (outside of its loose bounds)
+			if (nodeIdx != m_Root && !GetLooseBounds (node).Intersects (entryA.aabb))
+				continue;
+
+			for (int j = node.head; j != OCTREE_NULL_NODE; j = m_Entries[j].next)
+			{
+				if (j <= i)
+					continue;
+
+				const OcTreeEntry& entryB = m_Entries[j];
 
-	OcTree* tree = new OcTree (octant.GetPosition (), octant.GetSize ().x, physicsObjectVector);
+				//Check they both atleast have collision shapes
+				if (entryB.obj->GetCollisionShape () != NULL
+					&& entryA.aabb.Intersects (entryB.aabb))
+				{
+					CollisionPair cp;
+					cp.pObjectA = entryA.obj;
+					cp.pObjectB = entryB.obj;
+					cpList.push_back (cp);
+				}
+			}
 
-	return tree;
+			for (int c = 0; c < 8; ++c)
+			{
+				if (node.children[c] != OCTREE_NULL_NODE)
+					m_TraversalStack.push_back (node.children[c]);
+			}
+		}
+	}
 }
 
 void OcTree::Draw ()
 {
-	for (int i = 0; i < 8; i++)
+	for (const OcTreeNode& node : m_Nodes)
 	{
-		if (m_childNodes[i])
-		{
-			m_childNodes[i]->Draw ();
-		}
-	}
+		// Skip nodes sitting in the free list
+		if (node.numObjects < 0)
+			continue;
 
-	m_region->Draw ();
+		Vector3 half = Vector3 (node.halfSize, node.halfSize, node.halfSize);
+		AABB cell (node.center - half, node.halfSize * 2.0f);
+		cell.Draw ();
+	}
 }
 
-void OcTree::Delete ()
+int OcTree::AllocateNode (const Vector3& center, float halfSize, int parent)
 {
-	for (int i = 0; i < 8; i++)
+	int idx;
+	if (m_FreeList != OCTREE_NULL_NODE)
 	{
-		if (m_childNodes[i])
-		{
-			m_childNodes[i]->Delete ();
-			delete m_childNodes[i];
-			m_childNodes[i] = NULL;
-		}
+		idx = m_FreeList;
+		m_FreeList = m_Nodes[idx].parent;
+	}
+	else
+	{
+		idx = (int)m_Nodes.size ();
+		m_Nodes.push_back (OcTreeNode ());
 	}
 
-	//for (unsigned i = 0; i < m_physicsObjects.size (); i++)
-	//{
-	//	delete m_physicsObjects[i];
-	//}
+	OcTreeNode& node = m_Nodes[idx];
+	node.center = center;
+	node.halfSize = halfSize;
+	node.parent = parent;
+	node.head = OCTREE_NULL_NODE;
+	node.numObjects = 0;
+	for (int i = 0; i < 8; ++i)
+		node.children[i] = OCTREE_NULL_NODE;
+
+	m_NumNodes++;
+	return idx;
+}
 
-	// just clean the vector do not need to delete m_physicsObjects[i]!!!! 
-	m_physicsObjects.clear();
+void OcTree::FreeNode (int node)
+{
+	m_Nodes[node].parent = m_FreeList;
+	m_Nodes[node].numObjects = -1;
+	m_FreeList = node;
 
-	//if (m_region)
-	//{
-		delete m_region;
-		m_region = NULL;
-	//}
+	m_NumNodes--;
 }
 
-void OcTree::GenerateCPs (std::vector<CollisionPair> &cpList)
+void OcTree::InsertEntry (int idx)
 {
-	// GenerateCPs recursively
-	for (int i = 0; i < 8; i++)
+	const BoundingBox& aabb = m_Entries[idx].aabb;
+	Vector3 center = (aabb._min + aabb._max) * 0.5f;
+	Vector3 half = (aabb._max - aabb._min) * 0.5f;
+	float radius = max (half.x, max (half.y, half.z));
+
+	if (m_Root == OCTREE_NULL_NODE)
+		m_Root = AllocateNode (Vector3 (0.0f, 0.0f, 0.0f), OCTREE_INITIAL_HALF_SIZE, OCTREE_NULL_NODE);
+
+	// Grow the root until the object fits inside it
+	while (!FitsInCell (m_Nodes[m_Root], center, radius) && CanGrowRoot ())
+		GrowRoot (center);
+
+	// Walk down into the child containing the object's centre for as long as
+	// the object is small enough to fit within that child's loose bounds. Objects
+	// the root could not grow to reach are left in the root itself.
+	int node = m_Root;
+	bool inRange = FitsInCell (m_Nodes[m_Root], center, radius);
+	while (inRange)
 	{
-		if (m_childNodes[i])
+		float childHalfSize = m_Nodes[node].halfSize * 0.5f;
+		if (childHalfSize < OCTREE_MIN_HALF_SIZE || radius > (OCTREE_LOOSENESS - 1.0f) * childHalfSize)
+			break;
+
+		int octant = GetOctant (m_Nodes[node].center, center);
+		int child = m_Nodes[node].children[octant];
+		if (child == OCTREE_NULL_NODE)
 		{
-			m_childNodes[i]->GenerateCPs (cpList);
+			Vector3 offset = Vector3 (
+				(octant & 1) ? childHalfSize : -childHalfSize,
+				(octant & 2) ? childHalfSize : -childHalfSize,
+				(octant & 4) ? childHalfSize : -childHalfSize);
+
+			child = AllocateNode (m_Nodes[node].center + offset, childHalfSize, node);
+			m_Nodes[node].children[octant] = child;
 		}
+		node = child;
 	}
 
-	PhysicsObject *m_pObj1, *m_pObj2;
+	// Link into the node's object list
+	OcTreeEntry& entry = m_Entries[idx];
+	OcTreeNode& n = m_Nodes[node];
+
+	entry.node = node;
+	entry.prev = OCTREE_NULL_NODE;
+	entry.next = n.head;
+	if (n.head != OCTREE_NULL_NODE)
+		m_Entries[n.head].prev = idx;
+	n.head = idx;
+	n.numObjects++;
+}
 
-	OcTree* parent = m_parent;
-	while (parent)
-	{
-		for (unsigned i = 0; i < m_physicsObjects.size (); i++)
-		{
-			// Check collision with parent's physicsObjects
-			for (unsigned j = 0; j < parent->m_physicsObjects.size(); ++j)
-			{
-				m_pObj1 = m_physicsObjects[i];
-				m_pObj2 = parent->m_physicsObjects[j];
+void OcTree::UnlinkEntry (int idx)
+{
+	OcTreeEntry& entry = m_Entries[idx];
+	int node = entry.node;
 
-				if (m_pObj1->GetCollisionShape() != NULL
-					&& m_pObj2->GetCollisionShape() != NULL)
-				{
-					CollisionPair cp;
-					cp.pObjectA = m_pObj1;
-					cp.pObjectB = m_pObj2;
-					cpList.push_back(cp);
-				}
-			}
-		}
+	if (entry.prev != OCTREE_NULL_NODE)
+		m_Entries[entry.prev].next = entry.next;
+	else
+		m_Nodes[node].head = entry.next;
 
-		parent = parent->m_parent;
-	}
+	if (entry.next != OCTREE_NULL_NODE)
+		m_Entries[entry.next].prev = entry.prev;
+
+	m_Nodes[node].numObjects--;
 
+	entry.node = OCTREE_NULL_NODE;
+	entry.prev = OCTREE_NULL_NODE;
+	entry.next = OCTREE_NULL_NODE;
 
-	for (unsigned i = 0; i < m_physicsObjects.size (); i++)
+	// Return any now empty leaf nodes to the pool
+	while (node != m_Root && m_Nodes[node].numObjects == 0)
 	{
-		for (unsigned j = i + 1; j < m_physicsObjects.size(); ++j)
+		const OcTreeNode& n = m_Nodes[node];
+		for (int i = 0; i < 8; ++i)
 		{
-			m_pObj1 = m_physicsObjects[i];
-			m_pObj2 = m_physicsObjects[j];
+			if (n.children[i] != OCTREE_NULL_NODE)
+				return;
+		}
 
-			//Check they both atleast have collision shapes
-			if (m_pObj1->GetCollisionShape() != NULL
-				&& m_pObj2->GetCollisionShape() != NULL)
-			{
-				CollisionPair cp;
-				cp.pObjectA = m_pObj1;
-				cp.pObjectB = m_pObj2;
-				cpList.push_back(cp);
-			}
+		int parent = n.parent;
+		for (int i = 0; i < 8; ++i)
+		{
+			if (m_Nodes[parent].children[i] == node)
+				m_Nodes[parent].children[i] = OCTREE_NULL_NODE;
 		}
+
+		FreeNode (node);
+		node = parent;
 	}
 }
+
+void OcTree::GrowRoot (const Vector3& towards)
+{
+	// The new root is twice the size, extending in the direction of the
+	// object, with the old root becoming one of its eight children
+	int oldRoot = m_Root;
+	Vector3 oldCenter = m_Nodes[oldRoot].center;
+	float halfSize = m_Nodes[oldRoot].halfSize;
+
+	Vector3 newCenter = Vector3 (
+		(towards.x >= oldCenter.x) ? oldCenter.x + halfSize : oldCenter.x - halfSize,
+		(towards.y >= oldCenter.y) ? oldCenter.y + halfSize : oldCenter.y - halfSize,
+		(towards.z >= oldCenter.z) ? oldCenter.z + halfSize : oldCenter.z - halfSize);
+
+	int newRoot = AllocateNode (newCenter, halfSize * 2.0f, OCTREE_NULL_NODE);
+	m_Nodes[newRoot].children[GetOctant (newCenter, oldCenter)] = oldRoot;
+	m_Nodes[oldRoot].parent = newRoot;
+	m_Root = newRoot;
+}
+
+bool OcTree::CanGrowRoot () const
+{
+	return m_Nodes[m_Root].halfSize < ldexpf (OCTREE_INITIAL_HALF_SIZE, OCTREE_MAX_GROW_STEPS);
+}
+
+bool OcTree::FitsInCell (const OcTreeNode& node, const Vector3& center, float radius) const
+{
+	return fabs (center.x - node.center.x) <= node.halfSize
+		&& fabs (center.y - node.center.y) <= node.halfSize
+		&& fabs (center.z - node.center.z) <= node.halfSize
+		&& radius <= (OCTREE_LOOSENESS - 1.0f) * node.halfSize;
+}
+
+bool OcTree::IsInLooseBounds (const OcTreeNode& node, const BoundingBox& aabb) const
+{
+	return GetLooseBounds (node).Contains (aabb);
+}
+
+BoundingBox OcTree::GetLooseBounds (const OcTreeNode& node) const
+{
+	float looseHalfSize = node.halfSize * OCTREE_LOOSENESS;
+	Vector3 half = Vector3 (looseHalfSize, looseHalfSize, looseHalfSize);
+
+	BoundingBox bb;
+	bb._min = node.center - half;
+	bb._max = node.center + half;
+	return bb;
+}
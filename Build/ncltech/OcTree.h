@@ -1,36 +1,106 @@
 /******************************************************************************
 Class: OcTree
 Implements: Yuchen Mei
-Description: Build and Delete every frame, basic and simple OcTree
+Description: Persistent loose OcTree broadphase. Each node's loose bounds are
+OCTREE_LOOSENESS times the size of its cell, so an object only has to fit its
+centre inside a cell (and be small enough) to be stored there. Objects stay in
+the same node until they leave its loose bounds, at which point they are moved
+to a new node - the tree itself is never rebuilt.
+
+Nodes come from a pool with a free list, empty leaf nodes are returned to it as
+objects leave, and the root grows (doubling in size) whenever an object falls
+outside of it, so there is no need to hard code the size of the world.
 ******************************************************************************/
 
 #pragma once
 
+#include "BoundingBox.h"
 #include <vector>
+#include <unordered_map>
 
-class AABB;
 class PhysicsObject;
 struct CollisionPair;
 
+#define OCTREE_NULL_NODE			-1
+#define OCTREE_LOOSENESS			2.0f	//Loose bounds = cell size * looseness
+#define OCTREE_INITIAL_HALF_SIZE	16.0f	//Half size of the root cell before it has to grow
+#define OCTREE_MIN_HALF_SIZE		0.5f	//Nodes are never subdivided smaller than this
+#define OCTREE_MAX_GROW_STEPS		16		//Stop growing the root past this (guards against objects flying off to infinity) - anything further out is kept in the root
+
 class OcTree
 {
 public:
-	OcTree (Vector3 pos, float size, std::vector<PhysicsObject*> &v);
+	OcTree ();
 	~OcTree ();
 
-	OcTree* CreateNode (AABB octant, std::vector<PhysicsObject*> &v);
-	
-	void BulidOcTree ();
+	//Add/Remove objects from the broadphase - called by the PhysicsEngine
+	void AddObject (PhysicsObject* obj);
+	void RemoveObject (PhysicsObject* obj);
+	void Clear ();
 
-	void Draw ();	
-	
-	void Delete ();
+	//Refreshes all object bounds, moving any object that has left the loose
+	// bounds of its node to a new node.
+	void Update ();
 
+	//Finds all pairs of objects whose bounds overlap and appends them
+	// (if both have collision shapes) to the given list.
 	void GenerateCPs (std::vector<CollisionPair> &cpList);
 
-private:
-	std::vector<PhysicsObject*> m_physicsObjects;
-	OcTree*						m_childNodes[8];
-	OcTree*						m_parent;
-	AABB*						m_region;
-};
\ No newline at end of file
+	//Draws the cell of every node in the tree
+	void Draw ();
+
+	int GetNumNodes () const			{ return m_NumNodes; }
+	int GetNumMoves () const			{ return m_NumMoves; }
+
+protected:
+	struct OcTreeNode
+	{
+		Vector3	center;
+		float	halfSize;			//Half size of the (tight) cell
+
+		int		parent;				//Also used as the 'next' index while in the free list
+		int		children[8];
+		int		head;				//First object stored in this node
+		int		numObjects;
+	};
+
+	struct OcTreeEntry
+	{
+		PhysicsObject*	obj;
+		BoundingBox		aabb;
+		int				node;
+		int				prev;		//Linked list of objects in the same node
+		int				next;
+	};
+
+	int  AllocateNode (const Vector3& center, float halfSize, int parent);
+	void FreeNode (int node);
+
+	void InsertEntry (int entry);
+	void UnlinkEntry (int entry);
+	void GrowRoot (const Vector3& towards);
+	bool CanGrowRoot () const;
+
+	bool FitsInCell (const OcTreeNode& node, const Vector3& center, float radius) const;
+	bool IsInLooseBounds (const OcTreeNode& node, const BoundingBox& aabb) const;
+	BoundingBox GetLooseBounds (const OcTreeNode& node) const;
+
+	static inline int GetOctant (const Vector3& nodeCenter, const Vector3& point)
+	{
+		return (point.x >= nodeCenter.x ? 1 : 0)
+			| (point.y >= nodeCenter.y ? 2 : 0)
+			| (point.z >= nodeCenter.z ? 4 : 0);
+	}
+
+protected:
+	std::vector<OcTreeNode>		m_Nodes;
+	int							m_Root;
+	int							m_FreeList;
+	int							m_NumNodes;
+
+	std::vector<OcTreeEntry>					m_Entries;
+	std::unordered_map<PhysicsObject*, size_t>	m_EntryLookup;		//PhysicsObject -> index into m_Entries
+
+	std::vector<int>			m_TraversalStack;	//Reused between frames to avoid allocations
+	int							m_NumMoves;
+};
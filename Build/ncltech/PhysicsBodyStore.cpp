@@ -0,0 +1,359 @@
+#include "PhysicsBodyStore.h"
+#include "PhysicsObject.h"
+#include <string.h>
+
+//The integration kernel loads/stores these directly as packed floats
+static_assert(sizeof(Vector3) == 3 * sizeof(float), "Vector3 must be tightly packed");
+static_assert(sizeof(Quaternion) == 4 * sizeof(float), "Quaternion must be tightly packed");
+
+PhysicsBodyStore::PhysicsBodyStore()
+{
+}
+
+PhysicsBodyStore::~PhysicsBodyStore()
+{
+}
+
+PhysicsBodyStore* PhysicsBodyStore::Detached()
+{
+	//Never deleted, as objects may still be destroyed (and removed from it) during static destruction
+	static PhysicsBodyStore* store = new PhysicsBodyStore();
+	return store;
+}
+
+int PhysicsBodyStore::AddBody(PhysicsObject* obj)
+{
+	int idx = (int)m_Objects.size();
+
+	m_Objects.push_back(obj);
+	m_Position.push_back(Vector3(0.0f, 0.0f, 0.0f));
+	m_LinearVelocity.push_back(Vector3(0.0f, 0.0f, 0.0f));
+	m_Force.push_back(Vector3(0.0f, 0.0f, 0.0f));
+	m_InvMass.push_back(0.0f);
+
+	m_Orientation.push_back(Quaternion(0.0f, 0.0f, 0.0f, 1.0f));
+	m_AngularVelocity.push_back(Vector3(0.0f, 0.0f, 0.0f));
+	m_Torque.push_back(Vector3(0.0f, 0.0f, 0.0f));
+	m_InvInertia.push_back(Matrix3::ZeroMatrix);
+
+	m_Rotation.push_back(Matrix3::Identity);
+	m_InvInertiaWorld.push_back(Matrix3::ZeroMatrix);
+
+	m_LinearCorrection.push_back(Vector3(0.0f, 0.0f, 0.0f));
+	m_AngularCorrection.push_back(Vector3(0.0f, 0.0f, 0.0f));
+
+	m_Sleeping.push_back(0);
+	m_TransformDirty.push_back(BODY_DIRTY_ALL);
+
+	obj->m_pBodyStore = this;
+	obj->m_BodyIndex = idx;
+	return idx;
+}
+
+void PhysicsBodyStore::RemoveBody(int idx)
+{
+	//Swap with the last body and pop
+	int last = (int)m_Objects.size() - 1;
+	if (idx != last)
+	{
+		CopyBody(idx, *this, last);
+		m_Objects[idx]->m_BodyIndex = idx;
+	}
+
+	m_Objects.pop_back();
+	m_Position.pop_back();
+	m_LinearVelocity.pop_back();
+	m_Force.pop_back();
+	m_InvMass.pop_back();
+
+	m_Orientation.pop_back();
+	m_AngularVelocity.pop_back();
+	m_Torque.pop_back();
+	m_InvInertia.pop_back();
+
+	m_Rotation.pop_back();
+	m_InvInertiaWorld.pop_back();
+
+	m_LinearCorrection.pop_back();
+	m_AngularCorrection.pop_back();
+
+	m_Sleeping.pop_back();
+	m_TransformDirty.pop_back();
+}
+
+int PhysicsBodyStore::MoveBody(int idx, PhysicsBodyStore* dst)
+{
+	if (dst == this)
+		return idx;
+
+	PhysicsObject* obj = m_Objects[idx];
+	int new_idx = dst->AddBody(obj);
+	dst->CopyBody(new_idx, *this, idx);
+	RemoveBody(idx);
+
+	obj->m_pBodyStore = dst;
+	obj->m_BodyIndex = new_idx;
+	return new_idx;
+}
+
+void PhysicsBodyStore::CopyBody(int dst, const PhysicsBodyStore& src, int src_idx)
+{
+	m_Objects[dst]			= src.m_Objects[src_idx];
+	m_Position[dst]			= src.m_Position[src_idx];
+	m_LinearVelocity[dst]	= src.m_LinearVelocity[src_idx];
+	m_Force[dst]			= src.m_Force[src_idx];
+	m_InvMass[dst]			= src.m_InvMass[src_idx];
+
+	m_Orientation[dst]		= src.m_Orientation[src_idx];
+	m_AngularVelocity[dst]	= src.m_AngularVelocity[src_idx];
+	m_Torque[dst]			= src.m_Torque[src_idx];
+	m_InvInertia[dst]		= src.m_InvInertia[src_idx];
+
+	m_Rotation[dst]			= src.m_Rotation[src_idx];
+	m_InvInertiaWorld[dst]	= src.m_InvInertiaWorld[src_idx];
+
+	m_LinearCorrection[dst]	= src.m_LinearCorrection[src_idx];
+	m_AngularCorrection[dst]	= src.m_AngularCorrection[src_idx];
+
+	m_Sleeping[dst]			= src.m_Sleeping[src_idx];
+	m_TransformDirty[dst]	= src.m_TransformDirty[src_idx];
+}
+
+void PhysicsBodyStore::Integrate(const Vector3& gravity, float damping, float dt)
+{
+	const int num_bodies = (int)m_Objects.size();
+	int i = 0;
+
+#ifdef PHYSICS_USE_SSE
+	i = num_bodies & ~3;
+	IntegrateSSE(0, i, gravity, damping, dt);
+#endif
+
+	//Remaining bodies (or all of them, without SSE)
+	for (; i < num_bodies; ++i)
+	{
+		if (!m_Sleeping[i])
+			IntegrateBody(i, gravity, damping, dt);
+	}
+}
+
+void PhysicsBodyStore::IntegrateBody(int idx, const Vector3& gravity, float damping, float dt)
+{
+	Vector3& vel = m_LinearVelocity[idx];
+	Vector3& angVel = m_AngularVelocity[idx];
+	Quaternion& orient = m_Orientation[idx];
+
+	/* TUTORIAL 2 */
+	if (m_InvMass[idx] > 0.0f)
+	{
+		vel += gravity * dt;
+	}
+
+	vel += m_Force[idx] * m_InvMass[idx] * dt;
+	vel = vel * damping;
+
+	angVel += m_InvInertiaWorld[idx] * m_Torque[idx] * dt;
+	angVel = angVel * damping;
+
+	m_Position[idx] += vel * dt;
+
+	orient = orient + orient * (angVel * dt * 0.5f);
+	orient.Normalise();
+
+	m_TransformDirty[idx] = BODY_DIRTY_ALL;
+}
+
+void PhysicsBodyStore::UpdateDerived()
+{
+	const int num_bodies = (int)m_Objects.size();
+	for (int i = 0; i < num_bodies; ++i)
+	{
+		if (!m_Sleeping[i])
+			UpdateDerivedBody(i);
+	}
+}
+
+void PhysicsBodyStore::UpdateDerivedBody(int idx)
+{
+	const Matrix3 rot = m_Orientation[idx].ToMatrix3();
+	m_Rotation[idx] = rot;
+	m_InvInertiaWorld[idx] = rot * m_InvInertia[idx] * Matrix3::Transpose(rot);
+}
+
+void PhysicsBodyStore::ApplyPositionCorrections()
+{
+	const Vector3 zero = Vector3(0.0f, 0.0f, 0.0f);
+	const int num_bodies = (int)m_Objects.size();
+	for (int i = 0; i < num_bodies; ++i)
+	{
+		Vector3& linear = m_LinearCorrection[i];
+		Vector3& angular = m_AngularCorrection[i];
+		if (linear == zero && angular == zero)
+			continue;
+
+		//Same as the integration, as if the corrections were velocities over one second
+		m_Position[i] += linear;
+
+		Quaternion& orient = m_Orientation[i];
+		orient = orient + orient * (angular * 0.5f);
+		orient.Normalise();
+
+		UpdateDerivedBody(i);
+		m_TransformDirty[i] = BODY_DIRTY_ALL;
+
+		linear = zero;
+		angular = zero;
+	}
+}
+
+#ifdef PHYSICS_USE_SSE
+
+//Picks a where mask is set, otherwise b
+static inline __m128 Select(__m128 mask, __m128 a, __m128 b)
+{
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+void PhysicsBodyStore::IntegrateSSE(int begin, int end, const Vector3& gravity, float damping, float dt)
+{
+	//Operations are done in the same order as IntegrateBody, so both give identical results
+	const Vector3 gdt = gravity * dt;
+	const __m128 gdt_x = _mm_set1_ps(gdt.x);
+	const __m128 gdt_y = _mm_set1_ps(gdt.y);
+	const __m128 gdt_z = _mm_set1_ps(gdt.z);
+
+	const __m128 v_dt = _mm_set1_ps(dt);
+	const __m128 v_damping = _mm_set1_ps(damping);
+	const __m128 v_half = _mm_set1_ps(0.5f);
+	const __m128 v_one = _mm_set1_ps(1.0f);
+	const __m128 v_zero = _mm_setzero_ps();
+	const __m128 v_sign = _mm_set1_ps(-0.0f);
+	const __m128i i_zero = _mm_setzero_si128();
+
+	for (int i = begin; i < end; i += 4)
+	{
+		//Lanes belonging to sleeping bodies are computed, but never written back
+		int32_t sleeping;
+		memcpy(&sleeping, &m_Sleeping[i], sizeof(sleeping));
+		if (sleeping == 0x01010101)
+			continue;
+
+		__m128i sleep_bytes = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(sleeping), i_zero), i_zero);
+		__m128 awake = _mm_castsi128_ps(_mm_cmpeq_epi32(sleep_bytes, i_zero));
+
+		__m128 inv_mass = _mm_loadu_ps(&m_InvMass[i]);
+		__m128 has_mass = _mm_cmpgt_ps(inv_mass, v_zero);
+
+		//<---------LINEAR-------------->
+		__m128 vx, vy, vz, fx, fy, fz;
+		SIMD_LoadVector3x4(&m_LinearVelocity[i].x, vx, vy, vz);
+		SIMD_LoadVector3x4(&m_Force[i].x, fx, fy, fz);
+
+		vx = _mm_add_ps(vx, _mm_and_ps(has_mass, gdt_x));
+		vy = _mm_add_ps(vy, _mm_and_ps(has_mass, gdt_y));
+		vz = _mm_add_ps(vz, _mm_and_ps(has_mass, gdt_z));
+
+		vx = _mm_mul_ps(_mm_add_ps(vx, _mm_mul_ps(_mm_mul_ps(fx, inv_mass), v_dt)), v_damping);
+		vy = _mm_mul_ps(_mm_add_ps(vy, _mm_mul_ps(_mm_mul_ps(fy, inv_mass), v_dt)), v_damping);
+		vz = _mm_mul_ps(_mm_add_ps(vz, _mm_mul_ps(_mm_mul_ps(fz, inv_mass), v_dt)), v_damping);
+
+		__m128 px, py, pz;
+		SIMD_LoadVector3x4(&m_Position[i].x, px, py, pz);
+		px = _mm_add_ps(px, _mm_mul_ps(vx, v_dt));
+		py = _mm_add_ps(py, _mm_mul_ps(vy, v_dt));
+		pz = _mm_add_ps(pz, _mm_mul_ps(vz, v_dt));
+
+		//<----------ANGULAR-------------->
+		__m128 wx, wy, wz, tx, ty, tz;
+		SIMD_LoadVector3x4(&m_AngularVelocity[i].x, wx, wy, wz);
+		SIMD_LoadVector3x4(&m_Torque[i].x, tx, ty, tz);
+
+		//Hardly anything has a torque applied, so only gather the inertia tensors if needed
+		__m128 has_torque = _mm_or_ps(_mm_cmpneq_ps(tx, v_zero), _mm_or_ps(_mm_cmpneq_ps(ty, v_zero), _mm_cmpneq_ps(tz, v_zero)));
+		if (_mm_movemask_ps(has_torque) != 0)
+		{
+			const Matrix3* m = &m_InvInertiaWorld[i];
+			__m128 m11 = _mm_setr_ps(m[0]._11, m[1]._11, m[2]._11, m[3]._11);
+			__m128 m12 = _mm_setr_ps(m[0]._12, m[1]._12, m[2]._12, m[3]._12);
+			__m128 m13 = _mm_setr_ps(m[0]._13, m[1]._13, m[2]._13, m[3]._13);
+			__m128 m21 = _mm_setr_ps(m[0]._21, m[1]._21, m[2]._21, m[3]._21);
+			__m128 m22 = _mm_setr_ps(m[0]._22, m[1]._22, m[2]._22, m[3]._22);
+			__m128 m23 = _mm_setr_ps(m[0]._23, m[1]._23, m[2]._23, m[3]._23);
+			__m128 m31 = _mm_setr_ps(m[0]._31, m[1]._31, m[2]._31, m[3]._31);
+			__m128 m32 = _mm_setr_ps(m[0]._32, m[1]._32, m[2]._32, m[3]._32);
+			__m128 m33 = _mm_setr_ps(m[0]._33, m[1]._33, m[2]._33, m[3]._33);
+
+			__m128 ax = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m11, tx), _mm_mul_ps(m21, ty)), _mm_mul_ps(m31, tz));
+			__m128 ay = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m12, tx), _mm_mul_ps(m22, ty)), _mm_mul_ps(m32, tz));
+			__m128 az = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m13, tx), _mm_mul_ps(m23, ty)), _mm_mul_ps(m33, tz));
+
+			wx = _mm_add_ps(wx, _mm_mul_ps(ax, v_dt));
+			wy = _mm_add_ps(wy, _mm_mul_ps(ay, v_dt));
+			wz = _mm_add_ps(wz, _mm_mul_ps(az, v_dt));
+		}
+
+		wx = _mm_mul_ps(wx, v_damping);
+		wy = _mm_mul_ps(wy, v_damping);
+		wz = _mm_mul_ps(wz, v_damping);
+
+		//Orientation, loaded as four quaternions and transposed into x/y/z/w
+		__m128 qx = _mm_loadu_ps(&m_Orientation[i + 0].x);
+		__m128 qy = _mm_loadu_ps(&m_Orientation[i + 1].x);
+		__m128 qz = _mm_loadu_ps(&m_Orientation[i + 2].x);
+		__m128 qw = _mm_loadu_ps(&m_Orientation[i + 3].x);
+		_MM_TRANSPOSE4_PS(qx, qy, qz, qw);
+
+		// q = q + q * (w * dt * 0.5)
+		__m128 hx = _mm_mul_ps(_mm_mul_ps(wx, v_dt), v_half);
+		__m128 hy = _mm_mul_ps(_mm_mul_ps(wy, v_dt), v_half);
+		__m128 hz = _mm_mul_ps(_mm_mul_ps(wz, v_dt), v_half);
+
+		__m128 dw = _mm_sub_ps(_mm_sub_ps(_mm_xor_ps(_mm_mul_ps(qx, hx), v_sign), _mm_mul_ps(qy, hy)), _mm_mul_ps(qz, hz));
+		__m128 dx = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(qw, hx), _mm_mul_ps(hy, qz)), _mm_mul_ps(hz, qy));
+		__m128 dy = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(qw, hy), _mm_mul_ps(hz, qx)), _mm_mul_ps(hx, qz));
+		__m128 dz = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(qw, hz), _mm_mul_ps(hx, qy)), _mm_mul_ps(hy, qx));
+
+		qx = _mm_add_ps(qx, dx);
+		qy = _mm_add_ps(qy, dy);
+		qz = _mm_add_ps(qz, dz);
+		qw = _mm_add_ps(qw, dw);
+
+		__m128 mag = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(qx, qx), _mm_mul_ps(qy, qy)), _mm_mul_ps(qz, qz)), _mm_mul_ps(qw, qw)));
+		__m128 inv_mag = Select(_mm_cmpgt_ps(mag, v_zero), _mm_div_ps(v_one, mag), v_one);
+		qx = _mm_mul_ps(qx, inv_mag);
+		qy = _mm_mul_ps(qy, inv_mag);
+		qz = _mm_mul_ps(qz, inv_mag);
+		qw = _mm_mul_ps(qw, inv_mag);
+
+		//<----------WRITE BACK-------------->
+		if (sleeping != 0)
+		{
+			__m128 ox, oy, oz;
+			SIMD_LoadVector3x4(&m_LinearVelocity[i].x, ox, oy, oz);
+			vx = Select(awake, vx, ox); vy = Select(awake, vy, oy); vz = Select(awake, vz, oz);
+
+			SIMD_LoadVector3x4(&m_Position[i].x, ox, oy, oz);
+			px = Select(awake, px, ox); py = Select(awake, py, oy); pz = Select(awake, pz, oz);
+
+			SIMD_LoadVector3x4(&m_AngularVelocity[i].x, ox, oy, oz);
+			wx = Select(awake, wx, ox); wy = Select(awake, wy, oy); wz = Select(awake, wz, oz);
+		}
+
+		SIMD_StoreVector3x4(&m_LinearVelocity[i].x, vx, vy, vz);
+		SIMD_StoreVector3x4(&m_Position[i].x, px, py, pz);
+		SIMD_StoreVector3x4(&m_AngularVelocity[i].x, wx, wy, wz);
+
+		_MM_TRANSPOSE4_PS(qx, qy, qz, qw);
+		for (int j = 0; j < 4; ++j)
+		{
+			if (m_Sleeping[i + j])
+				continue;
+
+			__m128 q = (j == 0) ? qx : (j == 1) ? qy : (j == 2) ? qz : qw;
+			_mm_storeu_ps(&m_Orientation[i + j].x, q);
+			m_TransformDirty[i + j] = BODY_DIRTY_ALL;
+		}
+	}
+}
+
+#endif
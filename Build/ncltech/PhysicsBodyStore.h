@@ -0,0 +1,114 @@
+/******************************************************************************
+Class: PhysicsBodyStore
+Description: Structure of arrays storage for the state that gets integrated every
+step (position, velocity, orientation etc). Each field lives in its own contiguous
+array, indexed by the body index held by the owning PhysicsObject - which just
+acts as a view into the store, so all the existing getters/setters still work.
+
+The PhysicsEngine keeps all of its objects in one store, and integrates four
+bodies at a time with SSE. Objects that have not been added to the engine (or
+have been removed) live in a shared 'detached' store instead.
+
+Vectors are kept whole (rather than split into separate x/y/z arrays) so that
+the solver, which reads them one object at a time, still gets the whole vector
+from a single cache line. The integration kernel transposes them on the fly.
+******************************************************************************/
+#pragma once
+
+#include <nclgl\Vector3.h>
+#include <nclgl\Quaternion.h>
+#include <nclgl\Matrix3.h>
+#include <nclgl\SIMD.h>
+#include <vector>
+#include <stdint.h>
+
+class PhysicsObject;
+
+//Follows nclgl, so defining NCLGL_NO_SIMD turns off SSE for the physics too
+#ifdef NCLGL_USE_SSE
+	#define PHYSICS_USE_SSE
+#endif
+
+//Bits of m_TransformDirty, one for each of the values a PhysicsObject caches from its transform
+#define BODY_DIRTY_TRANSFORM	0x01		//World space transform matrix
+#define BODY_DIRTY_HULL			0x02		//World space hull of the collision shape
+#define BODY_DIRTY_ALL			0xFF
+
+class PhysicsBodyStore
+{
+	friend class PhysicsObject;
+
+public:
+	PhysicsBodyStore();
+	~PhysicsBodyStore();
+
+	//Store used by all objects that are not currently in a physics engine
+	static PhysicsBodyStore* Detached();
+
+	//Adds a body (at rest at the origin) for the given object, returning its index
+	int  AddBody(PhysicsObject* obj);
+
+	//Removes a body, moving the last body into its place (and updating that object's index)
+	void RemoveBody(int idx);
+
+	//Moves the body (and its object) over to another store, returning its new index
+	int  MoveBody(int idx, PhysicsBodyStore* dst);
+
+	size_t Size() const						{ return m_Objects.size(); }
+	PhysicsObject* GetObject(int idx) const	{ return m_Objects[idx]; }
+
+	//Integrates all bodies that are not asleep - semi-implicit euler, the same as
+	// IntegrateBody, but four bodies at a time where SSE is available.
+	void Integrate(const Vector3& gravity, float damping, float dt);
+
+	//Integrates a single body
+	void IntegrateBody(int idx, const Vector3& gravity, float damping, float dt);
+
+	//Recomputes the values derived from each awake body's orientation (its rotation
+	// matrix and world space inverse inertia). Called once per step after integration,
+	// so the solver and collision routines all share them instead of rebuilding them.
+	void UpdateDerived();
+
+	//Recomputes the derived values of a single body, e.g. after it has been moved by hand
+	void UpdateDerivedBody(int idx);
+
+	//Moves each body by the displacement/rotation built up by the position correction
+	// pass (see PhysicsEngine::SolvePositions), then resets them for the next step
+	void ApplyPositionCorrections();
+
+protected:
+	void CopyBody(int dst, const PhysicsBodyStore& src, int src_idx);
+
+#ifdef PHYSICS_USE_SSE
+	void IntegrateSSE(int begin, int end, const Vector3& gravity, float damping, float dt);
+#endif
+
+protected:
+	std::vector<PhysicsObject*>	m_Objects;
+
+	//<---------LINEAR-------------->
+	std::vector<Vector3>		m_Position;
+	std::vector<Vector3>		m_LinearVelocity;
+	std::vector<Vector3>		m_Force;
+	std::vector<float>			m_InvMass;
+
+	//<----------ANGULAR-------------->
+	std::vector<Quaternion>		m_Orientation;
+	std::vector<Vector3>		m_AngularVelocity;
+	std::vector<Vector3>		m_Torque;
+	std::vector<Matrix3>		m_InvInertia;			//Local space, as given by the collision shape
+
+	//<----------DERIVED-------------->
+	// Kept up to date by UpdateDerived/UpdateDerivedBody
+	std::vector<Matrix3>		m_Rotation;				//Orientation as a rotation matrix
+	std::vector<Matrix3>		m_InvInertiaWorld;		//R * m_InvInertia * R^T
+
+	//<----------POSITION CORRECTION-------------->
+	// Zero except while the position correction pass is running
+	std::vector<Vector3>		m_LinearCorrection;
+	std::vector<Vector3>		m_AngularCorrection;	//Applied to the orientation as an angular velocity over one second
+
+	//<----------FLAGS-------------->
+	std::vector<uint8_t>		m_Sleeping;				//Non-zero if the body should not be integrated
+	std::vector<uint8_t>		m_TransformDirty;		//BODY_DIRTY_ flags for each of the object's cached values that are out of date
+};
@@ -1,9 +1,10 @@
 #include "PhysicsEngine.h"
 #include "Object.h"
-#include "CollisionDetectionSAT.h"
+#include "CollisionDispatch.h"
 #include "NCLDebug.h"
 #include <nclgl\Window.h>
 #include <omp.h>
+#include <algorithm>
 
 
 void PhysicsEngine::SetDefaults()
@@ -11,7 +12,14 @@ void PhysicsEngine::SetDefaults()
 	m_IsInCourseWork = false;
 	m_HasAtmosphere = false;
 	m_isDrawOcTree = false;
-	m_isUseOcTree = false;
+	m_BroadphaseMode = BROADPHASE_BRUTEFORCE;
+	m_SolverMode = SOLVER_ISLANDS;
+	m_JacobiRelaxation = DEFAULT_JACOBI_RELAXATION;
+	m_SolverMinIterations = DEFAULT_SOLVER_MIN_ITERATIONS;
+	m_SolverMaxIterations = DEFAULT_SOLVER_MAX_ITERATIONS;
+	m_SolverTolerance = DEFAULT_SOLVER_TOLERANCE;
+	m_PositionCorrectionMode = POSITION_CORRECTION_BAUMGARTE;
+	m_PositionIterations = DEFAULT_POSITION_ITERATIONS;
 	m_isZeroTrans = false;
 
 	m_DebugDrawFlags = NULL;
@@ -20,9 +28,25 @@ void PhysicsEngine::SetDefaults()
 	m_UpdateAccum = 0.0f;
 	m_Gravity = Vector3(0.0f, -9.81f, 0.0f);
 	m_DampingFactor = 0.999f;
+
+	m_SleepTime = DEFAULT_SLEEP_TIME;
+	m_SleepLinearVelocity = DEFAULT_SLEEP_LINEAR_VELOCITY;
+	m_SleepAngularVelocity = DEFAULT_SLEEP_ANGULAR_VELOCITY;
 }
 
 PhysicsEngine::PhysicsEngine()
+	: m_StepCounter(0)
+	, m_NumIslands(0)
+	, m_LargestIslandSize(0)
+	, m_NumColours(0)
+	, m_SolverAverageIterations(0.0f)
+	, m_SolverMostIterations(0)
+	, m_SolverResidual(0.0f)
+	, m_NumSleeping(0)
+	, m_DistanceConstraints(CONSTRAINT_DISTANCE)
+	, m_BallSocketConstraints(CONSTRAINT_BALLSOCKET)
+	, m_HingeConstraints(CONSTRAINT_HINGE)
+	, m_SliderConstraints(CONSTRAINT_SLIDER)
 {
 	SetDefaults();
 }
@@ -35,6 +59,69 @@ PhysicsEngine::~PhysicsEngine()
 void PhysicsEngine::AddPhysicsObject(PhysicsObject* obj)
 {
 	m_PhysicsObjects.push_back(obj);
+	obj->m_pBodyStore->MoveBody(obj->m_BodyIndex, &m_BodyStore);
+	m_SweepAndPrune.AddObject(obj);
+	m_AABBTree.AddObject(obj);
+	m_OcTree.AddObject(obj);
+	m_SpatialHash.AddObject(obj);
+}
+
+//Custom constraint that doesn't say which objects it acts upon, so could be touching any of them
+static inline bool IsUnboundConstraint(const Constraint& c)
+{
+	return c.GetObjectA() == NULL && c.GetObjectB() == NULL;
+}
+
+//The constraint may well be pulling the objects somewhere new (or no longer holding them in place)
+static void WakeConstraintObjects(const Constraint& c)
+{
+	if (c.GetObjectA() != NULL) c.GetObjectA()->WakeUp();
+	if (c.GetObjectB() != NULL) c.GetObjectB()->WakeUp();
+}
+
+void PhysicsEngine::AddConstraint(Constraint* c)
+{
+	m_vpConstraints.push_back(c);
+	WakeConstraintObjects(*c);
+}
+
+template <class T>
+static ConstraintHandle AddToPool(ConstraintPool<T>& pool, const T& c)
+{
+	WakeConstraintObjects(c);
+	return pool.Add(c);
+}
+
+template <class T>
+static bool RemoveFromPool(ConstraintPool<T>& pool, const ConstraintHandle& h)
+{
+	if (T* c = pool.Get(h))
+	{
+		WakeConstraintObjects(*c);
+		return pool.Remove(h);
+	}
+	return false;
+}
+
+ConstraintHandle PhysicsEngine::AddConstraint(const DistanceConstraint& c)		{ return AddToPool(m_DistanceConstraints, c); }
+ConstraintHandle PhysicsEngine::AddConstraint(const BallSocketConstraint& c)	{ return AddToPool(m_BallSocketConstraints, c); }
+ConstraintHandle PhysicsEngine::AddConstraint(const HingeConstraint& c)			{ return AddToPool(m_HingeConstraints, c); }
+ConstraintHandle PhysicsEngine::AddConstraint(const SliderConstraint& c)		{ return AddToPool(m_SliderConstraints, c); }
+
+bool PhysicsEngine::RemoveConstraint(const ConstraintHandle& h)
+{
+	switch (h.type)
+	{
+	case CONSTRAINT_DISTANCE:	return RemoveFromPool(m_DistanceConstraints, h);
+	case CONSTRAINT_BALLSOCKET:	return RemoveFromPool(m_BallSocketConstraints, h);
+	case CONSTRAINT_HINGE:		return RemoveFromPool(m_HingeConstraints, h);
+	case CONSTRAINT_SLIDER:		return RemoveFromPool(m_SliderConstraints, h);
+
+	default:
+		break;
+	}
+
+	return false;
 }
 
 void PhysicsEngine::RemovePhysicsObject(PhysicsObject* obj)
@@ -46,6 +133,33 @@ void PhysicsEngine::RemovePhysicsObject(PhysicsObject* obj)
 	if (found_loc != m_PhysicsObjects.end())
 	{
 		m_PhysicsObjects.erase(found_loc);
+		m_BodyStore.MoveBody(obj->m_BodyIndex, PhysicsBodyStore::Detached());
+		m_SweepAndPrune.RemoveObject(obj);
+		m_AABBTree.RemoveObject(obj);
+		m_OcTree.RemoveObject(obj);
+		m_SpatialHash.RemoveObject(obj);
+
+		//Delete any cached manifolds involving the object
+		for (auto itr = m_ManifoldCache.begin(); itr != m_ManifoldCache.end(); )
+		{
+			if (itr->first.first == obj || itr->first.second == obj)
+			{
+				//Anything that was resting on the object needs to wake up and fall
+				itr->first.first->WakeUp();
+				itr->first.second->WakeUp();
+
+				Manifold* m = itr->second.manifold;
+				m_vpManifolds.erase(std::remove(m_vpManifolds.begin(), m_vpManifolds.end(), m), m_vpManifolds.end());
+				m_vpSleepingManifolds.erase(std::remove(m_vpSleepingManifolds.begin(), m_vpSleepingManifolds.end(), m), m_vpSleepingManifolds.end());
+				delete m;
+
+				itr = m_ManifoldCache.erase(itr);
+			}
+			else
+			{
+				++itr;
+			}
+		}
 	}
 }
 
@@ -57,12 +171,15 @@ void PhysicsEngine::RemoveAllPhysicsObjects()
 		delete c;
 	}
 	m_vpConstraints.clear();
+	ForEachConstraintPool([](auto& pool) { pool.Clear(); });
 
-	for (Manifold* m : m_vpManifolds)
+	for (auto& entry : m_ManifoldCache)
 	{
-		delete m;
+		delete entry.second.manifold;
 	}
+	m_ManifoldCache.clear();
 	m_vpManifolds.clear();
+	m_vpSleepingManifolds.clear();
 
 
 	//Delete and remove all physics objects
@@ -74,6 +191,10 @@ void PhysicsEngine::RemoveAllPhysicsObjects()
 		delete obj;
 	}
 	m_PhysicsObjects.clear();
+	m_SweepAndPrune.Clear();
+	m_AABBTree.Clear();
+	m_OcTree.Clear();
+	m_SpatialHash.Clear();
 }
 
 
@@ -107,15 +228,40 @@ void PhysicsEngine::UpdatePhysics()
 		m_ShotPoints = 0.0f;
 	}
 
-	for (Manifold* m : m_vpManifolds)
-	{
-		delete m;
-	}
+	//Manifolds are owned by m_ManifoldCache and reused between frames,
+	// so the narrowphase only needs to rebuild the list of active ones.
 	m_vpManifolds.clear();
+	m_vpSleepingManifolds.clear();
+	m_StepCounter++;
 
+	//Sleeping objects are skipped by the broadphase and narrowphase, so anything that has
+	// had its collision shape resized (along with anything resting on it, in case it was
+	// static or has shrunk) is woken up to be collided with its new size
+	std::vector<PhysicsObject*> resized;
 	for(auto* obj : m_PhysicsObjects)
 	{
 		obj->m_isColl = false;
+
+		const CollisionShape* shape = obj->GetCollisionShape();
+		if (shape != NULL && shape->GetVersion() != obj->m_ShapeVersion)
+		{
+			obj->m_ShapeVersion = shape->GetVersion();
+			obj->WakeUp();
+			resized.push_back(obj);
+		}
+	}
+
+	if (!resized.empty())
+	{
+		auto was_resized = [&resized](PhysicsObject* obj) { return std::find(resized.begin(), resized.end(), obj) != resized.end(); };
+		for (auto& entry : m_ManifoldCache)
+		{
+			if (was_resized(entry.first.first) || was_resized(entry.first.second))
+			{
+				entry.first.first->WakeUp();
+				entry.first.second->WakeUp();
+			}
+		}
 	}
 
 	//Check for collisions
@@ -126,34 +272,893 @@ void PhysicsEngine::UpdatePhysics()
 	SolveConstraints();
 
 	//Update movement
-	for (PhysicsObject* obj : m_PhysicsObjects)
+	if (m_IsInCourseWork)
+	{
+		//Gravity and damping change per object, so each has to be integrated on its own
+		for (PhysicsObject* obj : m_PhysicsObjects)
+		{
+			if (!obj->IsSleeping())
+			{
+				UpdatePhysicsObject(obj);
+			}
+		}
+	}
+	else
 	{
-		UpdatePhysicsObject(obj);
+		m_BodyStore.Integrate(m_Gravity, m_DampingFactor, m_UpdateTimestep);
 	}
+
+	//Rotation matrices and world space inertia tensors for the new orientations, used
+	// by everything from the broadphase through to the solver next step
+	m_BodyStore.UpdateDerived();
+
+	//Push apart anything still penetrating (or constraints that have drifted) now the
+	// objects have moved, without adding any velocity
+	if (m_PositionCorrectionMode == POSITION_CORRECTION_NGS)
+	{
+		SolvePositions();
+	}
+
+	//Put anything that has come to rest to sleep - checked after integration, as a resting
+	// object leaves the solver with just enough velocity to cancel out this step's gravity
+	UpdateSleeping();
 }
 
 
 void PhysicsEngine::SolveConstraints()
 {
+	BuildIslands();
+
+	if (m_SolverMode == SOLVER_GRAPHCOLOURING)
+	{
+		BuildColourBatches();
+		SolveColourBatches();
+	}
+	else if (m_SolverMode == SOLVER_JACOBI)
+	{
+		BuildJacobiBuffers();
+		SolveJacobi();
+	}
+	else
+	{
+		//Islands never share a dynamic object, so they can be solved in parallel
+		// without any locking. Islands vary a lot in size so they are handed out one at a time.
+#pragma omp parallel for schedule(dynamic, 1)
+		for (int i = 0; i < m_NumIslands; ++i)
+		{
+			SolveIsland(m_Islands[i]);
+		}
+	}
+
+	int total_iterations = 0;
+	m_SolverMostIterations = 0;
+	m_SolverResidual = 0.0f;
+	for (int i = 0; i < m_NumIslands; ++i)
+	{
+		total_iterations += m_Islands[i].iterations;
+		m_SolverMostIterations = max(m_SolverMostIterations, m_Islands[i].iterations);
+		m_SolverResidual = max(m_SolverResidual, m_Islands[i].residual);
+	}
+	m_SolverAverageIterations = (m_NumIslands > 0) ? total_iterations / (float)m_NumIslands : 0.0f;
+}
+
+void PhysicsEngine::SolveIsland(Island& island)
+{
+	//Penetration/drift is either fixed through the velocities, or left for SolvePositions
+	const bool velocity_baumgarte = (m_PositionCorrectionMode == POSITION_CORRECTION_BAUMGARTE);
+
 	//Optional step to allow constraints to 
 	// precompute values based off current velocities 
 	// before they are updated in the main loop below.
-	for (Manifold* m : m_vpManifolds)		m->PreSolverStep(m_UpdateTimestep);
-	for (Constraint* c : m_vpConstraints)	c->PreSolverStep(m_UpdateTimestep);
+	for (Manifold* m : island.manifolds)				m->PreSolverStep(m_UpdateTimestep, velocity_baumgarte);
+	for (Constraint* c : island.constraints.custom)		c->PreSolverStep(m_UpdateTimestep);
+	ForEachConstraintPool([&](auto& pool)
+	{
+		for (int idx : island.constraints.pooled[pool.GetType()])	pool[idx].PreSolverStep(m_UpdateTimestep, velocity_baumgarte);
+	});
+
+	// Apply the contact impulses carried over from last frame, so the
+	// solver starts close to the answer rather than from nothing.
+	for (Manifold* m : island.manifolds)		m->WarmStart();
+
+	// Solve all Constraints and Collision Manifolds - until nothing is changing any more
+	island.iterations = 0;
+	island.residual = 0.0f;
+	while (island.iterations < m_SolverMaxIterations)
+	{
+		float residual = 0.0f;
+		for (Manifold * m : island.manifolds)
+		{
+			float change = m->ApplyImpulse(/*factor*/);
+			residual = max(residual, change);
+		}
+
+		for (Constraint * c : island.constraints.custom)
+		{
+			float change = c->ApplyImpulseResidual();
+			residual = max(residual, change);
+		}
+
+		ForEachConstraintPool([&](auto& pool)
+		{
+			for (int idx : island.constraints.pooled[pool.GetType()])
+			{
+				float change = pool[idx].ApplyImpulseResidual();
+				residual = max(residual, change);
+			}
+		});
+
+		island.iterations++;
+		island.residual = residual;
+		if (island.iterations >= m_SolverMinIterations && residual < m_SolverTolerance)
+			break;
+	}
+}
+
+float PhysicsEngine::ReduceSolverResidual(float residual, int iteration)
+{
+	float& shared = m_SolverResiduals[iteration & 1];
+#pragma omp critical(SolverResidual)
+	shared = max(shared, residual);
+
+	//Clear the other one ready for the next iteration - everyone has been through at least
+	// one barrier since they read it at the end of the last iteration, so it is no longer in use
+#pragma omp single nowait
+	m_SolverResiduals[(iteration + 1) & 1] = 0.0f;
+
+#pragma omp barrier
+	return shared;
+}
+
+static inline bool IsDynamic(const PhysicsObject* obj)
+{
+	return obj != NULL && obj->GetInverseMass() > 0.0f;
+}
+
+void PhysicsEngine::SolvePositions()
+{
+	//Islands are corrected one at a time, same as SolveIsland
+#pragma omp parallel for schedule(dynamic, 1)
+	for (int i = 0; i < m_NumIslands; ++i)
+	{
+		SolveIslandPositions(m_Islands[i]);
+	}
+
+	m_BodyStore.ApplyPositionCorrections();
+}
+
+void PhysicsEngine::SolveIslandPositions(Island& island)
+{
+	for (Manifold* m : island.manifolds)			m->PrePositionStep();
+	ForEachConstraintPool([&](auto& pool)
+	{
+		for (int idx : island.constraints.pooled[pool.GetType()])	pool[idx].PrePositionStep();
+	});
+
+	for (int iteration = 0; iteration < m_PositionIterations; ++iteration)
+	{
+		float error = 0.0f;
+		for (Manifold* m : island.manifolds)
+		{
+			error = max(error, m->SolvePosition());
+		}
+
+		ForEachConstraintPool([&](auto& pool)
+		{
+			for (int idx : island.constraints.pooled[pool.GetType()])
+			{
+				error = max(error, pool[idx].SolvePosition());
+			}
+		});
+
+		if (error < NGS_SLOP)
+			break;
+	}
+}
+
+void PhysicsEngine::BuildColourBatches()
+{
+	m_ColourBatches.resize(MAX_SOLVER_COLOURS + 1);
+	for (ColourBatch& batch : m_ColourBatches)
+	{
+		batch.manifolds.clear();
+		batch.constraints.clear();
+	}
+
+	m_BodyColours.assign(m_BodyStore.Size(), 0);
+	m_NumColours = 0;
+
+	//Finds the lowest colour not yet used by either (dynamic) object, and marks it as used
+	auto colour = [this](PhysicsObject* a, PhysicsObject* b) -> int
+	{
+		uint64_t used = 0;
+		if (IsDynamic(a)) used |= m_BodyColours[a->m_BodyIndex];
+		if (IsDynamic(b)) used |= m_BodyColours[b->m_BodyIndex];
+
+		int c = 0;
+		while (c < MAX_SOLVER_COLOURS && (used & ((uint64_t)1 << c)))
+			++c;
+
+		if (c < MAX_SOLVER_COLOURS)
+		{
+			if (IsDynamic(a)) m_BodyColours[a->m_BodyIndex] |= ((uint64_t)1 << c);
+			if (IsDynamic(b)) m_BodyColours[b->m_BodyIndex] |= ((uint64_t)1 << c);
+		}
+
+		m_NumColours = max(m_NumColours, c + 1);
+		return c;
+	};
+
+	//Islands are visited in order, so the batches (and so the results) only depend on object order
+	for (int i = 0; i < m_NumIslands; ++i)
+	{
+		for (Manifold* m : m_Islands[i].manifolds)
+			m_ColourBatches[colour(m->NodeA(), m->NodeB())].manifolds.push_back(m);
+
+		//Unbound constraints could share objects with anything, so go in the (single threaded) overflow batch
+		for (Constraint* c : m_Islands[i].constraints.custom)
+		{
+			if (IsUnboundConstraint(*c))
+			{
+				m_ColourBatches[MAX_SOLVER_COLOURS].constraints.custom.push_back(c);
+				m_NumColours = MAX_SOLVER_COLOURS + 1;
+			}
+			else
+			{
+				m_ColourBatches[colour(c->GetObjectA(), c->GetObjectB())].constraints.custom.push_back(c);
+			}
+		}
+
+		ForEachConstraintPool([&](auto& pool)
+		{
+			const ConstraintType type = pool.GetType();
+			for (int idx : m_Islands[i].constraints.pooled[type])
+			{
+				const auto& c = pool[idx];
+				m_ColourBatches[colour(c.GetObjectA(), c.GetObjectB())].constraints.pooled[type].push_back(idx);
+			}
+		});
+	}
+}
+
+void PhysicsEngine::SolveColourBatches()
+{
+	const int num_colours = m_NumColours;
+	if (num_colours == 0)
+		return;
+
+	const bool velocity_baumgarte = (m_PositionCorrectionMode == POSITION_CORRECTION_BAUMGARTE);
+	int iterations = 0;
+	m_SolverResiduals[0] = m_SolverResiduals[1] = 0.0f;
+
+	//One parallel region for the whole solve, with the threads meeting up at the end of
+	// each batch - starting up a new region per batch would cost more than most batches take.
+#pragma omp parallel
+	{
+		//Pre-solver steps only write to their own manifold/constraint, so can go in any order
+		for (int c = 0; c < num_colours; ++c)
+		{
+			ColourBatch& batch = m_ColourBatches[c];
+			const int num_manifolds = (int)batch.manifolds.size();
+			const int num_custom = (int)batch.constraints.custom.size();
+
+#pragma omp for schedule(static) nowait
+			for (int i = 0; i < num_manifolds; ++i)
+				batch.manifolds[i]->PreSolverStep(m_UpdateTimestep, velocity_baumgarte);
+
+#pragma omp for schedule(static) nowait
+			for (int i = 0; i < num_custom; ++i)
+				batch.constraints.custom[i]->PreSolverStep(m_UpdateTimestep);
+
+			ForEachConstraintPool([&](auto& pool)
+			{
+				const std::vector<int>& indices = batch.constraints.pooled[pool.GetType()];
+				const int num_pooled = (int)indices.size();
+#pragma omp for schedule(static) nowait
+				for (int i = 0; i < num_pooled; ++i)
+					pool[indices[i]].PreSolverStep(m_UpdateTimestep, velocity_baumgarte);
+			});
+		}
+#pragma omp barrier
+
+		for (int c = 0; c < num_colours; ++c)
+		{
+			ColourBatch& batch = m_ColourBatches[c];
+			const int num_manifolds = (int)batch.manifolds.size();
+
+			if (c == MAX_SOLVER_COLOURS)
+			{
+#pragma omp single
+				for (Manifold* m : batch.manifolds)	m->WarmStart();
+			}
+			else
+			{
+#pragma omp for schedule(static)
+				for (int i = 0; i < num_manifolds; ++i)
+					batch.manifolds[i]->WarmStart();
+			}
+		}
+
+		for (int iteration = 0; iteration < m_SolverMaxIterations; ++iteration)
+		{
+			float residual = 0.0f;
+			for (int c = 0; c < num_colours; ++c)
+			{
+				ColourBatch& batch = m_ColourBatches[c];
+				const int num_manifolds = (int)batch.manifolds.size();
+				const int num_custom = (int)batch.constraints.custom.size();
+
+				if (c == MAX_SOLVER_COLOURS)
+				{
+					//The overflow batch may share objects, so is solved on one thread
+#pragma omp single
+					{
+						for (Manifold* m : batch.manifolds)
+						{
+							float change = m->ApplyImpulse();
+							residual = max(residual, change);
+						}
+						for (Constraint* con : batch.constraints.custom)
+						{
+							float change = con->ApplyImpulseResidual();
+							residual = max(residual, change);
+						}
+						ForEachConstraintPool([&](auto& pool)
+						{
+							for (int idx : batch.constraints.pooled[pool.GetType()])
+							{
+								float change = pool[idx].ApplyImpulseResidual();
+								residual = max(residual, change);
+							}
+						});
+					}
+				}
+				else
+				{
+					//Nothing in a batch shares a dynamic object, so there is no need to wait
+					// between the different types - only for the whole batch to finish
+#pragma omp for schedule(static) nowait
+					for (int i = 0; i < num_manifolds; ++i)
+					{
+						float change = batch.manifolds[i]->ApplyImpulse();
+						residual = max(residual, change);
+					}
+
+#pragma omp for schedule(static) nowait
+					for (int i = 0; i < num_custom; ++i)
+					{
+						float change = batch.constraints.custom[i]->ApplyImpulseResidual();
+						residual = max(residual, change);
+					}
+
+					ForEachConstraintPool([&](auto& pool)
+					{
+						const std::vector<int>& indices = batch.constraints.pooled[pool.GetType()];
+						const int num_pooled = (int)indices.size();
+#pragma omp for schedule(static) nowait
+						for (int i = 0; i < num_pooled; ++i)
+						{
+							float change = pool[indices[i]].ApplyImpulseResidual();
+							residual = max(residual, change);
+						}
+					});
+#pragma omp barrier
+				}
+			}
+
+			//Every thread gets the same residual back, so they all stop together
+			residual = ReduceSolverResidual(residual, iteration);
+#pragma omp master
+			iterations = iteration + 1;
+			if (iteration + 1 >= m_SolverMinIterations && residual < m_SolverTolerance)
+				break;
+		}
+	}
+
+	const float residual = m_SolverResiduals[(iterations - 1) & 1];
+	for (int i = 0; i < m_NumIslands; ++i)
+	{
+		m_Islands[i].iterations = iterations;
+		m_Islands[i].residual = residual;
+	}
+}
+
+void PhysicsEngine::BuildJacobiBuffers()
+{
+	m_JacobiManifolds.clear();
+	m_JacobiConstraints.clear();
+	m_JacobiUnboundConstraints.clear();
+	for (int i = 0; i < m_NumIslands; ++i)
+	{
+		m_JacobiManifolds.insert(m_JacobiManifolds.end(), m_Islands[i].manifolds.begin(), m_Islands[i].manifolds.end());
+		const ConstraintLists& constraints = m_Islands[i].constraints;
+		for (Constraint* c : constraints.custom)
+		{
+			if (IsUnboundConstraint(*c))	m_JacobiUnboundConstraints.push_back(c);
+			else							m_JacobiConstraints.custom.push_back(c);
+		}
+		for (int type = 0; type < CONSTRAINT_MAX; ++type)
+			m_JacobiConstraints.pooled[type].insert(m_JacobiConstraints.pooled[type].end(), constraints.pooled[type].begin(), constraints.pooled[type].end());
+	}
+
+	//Count the entries for each body, then turn the counts into offsets - each body's
+	// entries are then filled in the same order every time, so the sums are deterministic
+	const int num_bodies = (int)m_BodyStore.Size();
+	m_JacobiOffsets.assign(num_bodies + 1, 0);
+
+	auto count = [this](PhysicsObject* obj)
+	{
+		if (IsDynamic(obj)) m_JacobiOffsets[obj->m_BodyIndex + 1]++;
+	};
+	for (Manifold* m : m_JacobiManifolds)				{ count(m->NodeA()); count(m->NodeB()); }
+	for (Constraint* c : m_JacobiConstraints.custom)	{ count(c->GetObjectA()); count(c->GetObjectB()); }
+	ForEachConstraintPool([&](auto& pool)
+	{
+		for (int idx : m_JacobiConstraints.pooled[pool.GetType()])	{ count(pool[idx].GetObjectA()); count(pool[idx].GetObjectB()); }
+	});
+
+	m_JacobiBodies.clear();
+	for (int i = 0; i < num_bodies; ++i)
+	{
+		if (m_JacobiOffsets[i + 1] > 0)
+			m_JacobiBodies.push_back(i);
+		m_JacobiOffsets[i + 1] += m_JacobiOffsets[i];
+	}
+
+	m_JacobiEntries.resize(m_JacobiOffsets[num_bodies]);
+	auto add = [this](PhysicsObject* obj, const Vector3& linear, const Vector3& angular)
+	{
+		if (IsDynamic(obj))
+		{
+			JacobiEntry& e = m_JacobiEntries[m_JacobiOffsets[obj->m_BodyIndex]++];
+			e.linear = &linear;
+			e.angular = &angular;
+		}
+	};
+	for (Manifold* m : m_JacobiManifolds)
+	{
+		VelocityDelta& d = m->GetVelocityDelta();
+		add(m->NodeA(), d.linearA, d.angularA);
+		add(m->NodeB(), d.linearB, d.angularB);
+	}
+	auto add_constraint = [&add](Constraint& c)
+	{
+		VelocityDelta& d = c.GetVelocityDelta();
+		add(c.GetObjectA(), d.linearA, d.angularA);
+		add(c.GetObjectB(), d.linearB, d.angularB);
+	};
+	for (Constraint* c : m_JacobiConstraints.custom)	add_constraint(*c);
+	ForEachConstraintPool([&](auto& pool)
+	{
+		for (int idx : m_JacobiConstraints.pooled[pool.GetType()])	add_constraint(pool[idx]);
+	});
+
+	//Filling in the entries moved each offset on to the start of the next body, so shift them back
+	for (int i = num_bodies; i > 0; --i)
+		m_JacobiOffsets[i] = m_JacobiOffsets[i - 1];
+	m_JacobiOffsets[0] = 0;
+}
+
+//Constraints do not carry any accumulated impulse, so can just be relaxed afterwards
+template <class T>
+static inline float ApplyRelaxedImpulse(T& c, float relaxation)
+{
+	VelocityDelta& d = c.GetVelocityDelta();
+	d.Clear();
+	float change = c.ApplyImpulseResidual() * relaxation;
+	d.Scale(relaxation);
+	return change;
+}
+
+void PhysicsEngine::SolveJacobi()
+{
+	const int num_manifolds = (int)m_JacobiManifolds.size();
+	const int num_custom = (int)m_JacobiConstraints.custom.size();
+	const float relaxation = m_JacobiRelaxation;
+	const bool velocity_baumgarte = (m_PositionCorrectionMode == POSITION_CORRECTION_BAUMGARTE);
+	if (num_manifolds + (int)m_JacobiConstraints.size() + (int)m_JacobiUnboundConstraints.size() == 0)
+		return;
+
+	int iterations = 0;
+	m_SolverResiduals[0] = m_SolverResiduals[1] = 0.0f;
+
+	for (Manifold* m : m_JacobiManifolds)				m->GetVelocityDelta().accumulate = true;
+	for (Constraint* c : m_JacobiConstraints.custom)	c->GetVelocityDelta().accumulate = true;
+	ForEachConstraintPool([&](auto& pool)
+	{
+		for (int idx : m_JacobiConstraints.pooled[pool.GetType()])	pool[idx].GetVelocityDelta().accumulate = true;
+	});
+
+#pragma omp parallel
+	{
+		//Warm starting is not relaxed, as last frame's impulses are already close to the answer
+#pragma omp for schedule(static) nowait
+		for (int i = 0; i < num_manifolds; ++i)
+		{
+			Manifold* m = m_JacobiManifolds[i];
+			m->PreSolverStep(m_UpdateTimestep, velocity_baumgarte);
+			m->GetVelocityDelta().Clear();
+			m->WarmStart();
+		}
+#pragma omp for schedule(static) nowait
+		for (int i = 0; i < num_custom; ++i)
+		{
+			Constraint* c = m_JacobiConstraints.custom[i];
+			c->PreSolverStep(m_UpdateTimestep);
+			c->GetVelocityDelta().Clear();
+		}
+		ForEachConstraintPool([&](auto& pool)
+		{
+			const std::vector<int>& indices = m_JacobiConstraints.pooled[pool.GetType()];
+			const int num_pooled = (int)indices.size();
+#pragma omp for schedule(static) nowait
+			for (int i = 0; i < num_pooled; ++i)
+			{
+				auto& c = pool[indices[i]];
+				c.PreSolverStep(m_UpdateTimestep, velocity_baumgarte);
+				c.GetVelocityDelta().Clear();
+			}
+		});
+#pragma omp single nowait
+		for (Constraint* c : m_JacobiUnboundConstraints)
+			c->PreSolverStep(m_UpdateTimestep);
+#pragma omp barrier
+		ApplyJacobiDeltas();
+
+		for (int iteration = 0; iteration < m_SolverMaxIterations; ++iteration)
+		{
+			float residual = 0.0f;
+
+			//Unbound constraints can't have their impulses added up per object, so they are
+			// applied straight to the velocities (gauss-seidel) before the jacobi iteration
+#pragma omp single
+			for (Constraint* c : m_JacobiUnboundConstraints)
+				residual = max(residual, c->ApplyImpulseResidual());
+
+			//Nothing writes to the objects in here, so every manifold/constraint sees the same velocities
+#pragma omp for schedule(static) nowait
+			for (int i = 0; i < num_manifolds; ++i)
+			{
+				Manifold* m = m_JacobiManifolds[i];
+				m->GetVelocityDelta().Clear();
+				residual = max(residual, m->ApplyImpulse(relaxation));
+			}
+#pragma omp for schedule(static) nowait
+			for (int i = 0; i < num_custom; ++i)
+			{
+				residual = max(residual, ApplyRelaxedImpulse(*m_JacobiConstraints.custom[i], relaxation));
+			}
+			ForEachConstraintPool([&](auto& pool)
+			{
+				const std::vector<int>& indices = m_JacobiConstraints.pooled[pool.GetType()];
+				const int num_pooled = (int)indices.size();
+#pragma omp for schedule(static) nowait
+				for (int i = 0; i < num_pooled; ++i)
+				{
+					residual = max(residual, ApplyRelaxedImpulse(pool[indices[i]], relaxation));
+				}
+			});
+
+			//Waits for everything above to finish before any deltas are applied
+			residual = ReduceSolverResidual(residual, iteration);
+			ApplyJacobiDeltas();
+
+#pragma omp master
+			iterations = iteration + 1;
+			if (iteration + 1 >= m_SolverMinIterations && residual < m_SolverTolerance)
+				break;
+		}
+	}
 
-	// Solve all Constraints and Collision Manifolds
-	//for (Manifold* m : m_vpManifolds)		m->ApplyImpulse();
-	//for (Constraint* c : m_vpConstraints)	c->ApplyImpulse();
-	for (size_t i = 0; i < SOLVER_ITERATIONS; ++i)
+	const float residual = m_SolverResiduals[(iterations - 1) & 1];
+	for (int i = 0; i < m_NumIslands; ++i)
 	{
-		for (Manifold * m : m_vpManifolds)
+		m_Islands[i].iterations = iterations;
+		m_Islands[i].residual = residual;
+	}
+
+	for (Manifold* m : m_JacobiManifolds)				m->GetVelocityDelta().accumulate = false;
+	for (Constraint* c : m_JacobiConstraints.custom)	c->GetVelocityDelta().accumulate = false;
+	ForEachConstraintPool([&](auto& pool)
+	{
+		for (int idx : m_JacobiConstraints.pooled[pool.GetType()])	pool[idx].GetVelocityDelta().accumulate = false;
+	});
+}
+
+void PhysicsEngine::ApplyJacobiDeltas()
+{
+	//Called from inside SolveJacobi's parallel region - the implicit barriers at the end of
+	// each loop keep it from overlapping with the manifolds/constraints writing their deltas
+	const int num_bodies = (int)m_JacobiBodies.size();
+
+#pragma omp for schedule(static)
+	for (int i = 0; i < num_bodies; ++i)
+	{
+		const int body = m_JacobiBodies[i];
+		Vector3 linear(0.0f, 0.0f, 0.0f), angular(0.0f, 0.0f, 0.0f);
+		for (int j = m_JacobiOffsets[body]; j < m_JacobiOffsets[body + 1]; ++j)
 		{
-			m->ApplyImpulse(/*factor*/);
+			linear = linear + *m_JacobiEntries[j].linear;
+			angular = angular + *m_JacobiEntries[j].angular;
 		}
 
-		for (Constraint * c : m_vpConstraints)
+		PhysicsObject* obj = m_BodyStore.GetObject(body);
+		obj->SetLinearVelocity(obj->GetLinearVelocity() + linear);
+		obj->SetAngularVelocity(obj->GetAngularVelocity() + angular);
+	}
+}
+
+static inline bool IsAwakeDynamic(const PhysicsObject* obj)
+{
+	return IsDynamic(obj) && !obj->IsSleeping();
+}
+
+//Static objects never sleep or join an island, but ones that are being moved by hand (e.g. a
+// spinning platform) still have to wake up anything they touch
+static inline bool IsMovingStatic(const PhysicsObject* obj)
+{
+	return obj != NULL && !IsDynamic(obj)
+		&& (obj->GetLinearVelocity().LengthSquared() > 0.0f || obj->GetAngularVelocity().LengthSquared() > 0.0f);
+}
+
+//Anything that can push a sleeping object out of place
+static inline bool IsWaker(const PhysicsObject* obj)
+{
+	return IsAwakeDynamic(obj) || IsMovingStatic(obj);
+}
+
+static inline int FindIslandRoot(std::vector<int>& parents, int i)
+{
+	while (parents[i] != i)
+	{
+		parents[i] = parents[parents[i]];	//Path halving
+		i = parents[i];
+	}
+	return i;
+}
+
+void PhysicsEngine::BuildIslands()
+{
+	const int num_objects = (int)m_PhysicsObjects.size();
+
+	//Every object starts in an island of its own - m_IslandIndex temporarily holds the
+	// object's index into m_PhysicsObjects while the union-find runs
+	m_IslandParents.resize(num_objects);
+	m_IslandIds.resize(num_objects);
+	for (int i = 0; i < num_objects; ++i)
+	{
+		m_IslandParents[i] = i;
+		m_IslandIds[i] = -1;
+		m_PhysicsObjects[i]->m_IslandIndex = i;
+	}
+
+	auto join = [this](PhysicsObject* a, PhysicsObject* b)
+	{
+		//Static objects are never joined, otherwise everything resting on the ground would become one island
+		if (!IsDynamic(a) || !IsDynamic(b))
+			return;
+
+		int ra = FindIslandRoot(m_IslandParents, a->m_IslandIndex);
+		int rb = FindIslandRoot(m_IslandParents, b->m_IslandIndex);
+		if (ra != rb)
 		{
-			c->ApplyImpulse();
+			//Always keep the lowest index as the root, so island order only depends on object order
+			if (ra < rb)	m_IslandParents[rb] = ra;
+			else			m_IslandParents[ra] = rb;
+		}
+	};
+
+	for (Manifold* m : m_vpManifolds)			join(m->NodeA(), m->NodeB());
+	for (Manifold* m : m_vpSleepingManifolds)	join(m->NodeA(), m->NodeB());
+	for (Constraint* c : m_vpConstraints)				join(c->GetObjectA(), c->GetObjectB());
+	ForEachConstraintPool([&](auto& pool)
+	{
+		for (auto& c : pool)	join(c.GetObjectA(), c.GetObjectB());
+	});
+
+	//Unbound constraints could act on any dynamic object, so if there are any they all
+	// have to be solved together in one shared island (on a single thread)
+	PhysicsObject* shared_obj = NULL;
+	if (std::any_of(m_vpConstraints.begin(), m_vpConstraints.end(), [](const Constraint* c) { return IsUnboundConstraint(*c); }))
+	{
+		for (PhysicsObject* obj : m_PhysicsObjects)
+		{
+			if (!IsDynamic(obj))
+				continue;
+
+			if (shared_obj == NULL)	shared_obj = obj;
+			else					join(shared_obj, obj);
+		}
+	}
+
+	//An island is either entirely awake or entirely asleep - so if anything in it is
+	// awake (e.g. an object has just landed on a sleeping pile) wake up the lot.
+	m_IslandAwake.assign(num_objects, 0);
+	for (int i = 0; i < num_objects; ++i)
+	{
+		if (IsAwakeDynamic(m_PhysicsObjects[i]))
+			m_IslandAwake[FindIslandRoot(m_IslandParents, i)] = 1;
+	}
+
+	auto wake_if_moving_static = [this](PhysicsObject* a, PhysicsObject* b)
+	{
+		if (IsDynamic(b) && IsMovingStatic(a))
+			m_IslandAwake[FindIslandRoot(m_IslandParents, b->m_IslandIndex)] = 1;
+	};
+	for (Manifold* m : m_vpManifolds)
+	{
+		wake_if_moving_static(m->NodeA(), m->NodeB());
+		wake_if_moving_static(m->NodeB(), m->NodeA());
+	}
+	for (Manifold* m : m_vpSleepingManifolds)
+	{
+		wake_if_moving_static(m->NodeA(), m->NodeB());
+		wake_if_moving_static(m->NodeB(), m->NodeA());
+	}
+
+	for (int i = 0; i < num_objects; ++i)
+	{
+		if (m_IslandAwake[FindIslandRoot(m_IslandParents, i)])
+			m_PhysicsObjects[i]->WakeUp();
+	}
+
+	//Contacts between objects that have just been woken up were skipped by the narrowphase,
+	// so collide them now to have them solved this step along with the rest of the island.
+	if (!m_vpSleepingManifolds.empty())
+	{
+		CollisionDispatch colDetect;
+		NarrowPhaseResult result;
+		for (Manifold* m : m_vpSleepingManifolds)
+		{
+			if (!IsAwakeDynamic(m->NodeA()) && !IsAwakeDynamic(m->NodeB()))
+				continue;
+
+			CollisionPair cp;
+			cp.pObjectA = m->NodeA();
+			cp.pObjectB = m->NodeB();
+			if (CollidePair(colDetect, cp, result))
+			{
+				ProcessNarrowPhaseResult(result);
+			}
+		}
+	}
+
+	//Flag the awake islands that have something to solve - free floating objects that
+	// are not touching anything are not given an island at all
+	for (Manifold* m : m_vpManifolds)
+	{
+		PhysicsObject* obj = IsDynamic(m->NodeA()) ? m->NodeA() : m->NodeB();
+		if (IsDynamic(obj))
+			m_IslandIds[FindIslandRoot(m_IslandParents, obj->m_IslandIndex)] = 0;
+	}
+
+	auto flag_constraint = [&](const Constraint& c)
+	{
+		PhysicsObject* obj = IsUnboundConstraint(c) ? shared_obj : (IsDynamic(c.GetObjectA()) ? c.GetObjectA() : c.GetObjectB());
+		if (IsAwakeDynamic(obj))
+			m_IslandIds[FindIslandRoot(m_IslandParents, obj->m_IslandIndex)] = 0;
+	};
+	for (Constraint* c : m_vpConstraints)				flag_constraint(*c);
+	ForEachConstraintPool([&](auto& pool)
+	{
+		for (auto& c : pool)	flag_constraint(c);
+	});
+
+	//Number the islands in object order
+	for (Island& island : m_Islands)
+	{
+		island.manifolds.clear();
+		island.constraints.clear();
+		island.numObjects = 0;
+		island.iterations = 0;
+		island.residual = 0.0f;
+	}
+
+	m_NumIslands = 0;
+	for (int i = 0; i < num_objects; ++i)
+	{
+		int root = FindIslandRoot(m_IslandParents, i);
+		if (m_IslandIds[root] == 0 && root == i)
+		{
+			//Root is always the lowest index in the island, so is visited first
+			m_IslandIds[root] = ++m_NumIslands;
+			if ((int)m_Islands.size() < m_NumIslands)
+			{
+				m_Islands.push_back(Island());
+				m_Islands.back().numObjects = 0;
+				m_Islands.back().iterations = 0;
+				m_Islands.back().residual = 0.0f;
+			}
+		}
+	}
+
+	m_LargestIslandSize = 0;
+	for (int i = 0; i < num_objects; ++i)
+	{
+		PhysicsObject* obj = m_PhysicsObjects[i];
+		int id = IsDynamic(obj) ? m_IslandIds[FindIslandRoot(m_IslandParents, i)] - 1 : -1;
+		if (id < 0)
+			id = -1;
+
+		obj->m_IslandIndex = id;
+		if (id >= 0)
+		{
+			m_Islands[id].numObjects++;
+			m_LargestIslandSize = max(m_LargestIslandSize, m_Islands[id].numObjects);
+		}
+	}
+
+	//Hand each manifold/constraint to the island of (either of) its dynamic objects
+	for (Manifold* m : m_vpManifolds)
+	{
+		PhysicsObject* obj = IsDynamic(m->NodeA()) ? m->NodeA() : m->NodeB();
+		if (IsDynamic(obj))
+			m_Islands[obj->m_IslandIndex].manifolds.push_back(m);
+	}
+
+	for (Constraint* c : m_vpConstraints)
+	{
+		PhysicsObject* obj = IsUnboundConstraint(*c) ? shared_obj : (IsDynamic(c->GetObjectA()) ? c->GetObjectA() : c->GetObjectB());
+		if (IsAwakeDynamic(obj))
+			m_Islands[obj->m_IslandIndex].constraints.custom.push_back(c);
+	}
+
+	ForEachConstraintPool([&](auto& pool)
+	{
+		for (int i = 0; i < pool.Size(); ++i)
+		{
+			PhysicsObject* obj = IsDynamic(pool[i].GetObjectA()) ? pool[i].GetObjectA() : pool[i].GetObjectB();
+			if (IsAwakeDynamic(obj))
+				m_Islands[obj->m_IslandIndex].constraints.pooled[pool.GetType()].push_back(i);
+		}
+	});
+}
+
+void PhysicsEngine::UpdateSleeping()
+{
+	const int num_objects = (int)m_PhysicsObjects.size();
+
+	//Update the sleep timers, keeping track of the least rested object in each island.
+	// The union-find forest from BuildIslands is still valid here.
+	const float lin_sq = m_SleepLinearVelocity * m_SleepLinearVelocity;
+	const float ang_sq = m_SleepAngularVelocity * m_SleepAngularVelocity;
+
+	m_IslandSleepTimers.assign(num_objects, FLT_MAX);
+	for (int i = 0; i < num_objects; ++i)
+	{
+		PhysicsObject* obj = m_PhysicsObjects[i];
+		if (!IsAwakeDynamic(obj))
+			continue;
+
+		if (obj->GetLinearVelocity().LengthSquared() < lin_sq
+			&& obj->GetAngularVelocity().LengthSquared() < ang_sq)
+		{
+			obj->m_SleepTimer += m_UpdateTimestep;
+		}
+		else
+		{
+			obj->m_SleepTimer = 0.0f;
+		}
+
+		float& island_timer = m_IslandSleepTimers[FindIslandRoot(m_IslandParents, i)];
+		island_timer = min(island_timer, obj->m_SleepTimer);
+	}
+
+	//Islands only go to sleep as a whole, once every object in them has been at rest
+	m_NumSleeping = 0;
+	for (int i = 0; i < num_objects; ++i)
+	{
+		PhysicsObject* obj = m_PhysicsObjects[i];
+		if (m_SleepTime > 0.0f
+			&& IsAwakeDynamic(obj)
+			&& m_IslandSleepTimers[FindIslandRoot(m_IslandParents, i)] >= m_SleepTime)
+		{
+			obj->PutToSleep();
+		}
+
+		if (obj->IsSleeping())
+		{
+			m_NumSleeping++;
 		}
 	}
 }
@@ -218,29 +1223,7 @@ void PhysicsEngine::UpdatePhysicsObject(PhysicsObject* obj)
 	}
 
 	/* TUTORIAL 2 */
-	if (obj->m_InvMass > 0.0f)
-	{
-		obj->m_LinearVelocity += m_Gravity * m_UpdateTimestep;
-	}
-	
-	obj->m_LinearVelocity += obj->m_Force * obj->m_InvMass * m_UpdateTimestep;
-	obj->m_LinearVelocity = obj->m_LinearVelocity * m_DampingFactor;
-
-	obj->m_AngularVelocity += obj->m_InvInertia * obj->m_Torque * m_UpdateTimestep;
-	obj->m_AngularVelocity = obj->m_AngularVelocity * m_DampingFactor;
-
-	if (m_IsInCourseWork && obj->m_isSleep)
-	{
-		obj->m_LinearVelocity = Vector3 (0.0f, 0.0f, 0.0f);
-		obj->m_AngularVelocity = Vector3 (0.0f, 0.0f, 0.0f);
-	}
-
-	obj->m_Position += obj->m_LinearVelocity * m_UpdateTimestep;
-
-	obj->m_Orientation = obj->m_Orientation + obj->m_Orientation * (obj->m_AngularVelocity * m_UpdateTimestep * 0.5f);
-	obj->m_Orientation.Normalise ();
-
-	obj->m_wsTransformInvalidated = true;
+	m_BodyStore.IntegrateBody(obj->m_BodyIndex, m_Gravity, m_DampingFactor, m_UpdateTimestep);
 }
 
 
@@ -248,9 +1231,31 @@ void PhysicsEngine::BroadPhaseCollisions()
 {
 	m_BroadphaseCollisionPairs.clear();
 
-	if (m_IsInCourseWork && m_isUseOcTree)
+	if (m_BroadphaseMode == BROADPHASE_OCTREE)
+	{
+		//	The loose OcTree persists between frames, only objects that have
+		//  left the loose bounds of their node get moved.
+		m_OcTree.Update ();
+		m_OcTree.GenerateCPs (m_BroadphaseCollisionPairs);
+	}
+	else if (m_BroadphaseMode == BROADPHASE_SWEEPANDPRUNE)
+	{
+		//	Sweep and prune keeps its sorted endpoint lists between frames, so
+		//  only the objects that moved past each other need any work.
+		m_SweepAndPrune.GenerateCPs(m_BroadphaseCollisionPairs);
+	}
+	else if (m_BroadphaseMode == BROADPHASE_AABBTREE)
+	{
+		//	Only objects that have left their fat aabb get reinserted, then the
+		//  tree is collided against itself to find the overlapping leaves.
+		m_AABBTree.UpdateObjects(m_UpdateTimestep);
+		m_AABBTree.GenerateCPs(m_BroadphaseCollisionPairs);
+	}
+	else if (m_BroadphaseMode == BROADPHASE_SPATIALHASH)
 	{
-		root->GenerateCPs (m_BroadphaseCollisionPairs);
+		//	Objects are binned into uniform grid cells and only tested
+		//  against other objects sharing a cell.
+		m_SpatialHash.GenerateCPs(m_BroadphaseCollisionPairs);
 	}
 	else
 	{
@@ -291,97 +1296,201 @@ void PhysicsEngine::BroadPhaseCollisions()
 
 void PhysicsEngine::NarrowPhaseCollisions ()
 {
-	if (m_BroadphaseCollisionPairs.size() > 0)
+	const int num_pairs = (int)m_BroadphaseCollisionPairs.size();
+	if (num_pairs > 0)
 	{
-		//Collision data to pass between detection and manifold generation stages.
-		CollisionData colData;				
+		//World space transforms and hulls are cached on first use, so make sure they are
+		// all built before the worker threads start reading them concurrently. Anything
+		// that hasn't moved since the last step (e.g. sleeping or static objects) just
+		// keeps its old ones.
+		for (PhysicsObject* obj : m_PhysicsObjects)
+		{
+			obj->GetWorldSpaceTransform();
+			obj->GetWorldSpaceHull();
+		}
 
-		//Collision Detection Algorithm to use
-		CollisionDetectionSAT colDetect;	
+		const int max_threads = omp_get_max_threads();
+		if (m_NarrowPhaseBuffers.size() < (size_t)max_threads)
+		{
+			m_NarrowPhaseBuffers.resize(max_threads);
+		}
 
-		// Iterate over all possible collision pairs and perform accurate collision detection
-		for (size_t i = 0; i < m_BroadphaseCollisionPairs.size(); ++i)
+		for (std::vector<NarrowPhaseResult>& results : m_NarrowPhaseBuffers)
 		{
-			CollisionPair& cp = m_BroadphaseCollisionPairs[i];
+			results.clear();
+		}
 
-			CollisionShape *shapeA = cp.pObjectA->GetCollisionShape();
-			CollisionShape *shapeB = cp.pObjectB->GetCollisionShape();
+		#pragma omp parallel num_threads(max_threads)
+		{
+			const int thread_id = omp_get_thread_num();
+			const int num_threads = omp_get_num_threads();
 
-			colDetect.BeginNewPair(
-				cp.pObjectA,
-				cp.pObjectB,
-				cp.pObjectA->GetCollisionShape(),
-				cp.pObjectB->GetCollisionShape());
+			//Each thread takes one contiguous block of pairs, so merging the buffers
+			// in thread order gives the same ordering as a single threaded loop.
+			const int begin = (num_pairs * thread_id) / num_threads;
+			const int end = (num_pairs * (thread_id + 1)) / num_threads;
 
-			//--TUTORIAL 4 CODE--
-			// Detects if the objects are colliding - Seperating Axis Theorem
-			if (colDetect.AreColliding(&colData))
+			std::vector<NarrowPhaseResult>& results = m_NarrowPhaseBuffers[thread_id];
+
+			//Collision Detection Algorithm to use (one per thread, as it stores per-pair state)
+			CollisionDispatch colDetect;
+			NarrowPhaseResult result;
+
+			// Iterate over all possible collision pairs and perform accurate collision detection
+			for (int i = begin; i < end; ++i)
 			{
-				//Draw collision data to the window if requested
-				// - Have to do this here as colData is only temporary. 
-				if (m_DebugDrawFlags & DEBUGDRAW_FLAGS_COLLISIONNORMALS)
+				CollisionPair& cp = m_BroadphaseCollisionPairs[i];
+
+				//Sleeping objects have not moved, so if neither object can move the contact
+				// from when they fell asleep (if any) is still valid - just hold on to it
+				if ((cp.pObjectA->IsSleeping() || cp.pObjectB->IsSleeping())
+					&& !IsWaker(cp.pObjectA) && !IsWaker(cp.pObjectB))
 				{
-					NCLDebug::DrawPointNDT(colData._pointOnPlane, 0.1f, Vector4(0.5f, 0.5f, 1.0f, 1.0f));
-					NCLDebug::DrawThickLineNDT(colData._pointOnPlane, colData._pointOnPlane - colData._normal * colData._penetration, 0.05f, Vector4(0.0f, 0.0f, 1.0f, 1.0f));
+					auto found_loc = m_ManifoldCache.find(MakeManifoldKey(cp.pObjectA, cp.pObjectB));
+					if (found_loc != m_ManifoldCache.end())
+					{
+						result.pair = cp;
+						result.manifold = found_loc->second.manifold;
+						result.isNewManifold = false;
+						result.isSleeping = true;
+						results.push_back(result);
+					}
+					continue;
 				}
 
-				//Check to see if any of the objects have collision callbacks that dont want the objects to physically collide
-				bool okA = cp.pObjectA->FireOnCollisionEvent(cp.pObjectA, cp.pObjectB);
-				bool okB = cp.pObjectB->FireOnCollisionEvent(cp.pObjectB, cp.pObjectA);
+				if (CollidePair(colDetect, cp, result))
+				{
+					results.push_back(result);
+				}
+			}
+		}
 
-				if (okA && okB)
+		//Merge the thread results - anything that touches shared state (debug drawing,
+		// collision callbacks and coursework scoring) is deferred until here.
+		for (std::vector<NarrowPhaseResult>& results : m_NarrowPhaseBuffers)
+		{
+			for (NarrowPhaseResult& result : results)
+			{
+				if (result.isSleeping)
 				{
-					if (m_IsInCourseWork)
-					{
-						Vector3 posObjA = cp.pObjectA->GetPosition ();
-						Vector3 posObjB = cp.pObjectB->GetPosition ();
+					result.pair.pObjectA->m_isColl = true;
+					result.pair.pObjectB->m_isColl = true;
 
-						if (cp.pObjectA->m_isBullet && 
-							cp.pObjectB->m_isTarget && 
-							cp.pObjectA->m_isHitTarget == false)
-						{
-							cp.pObjectA->m_isHitTarget = true;
-							m_ShotPoints = CalcBulletPoints (posObjA, posObjB);
-						}
-						else if (cp.pObjectA->m_isTarget && 
-								 cp.pObjectB->m_isBullet &&
-								 cp.pObjectB->m_isHitTarget == false)
-						{
-							cp.pObjectB->m_isHitTarget = true;
-							m_ShotPoints = CalcBulletPoints (posObjA, posObjB);
-						}
+					m_vpSleepingManifolds.push_back(result.manifold);
+					m_ManifoldCache[MakeManifoldKey(result.pair.pObjectA, result.pair.pObjectB)].lastActiveStep = m_StepCounter;
+				}
+				else
+				{
+					ProcessNarrowPhaseResult(result);
+				}
+			}
+		}
+	}
 
-						if (cp.pObjectA->m_isSleep && 
-							cp.pObjectB->m_isSleep == false && 
-							cp.pObjectB->m_isBullet)
-						{
-							cp.pObjectA->m_isSleep = false;
-						}
+	//Delete any manifolds whose objects are no longer colliding
+	for (auto itr = m_ManifoldCache.begin(); itr != m_ManifoldCache.end(); )
+	{
+		if (itr->second.lastActiveStep != m_StepCounter)
+		{
+			delete itr->second.manifold;
+			itr = m_ManifoldCache.erase(itr);
+		}
+		else
+		{
+			++itr;
+		}
+	}
+}
 
-						if (cp.pObjectB->m_isSleep && 
-							cp.pObjectA->m_isSleep == false && 
-							cp.pObjectA->m_isBullet)
-						{
-							cp.pObjectB->m_isSleep = false;
-						}
-					}
+bool PhysicsEngine::CollidePair(CollisionDispatch& colDetect, const CollisionPair& cp, NarrowPhaseResult& result)
+{
+	//Look for the manifold used by this pair last frame (read only, so safe
+	// to do from every thread). If found, keep the same object ordering.
+	Manifold* cached = NULL;
+	PhysicsObject* objA = cp.pObjectA;
+	PhysicsObject* objB = cp.pObjectB;
+
+	auto found_loc = m_ManifoldCache.find(MakeManifoldKey(objA, objB));
+	if (found_loc != m_ManifoldCache.end())
+	{
+		cached = found_loc->second.manifold;
+		objA = cached->NodeA();
+		objB = cached->NodeB();
+	}
 
-					cp.pObjectA->m_isColl = true;
-					cp.pObjectB->m_isColl = true;
-					//-- TUTORIAL 5 CODE --
-					// Build full collision manifold that will also handle the collision response between the two objects in the solver stage
-					Manifold* manifold = new Manifold();
-					manifold->Initiate(cp.pObjectA, cp.pObjectB);
+	colDetect.BeginNewPair(objA, objB);
+
+	//--TUTORIAL 4 CODE--
+	// Detects if the objects are colliding - Seperating Axis Theorem, or one of the
+	// dedicated routines for the pair's shapes
+	if (!colDetect.AreColliding(&result.colData))
+		return false;
+
+	//-- TUTORIAL 5 CODE --
+	// Build full collision manifold that will also handle the collision response between the two objects in the solver stage
+	result.pair = cp;
+	result.isNewManifold = (cached == NULL);
+	result.isSleeping = false;
+	result.manifold = result.isNewManifold ? new Manifold() : cached;
+	result.manifold->Initiate(objA, objB);
+
+	// Construct contact points that form the perimeter of the collision manifold
+	colDetect.GenContactPoints(result.manifold);
+	return true;
+}
 
-					// Construct contact points that form the perimeter of the collision manifold
-					colDetect.GenContactPoints(manifold);
+void PhysicsEngine::ProcessNarrowPhaseResult(NarrowPhaseResult& result)
+{
+	CollisionPair& cp = result.pair;
+	CollisionData& colData = result.colData;
 
-					// Add to list of manifolds that need solving
-					m_vpManifolds.push_back(manifold);
-				}
+	//Draw collision data to the window if requested
+	if (m_DebugDrawFlags & DEBUGDRAW_FLAGS_COLLISIONNORMALS)
+	{
+		NCLDebug::DrawPointNDT(colData._pointOnPlane, 0.1f, Vector4(0.5f, 0.5f, 1.0f, 1.0f));
+		NCLDebug::DrawThickLineNDT(colData._pointOnPlane, colData._pointOnPlane - colData._normal * colData._penetration, 0.05f, Vector4(0.0f, 0.0f, 1.0f, 1.0f));
+	}
+
+	//Check to see if any of the objects have collision callbacks that dont want the objects to physically collide
+	bool okA = cp.pObjectA->FireOnCollisionEvent(cp.pObjectA, cp.pObjectB);
+	bool okB = cp.pObjectB->FireOnCollisionEvent(cp.pObjectB, cp.pObjectA);
+
+	if (okA && okB)
+	{
+		if (m_IsInCourseWork)
+		{
+			Vector3 posObjA = cp.pObjectA->GetPosition ();
+			Vector3 posObjB = cp.pObjectB->GetPosition ();
+
+			if (cp.pObjectA->m_isBullet && 
+				cp.pObjectB->m_isTarget && 
+				cp.pObjectA->m_isHitTarget == false)
+			{
+				cp.pObjectA->m_isHitTarget = true;
+				m_ShotPoints = CalcBulletPoints (posObjA, posObjB);
+			}
+			else if (cp.pObjectA->m_isTarget && 
+					 cp.pObjectB->m_isBullet &&
+					 cp.pObjectB->m_isHitTarget == false)
+			{
+				cp.pObjectB->m_isHitTarget = true;
+				m_ShotPoints = CalcBulletPoints (posObjA, posObjB);
 			}
 		}
 
+		cp.pObjectA->m_isColl = true;
+		cp.pObjectB->m_isColl = true;
+
+		// Add to list of manifolds that need solving
+		m_vpManifolds.push_back(result.manifold);
+
+		ManifoldCacheEntry& entry = m_ManifoldCache[MakeManifoldKey(cp.pObjectA, cp.pObjectB)];
+		entry.manifold = result.manifold;
+		entry.lastActiveStep = m_StepCounter;
+	}
+	else if (result.isNewManifold)
+	{
+		delete result.manifold;
 	}
 }
 
@@ -404,6 +1513,14 @@ void PhysicsEngine::DebugRender ()
 		{
 			c->DebugDraw();
 		}
+
+		ForEachConstraintPool([](auto& pool)
+		{
+			for (auto& c : pool)
+			{
+				c.DebugDraw();
+			}
+		});
 	}
 
 	// Draw all associated collision shapes
@@ -417,6 +1534,17 @@ void PhysicsEngine::DebugRender ()
 			}
 		}
 	}
+
+	// Draw the persistent broadphase structure
+	if (m_DebugDrawFlags & DEBUGDRAW_FLAGS_BROADPHASE)
+	{
+		if (m_BroadphaseMode == BROADPHASE_OCTREE)
+			m_OcTree.Draw();
+		else if (m_BroadphaseMode == BROADPHASE_AABBTREE)
+			m_AABBTree.DebugDraw();
+		else if (m_BroadphaseMode == BROADPHASE_SPATIALHASH)
+			m_SpatialHash.DebugDraw();
+	}
 }
 
 float PhysicsEngine::CalcBulletPoints (Vector3 v1, Vector3 v2)
@@ -426,14 +1554,36 @@ float PhysicsEngine::CalcBulletPoints (Vector3 v1, Vector3 v2)
 	return 10.0f * (4.0f - dis);
 }
 
-void PhysicsEngine::CreateOcTree ()
+const char* PhysicsEngine::GetSolverModeName (SolverMode mode)
+{
+	switch (mode)
+	{
+	case SOLVER_ISLANDS:			return "Islands";
+	case SOLVER_GRAPHCOLOURING:		return "Graph Colouring";
+	case SOLVER_JACOBI:				return "Jacobi";
+	default:						return "Unknown";
+	}
+}
+
+const char* PhysicsEngine::GetPositionCorrectionModeName (PositionCorrectionMode mode)
 {
-	root = new OcTree (Vector3 (-10.f, -10.f, -10.f), 32.0f, m_PhysicsObjects);
-	root->BulidOcTree ();
+	switch (mode)
+	{
+	case POSITION_CORRECTION_BAUMGARTE:	return "Baumgarte";
+	case POSITION_CORRECTION_NGS:		return "Nonlinear Gauss-Seidel";
+	default:							return "Unknown";
+	}
 }
 
-void PhysicsEngine::DestoryOcTree ()
+const char* PhysicsEngine::GetBroadphaseModeName (BroadphaseMode mode)
 {
-	root->Delete ();
-	root = NULL;
-}
\ No newline at end of file
+	switch (mode)
+	{
+	case BROADPHASE_BRUTEFORCE:		return "Brute Force";
+	case BROADPHASE_OCTREE:			return "OcTree";
+	case BROADPHASE_SWEEPANDPRUNE:	return "Sweep and Prune";
+	case BROADPHASE_AABBTREE:		return "AABB Tree";
+	case BROADPHASE_SPATIALHASH:	return "Spatial Hash";
+	default:						return "Unknown";
+	}
+}
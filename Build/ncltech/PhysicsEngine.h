@@ -33,6 +33,10 @@ The general runtime consists of:
 		   Moves all physics objects through time, updating positions/rotations
 		   etc. (Tutorial 2)
 
+		 - Position Correction (optional)
+		   Pushes apart anything still penetrating once the objects have moved,
+		   without adding any velocity to them.
+
 		(\_/)
 		( '_')
 	 /""""""""""""\=========     -----D
@@ -44,14 +48,31 @@ The general runtime consists of:
 #pragma once
 #include "TSingleton.h"
 #include "PhysicsObject.h"
+#include "PhysicsBodyStore.h"
 #include "Constraint.h"
+#include "ConstraintPool.h"
+#include "DistanceConstraint.h"
+#include "BallSocketConstraint.h"
+#include "HingeConstraint.h"
+#include "SliderConstraint.h"
 #include "Manifold.h"
+#include "CollisionDispatch.h"
 #include <vector>
+#include <unordered_map>
 #include <mutex>
 #include "AABB.h"
 #include "OcTree.h"
+#include "SweepAndPrune.h"
+#include "DynamicAABBTree.h"
+#include "SpatialHashGrid.h"
+
+#define DEFAULT_SOLVER_MIN_ITERATIONS	4		//Always run a few iterations, as the first ones are dominated by friction rather than the contact impulses
+#define DEFAULT_SOLVER_MAX_ITERATIONS	20		//Contacts are warm started from the previous frame, so far fewer iterations are needed
+#define DEFAULT_SOLVER_TOLERANCE		0.001f	//Stop once no contact/constraint impulse changes by more than this (kg m/s) in an iteration
 
-#define SOLVER_ITERATIONS 50
+#define DEFAULT_SLEEP_TIME				0.5f	//Seconds an island has to stay below the sleep velocities before it goes to sleep
+#define DEFAULT_SLEEP_LINEAR_VELOCITY	0.25f	//m/s - resting stacks still jitter a little with the iterative solver
+#define DEFAULT_SLEEP_ANGULAR_VELOCITY	0.25f	//rad/s
 
 #ifndef FALSE
 	#define FALSE	0
@@ -62,7 +83,42 @@ The general runtime consists of:
 #define DEBUGDRAW_FLAGS_MANIFOLD				0x2
 #define DEBUGDRAW_FLAGS_COLLISIONVOLUMES		0x4
 #define DEBUGDRAW_FLAGS_COLLISIONNORMALS		0x8
+#define DEBUGDRAW_FLAGS_BROADPHASE				0x10
+
+
+//Broadphase algorithm used to build the list of possible collision pairs
+enum BroadphaseMode
+{
+	BROADPHASE_BRUTEFORCE = 0,		//Every object against every other object - O(n^2)
+	BROADPHASE_OCTREE,				//Persistent loose OcTree
+	BROADPHASE_SWEEPANDPRUNE,		//Persistent sorted endpoint lists on all three axes
+	BROADPHASE_AABBTREE,			//Dynamic bounding volume hierarchy of fat aabbs
+	BROADPHASE_SPATIALHASH,			//Uniform grid of hashed cells, best for lots of similar sized objects
+	BROADPHASE_MAX
+};
+
+//Algorithm used to solve the manifolds and constraints each step
+enum SolverMode
+{
+	SOLVER_ISLANDS = 0,				//Sequential gauss-seidel, with each island solved on its own thread
+	SOLVER_GRAPHCOLOURING,			//Gauss-seidel over coloured batches that share no dynamic objects, each batch split across all threads
+	SOLVER_JACOBI,					//Every manifold/constraint solved at once against the same velocities, changes applied at the end of each iteration
+	SOLVER_MAX
+};
+
+//How penetrating contacts (and built in constraints that have drifted) are pushed back into place
+enum PositionCorrectionMode
+{
+	POSITION_CORRECTION_BAUMGARTE = 0,	//Part of the error is added to the velocity solve as a bias - cheap, but adds energy, so stacks jitter unless given lots of iterations
+	POSITION_CORRECTION_NGS,			//Separate nonlinear gauss-seidel pass on the positions after integration - velocities are left alone, so far fewer velocity iterations are needed
+	POSITION_CORRECTION_MAX
+};
+
+#define DEFAULT_POSITION_ITERATIONS	3		//Position iterations per step, each island stops early once all of its errors are within the slop
+
+#define DEFAULT_JACOBI_RELAXATION	0.2f	//Each contact point pushes as if it were on its own, so resting boxes (4+ contacts each) need a lot of damping
 
+#define MAX_SOLVER_COLOURS		64	//Anything left over once all colours are in use goes in one last batch that is solved on a single thread
 
 struct CollisionPair	//Forms the output of the broadphase collision detection
 {
@@ -70,6 +126,86 @@ struct CollisionPair	//Forms the output of the broadphase collision detection
 	PhysicsObject* pObjectB;
 };
 
+struct NarrowPhaseResult	//Colliding pair found by a narrowphase worker thread, waiting to be merged
+{
+	CollisionPair	pair;
+	CollisionData	colData;
+	Manifold*		manifold;
+	bool			isNewManifold;	//False if the manifold was reused from the cache
+	bool			isSleeping;		//Pair was skipped as neither object can move, manifold is last frame's (if any)
+};
+
+//Manifolds are kept alive between frames, keyed on the (ordered) pair of objects
+typedef std::pair<PhysicsObject*, PhysicsObject*> ManifoldKey;
+
+struct ManifoldKeyHash
+{
+	size_t operator()(const ManifoldKey& key) const
+	{
+		return std::hash<PhysicsObject*>()(key.first) ^ (std::hash<PhysicsObject*>()(key.second) * 31);
+	}
+};
+
+struct ManifoldCacheEntry
+{
+	Manifold*	manifold;
+	uint		lastActiveStep;		//Entries not touched during a step are deleted at the end of the narrowphase
+};
+
+//Constraints to be solved together (by one island, colour batch or the jacobi solver). Each
+// pool's constraints get a list of their own, so that they can be solved in a tight loop
+// without any virtual calls - only custom constraints go through the Constraint interface.
+struct ConstraintLists
+{
+	std::vector<Constraint*>	custom;			//Added through AddConstraint(Constraint*)
+	std::vector<int>			pooled[CONSTRAINT_MAX];	//Indices into each of the engine's pools, by ConstraintType
+
+	void clear()
+	{
+		custom.clear();
+		for (std::vector<int>& p : pooled) p.clear();
+	}
+
+	size_t size() const
+	{
+		size_t n = custom.size();
+		for (const std::vector<int>& p : pooled) n += p.size();
+		return n;
+	}
+};
+
+//Group of dynamic objects connected through contacts/constraints. Islands do not share
+// any dynamic objects with one another, so each can be solved on its own thread.
+struct Island
+{
+	std::vector<Manifold*>		manifolds;
+	ConstraintLists				constraints;
+	int							numObjects;
+	int							iterations;		//Solver iterations used last step
+	float						residual;		//Largest change in impulse during the last iteration
+};
+
+//Manifolds and constraints that do not share any dynamic objects with one another, so
+// can all be solved at the same time. Static objects may be shared, as they are never written to.
+struct ColourBatch
+{
+	std::vector<Manifold*>		manifolds;
+	ConstraintLists				constraints;
+};
+
+//Velocity changes the jacobi solver has to add up for a body - points into the
+// VelocityDelta of a manifold/constraint acting on it
+struct JacobiEntry
+{
+	const Vector3*	linear;
+	const Vector3*	angular;
+};
+
+inline ManifoldKey MakeManifoldKey(PhysicsObject* a, PhysicsObject* b)
+{
+	return (a < b) ? ManifoldKey(a, b) : ManifoldKey(b, a);
+}
+
 class PhysicsEngine : public TSingleton<PhysicsEngine>
 {
 	friend class TSingleton < PhysicsEngine > ;
@@ -82,8 +218,25 @@ public:
 	void RemovePhysicsObject(PhysicsObject* obj);
 	void RemoveAllPhysicsObjects(); //Delete all physics entities etc and reset-physics environment for new scene to be initialized
 
-	//Add Constraints
-	void AddConstraint(Constraint* c) { m_vpConstraints.push_back(c); }
+	//Add Constraints - wakes up the objects the constraint acts upon
+	// - Built in constraint types are copied into a pool of their own, and can be looked
+	//   up again (or removed) through the returned handle
+	// - Any other (custom) constraint is solved through the Constraint interface, and is
+	//   owned and deleted by the physics engine
+	ConstraintHandle AddConstraint(const DistanceConstraint& c);
+	ConstraintHandle AddConstraint(const BallSocketConstraint& c);
+	ConstraintHandle AddConstraint(const HingeConstraint& c);
+	ConstraintHandle AddConstraint(const SliderConstraint& c);
+	void AddConstraint(Constraint* c);
+
+	//Returns NULL if the constraint has been removed. Only valid until the next constraint is added/removed.
+	DistanceConstraint*		GetDistanceConstraint(const ConstraintHandle& h)	{ return m_DistanceConstraints.Get(h); }
+	BallSocketConstraint*	GetBallSocketConstraint(const ConstraintHandle& h)	{ return m_BallSocketConstraints.Get(h); }
+	HingeConstraint*		GetHingeConstraint(const ConstraintHandle& h)		{ return m_HingeConstraints.Get(h); }
+	SliderConstraint*		GetSliderConstraint(const ConstraintHandle& h)		{ return m_SliderConstraints.Get(h); }
+
+	//Returns false if the constraint has already been removed
+	bool RemoveConstraint(const ConstraintHandle& h);
 	
 
 	//Update Physics Engine
@@ -120,16 +273,74 @@ public:
 	bool HasAtmosphere	()				{ return m_HasAtmosphere; }
 	void SetHasAtmosphere (bool b)		{ m_HasAtmosphere = b; }
 
-	void CreateOcTree ();
-	void DestoryOcTree ();
-	OcTree* GetOcTreeRoot ()			{ return root; }
+	OcTree* GetOcTree ()				{ return &m_OcTree; }
 
 	int GetCollisionPairs ()			{ return m_BroadphaseCollisionPairs.size (); }
 
-	bool GetIsUseOcTree ()				{ return m_isUseOcTree; }
+	BroadphaseMode GetBroadphaseMode ()			{ return m_BroadphaseMode; }
+	void SetBroadphaseMode (BroadphaseMode mode){ m_BroadphaseMode = mode; }
+	static const char* GetBroadphaseModeName (BroadphaseMode mode);
+
+	SolverMode GetSolverMode ()					{ return m_SolverMode; }
+	void SetSolverMode (SolverMode mode)		{ m_SolverMode = mode; }
+	static const char* GetSolverModeName (SolverMode mode);
+
+	//Number of colours used by the graph colouring solver last step (including the overflow batch)
+	int GetNumSolverColours ()					{ return m_NumColours; }
+
+	//Each island is solved until the largest change in any impulse over an iteration
+	// drops below the tolerance, as long as it has had at least the min iterations, and
+	// never more than the max. Set min and max the same to always run a fixed number.
+	// The graph colouring and jacobi solvers do not solve islands on their own, so they
+	// keep going until everything has converged.
+	int GetSolverMinIterations ()				{ return m_SolverMinIterations; }
+	int GetSolverMaxIterations ()				{ return m_SolverMaxIterations; }
+	void SetSolverIterations (int min_iterations, int max_iterations) { m_SolverMinIterations = min_iterations; m_SolverMaxIterations = max_iterations; }
+	float GetSolverTolerance ()					{ return m_SolverTolerance; }
+	void SetSolverTolerance (float t)			{ m_SolverTolerance = t; }
+
+	//Solver iterations/residuals used last step (per island from GetIsland)
+	float GetSolverAverageIterations ()			{ return m_SolverAverageIterations; }
+	int GetSolverMostIterations ()				{ return m_SolverMostIterations; }
+	float GetSolverResidual ()					{ return m_SolverResidual; }
+	const Island& GetIsland (int i)				{ return m_Islands[i]; }
+
+	//Custom constraints always correct themselves through their velocities
+	PositionCorrectionMode GetPositionCorrectionMode ()			{ return m_PositionCorrectionMode; }
+	void SetPositionCorrectionMode (PositionCorrectionMode mode){ m_PositionCorrectionMode = mode; }
+	static const char* GetPositionCorrectionModeName (PositionCorrectionMode mode);
+
+	//Most iterations of the position correction pass per step (each island stops once it is within the slop)
+	int GetPositionIterations ()				{ return m_PositionIterations; }
+	void SetPositionIterations (int iterations)	{ m_PositionIterations = iterations; }
+
+	//Fraction of each jacobi iteration's changes that are actually applied
+	float GetJacobiRelaxation ()				{ return m_JacobiRelaxation; }
+	void SetJacobiRelaxation (float r)			{ m_JacobiRelaxation = r; }
+
+	//Edge length of the cells used by the spatial hash broadphase
+	float GetSpatialHashCellSize ()				{ return m_SpatialHash.GetCellSize (); }
+	void SetSpatialHashCellSize (float size)	{ m_SpatialHash.SetCellSize (size); }
+
+	//Islands found during the last step - objects not touching anything dynamic are not counted
+	int GetNumIslands ()				{ return m_NumIslands; }
+	int GetLargestIslandSize ()			{ return m_LargestIslandSize; }
+
+	//Objects are put to sleep once their whole island has been moving slower than the sleep
+	// velocities for the sleep time. A sleep time of zero disables automatic sleeping.
+	float GetSleepTime ()						{ return m_SleepTime; }
+	void SetSleepTime (float t)					{ m_SleepTime = t; }
+	float GetSleepLinearVelocity ()				{ return m_SleepLinearVelocity; }
+	void SetSleepLinearVelocity (float v)		{ m_SleepLinearVelocity = v; }
+	float GetSleepAngularVelocity ()			{ return m_SleepAngularVelocity; }
+	void SetSleepAngularVelocity (float v)		{ m_SleepAngularVelocity = v; }
+
+	int GetNumSleeping ()				{ return m_NumSleeping; }
+
+	bool GetIsUseOcTree ()				{ return m_BroadphaseMode == BROADPHASE_OCTREE; }
 	bool GetIsDrawOcTree ()				{ return m_isDrawOcTree; }
 
-	void SetIsUseOcTree (bool b)		{ m_isUseOcTree = b; }
+	void SetIsUseOcTree (bool b)		{ m_BroadphaseMode = b ? BROADPHASE_OCTREE : BROADPHASE_BRUTEFORCE; }
 	void SetIsDrawOcTree (bool b)		{ m_isDrawOcTree = b; }
 
 	bool GetIsZeroTrans ()				{ return m_isZeroTrans; }
@@ -142,18 +353,70 @@ protected:
 	//The actual time-independant update function
 	void UpdatePhysics();
 
+	//Calls f with each of the built in constraint pools in turn (in ConstraintType order), so
+	// the solvers can be written once for all of them and still get a tight loop per type
+	template <class F>
+	void ForEachConstraintPool(F f)
+	{
+		f(m_DistanceConstraints);
+		f(m_BallSocketConstraints);
+		f(m_HingeConstraints);
+		f(m_SliderConstraints);
+	}
+
 	//Handles broadphase collision detection
 	void BroadPhaseCollisions();
 
 	//Handles narrowphase collision detection
 	void NarrowPhaseCollisions();
 
-	//Updates all physics objects position, orientation, velocity etc - Tutorial 2
+	//Collides a single pair (reusing their cached manifold if there is one), returns true
+	// and fills in the result if they are colliding. Safe to call from worker threads.
+	bool CollidePair(CollisionDispatch& colDetect, const CollisionPair& cp, NarrowPhaseResult& result);
+
+	//Fires the collision callbacks for a colliding pair and hands its manifold to the solver
+	void ProcessNarrowPhaseResult(NarrowPhaseResult& result);
+
+	//Updates a single physics object's position, orientation, velocity etc - Tutorial 2
+	// Only used for the coursework scene, everything else is integrated in bulk by m_BodyStore
 	void UpdatePhysicsObject(PhysicsObject* obj);
 	
 	//Solves all physical constraints (constraints and manifolds)
 	void SolveConstraints();
 
+	//Splits all manifolds and constraints into independent islands - Static objects
+	// (inverse mass of zero) do not join islands together. Any island containing an awake
+	// object is woken up as a whole, islands that are entirely asleep are skipped.
+	void BuildIslands();
+	void SolveIsland(Island& island);
+
+	//Nonlinear gauss-seidel position correction, run after integration when enabled. Each
+	// awake island's manifolds/pooled constraints build up a displacement for their objects
+	// over a few iterations, which are then all applied to the bodies at once.
+	void SolvePositions();
+	void SolveIslandPositions(Island& island);
+
+	//Shares one thread's residual for an iteration with the rest of the threads solving, and
+	// returns the largest of them all. Must be called by every thread in the parallel region.
+	float ReduceSolverResidual(float residual, int iteration);
+
+	//Greedily colours the manifolds/constraints of all awake islands, so that no two in
+	// the same colour act on the same dynamic object. Each colour is then solved in parallel,
+	// one colour after another, which keeps large islands (e.g. stacks) on more than one thread.
+	void BuildColourBatches();
+	void SolveColourBatches();
+
+	//Solves the manifolds/constraints of all awake islands with jacobi iterations. Every
+	// manifold/constraint writes only to its own VelocityDelta, and each body then adds up
+	// the deltas acting on it - so both halves run across all threads without any locking.
+	void BuildJacobiBuffers();
+	void SolveJacobi();
+	void ApplyJacobiDeltas();
+
+	//Updates the sleep timers of all awake objects (from their integrated velocities), and
+	// puts any islands that have been at rest for long enough to sleep.
+	void UpdateSleeping();
+
 	float CalcBulletPoints (Vector3 v1, Vector3 v2);
 
 protected:
@@ -170,15 +433,65 @@ protected:
 	float		m_ShotPoints;
 
 	std::vector<CollisionPair> m_BroadphaseCollisionPairs;
+	std::vector<std::vector<NarrowPhaseResult>> m_NarrowPhaseBuffers;	// one output buffer per narrowphase thread, reused between frames
 
 	std::vector<PhysicsObject*> m_PhysicsObjects;
+	PhysicsBodyStore			m_BodyStore;			// integrated state of all objects in m_PhysicsObjects
+
+	std::vector<Constraint*>	m_vpConstraints;		// Custom constraints applying to one or more physics objects
+	ConstraintPool<DistanceConstraint>		m_DistanceConstraints;
+	ConstraintPool<BallSocketConstraint>	m_BallSocketConstraints;
+	ConstraintPool<HingeConstraint>			m_HingeConstraints;
+	ConstraintPool<SliderConstraint>		m_SliderConstraints;
+	std::vector<Manifold*>		m_vpManifolds;			// Contact constraints between pairs of objects that are colliding this step
+	std::vector<Manifold*>		m_vpSleepingManifolds;	// Contacts between sleeping objects, kept to link islands together but not solved
+
+	std::unordered_map<ManifoldKey, ManifoldCacheEntry, ManifoldKeyHash> m_ManifoldCache;	// owns all manifolds, persistent across frames
+	uint						m_StepCounter;
+
+	std::vector<Island>			m_Islands;				// only the first m_NumIslands are in use, reused between frames
+	int							m_NumIslands;
+	int							m_LargestIslandSize;
+	std::vector<int>			m_IslandParents;		// union-find forest over m_PhysicsObjects
+	std::vector<int>			m_IslandIds;			// union-find root -> island index
+	std::vector<char>			m_IslandAwake;			// union-find root -> non-zero if any object in it is awake
+	std::vector<float>			m_IslandSleepTimers;	// union-find root -> shortest sleep timer of any object in it
+
+	std::vector<ColourBatch>	m_ColourBatches;		// MAX_SOLVER_COLOURS + 1 overflow batch, only the first m_NumColours are in use
+	int							m_NumColours;
+	std::vector<uint64_t>		m_BodyColours;			// body index -> bit mask of the colours already acting on it
+
+	std::vector<Manifold*>		m_JacobiManifolds;		// all manifolds/constraints in awake islands
+	ConstraintLists				m_JacobiConstraints;
+	std::vector<Constraint*>	m_JacobiUnboundConstraints;	// custom constraints that don't say which objects they act upon
+	std::vector<int>			m_JacobiBodies;			// body indices of every dynamic object acted upon
+	std::vector<int>			m_JacobiOffsets;		// body index -> first of its entries in m_JacobiEntries (one past the end for the last)
+	std::vector<JacobiEntry>	m_JacobiEntries;
+	float						m_JacobiRelaxation;
+
+	int							m_SolverMinIterations;
+	int							m_SolverMaxIterations;
+	float						m_SolverTolerance;
+	float						m_SolverAverageIterations;
+	int							m_SolverMostIterations;
+	float						m_SolverResidual;		// largest final residual of any island
+	float						m_SolverResiduals[2];	// shared between threads by the colouring/jacobi solvers, alternating each iteration
+
+	PositionCorrectionMode		m_PositionCorrectionMode;
+	int							m_PositionIterations;
+
+	float						m_SleepTime;
+	float						m_SleepLinearVelocity;
+	float						m_SleepAngularVelocity;
+	int							m_NumSleeping;
+
+	BroadphaseMode	m_BroadphaseMode;					// algorithm used by BroadPhaseCollisions
+	SolverMode		m_SolverMode;						// algorithm used by SolveConstraints
+	OcTree			m_OcTree;							// persistent across frames, kept in sync with m_PhysicsObjects
+	SweepAndPrune	m_SweepAndPrune;					// persistent across frames, kept in sync with m_PhysicsObjects
+	DynamicAABBTree	m_AABBTree;							// persistent across frames, kept in sync with m_PhysicsObjects
+	SpatialHashGrid	m_SpatialHash;						// rebuilt every frame into reused storage
 
-	std::vector<Constraint*>	m_vpConstraints;		// Misc constraints applying to one or more physics objects
-	std::vector<Manifold*>		m_vpManifolds;			// Contact constraints between pairs of objects
-
-	OcTree* root;
-
-	bool		m_isUseOcTree;							// use ocTree or not
 	bool		m_isDrawOcTree;							// draw ocTree or not
 
 	bool		m_isZeroTrans;
@@ -2,31 +2,31 @@
 #include "PhysicsEngine.h"
 
 PhysicsObject::PhysicsObject()
-	: m_wsTransformInvalidated(true)
-	, m_Enabled(false)
-	, m_Position(0.0f, 0.0f, 0.0f)
-	, m_LinearVelocity(0.0f, 0.0f, 0.0f)
-	, m_Force(0.0f, 0.0f, 0.0f)
-	, m_InvMass(0.0f)
-	, m_Orientation(0.0f, 0.0f, 0.0f, 1.0f)
-	, m_AngularVelocity(0.0f, 0.0f, 0.0f)
-	, m_Torque(0.0f, 0.0f, 0.0f)
-	, m_InvInertia(Matrix3::ZeroMatrix)
+	: m_Enabled(false)
+	, m_pBodyStore(NULL)
+	, m_BodyIndex(-1)
 	, m_pColShape(NULL)
 	, m_Friction(0.5f)
 	, m_Elasticity(0.9f)
 	, m_OnCollisionCallback(nullptr)
 	, m_isColl(false)
 	, m_isInAtmosphere (false)
+	, m_HullShapeVersion (0)
 	, m_isBullet (false)
 	, m_isTarget (false)
 	, m_isHitTarget (false)
-	, m_isSleep (false)
+	, m_SleepTimer (0.0f)
+	, m_ShapeVersion (0)
+	, m_IslandIndex (-1)
 {
+	//Lives in the detached store until it is added to the PhysicsEngine
+	PhysicsBodyStore::Detached()->AddBody(this);
 }
 
 PhysicsObject::~PhysicsObject()
 {
+	m_pBodyStore->RemoveBody(m_BodyIndex);
+
 	//Delete Collision Shape
 	if (m_pColShape != NULL)
 	{
@@ -37,13 +37,51 @@ PhysicsObject::~PhysicsObject()
 
 const Matrix4& PhysicsObject::GetWorldSpaceTransform() const 
 {
-	if (m_wsTransformInvalidated)
+	if (m_pBodyStore->m_TransformDirty[m_BodyIndex] & BODY_DIRTY_TRANSFORM)
 	{
-		m_wsTransform = m_Orientation.ToMatrix4();
-		m_wsTransform.SetPositionVector(m_Position);
+		m_wsTransform = Matrix4(GetRotation());
+		m_wsTransform.SetPositionVector(GetPosition());
 
-		m_wsTransformInvalidated = false;
+		m_pBodyStore->m_TransformDirty[m_BodyIndex] &= ~BODY_DIRTY_TRANSFORM;
 	}
 
 	return m_wsTransform;
+}
+
+const WorldSpaceHull& PhysicsObject::GetWorldSpaceHull() const
+{
+	//Rebuilt if the object has moved, or its shape has been resized since
+	if ((m_pBodyStore->m_TransformDirty[m_BodyIndex] & BODY_DIRTY_HULL)
+		|| (m_pColShape != NULL && m_pColShape->GetVersion() != m_HullShapeVersion))
+	{
+		if (m_pColShape != NULL)
+		{
+			m_pColShape->BuildWorldSpaceHull(this, &m_wsHull);
+			m_HullShapeVersion = m_pColShape->GetVersion();
+		}
+
+		m_pBodyStore->m_TransformDirty[m_BodyIndex] &= ~BODY_DIRTY_HULL;
+	}
+
+	return m_wsHull;
+}
+
+void PhysicsObject::PutToSleep()
+{
+	m_pBodyStore->m_Sleeping[m_BodyIndex] = 1;
+	m_pBodyStore->m_LinearVelocity[m_BodyIndex] = Vector3(0.0f, 0.0f, 0.0f);
+	m_pBodyStore->m_AngularVelocity[m_BodyIndex] = Vector3(0.0f, 0.0f, 0.0f);
+}
+
+void PhysicsObject::GetWorldSpaceAABB(BoundingBox* out_aabb) const
+{
+	if (m_pColShape != NULL)
+	{
+		m_pColShape->GetWorldSpaceAABB(this, out_aabb);
+	}
+	else
+	{
+		out_aabb->_min = GetPosition();
+		out_aabb->_max = GetPosition();
+	}
 }
\ No newline at end of file
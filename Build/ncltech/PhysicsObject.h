@@ -22,6 +22,7 @@ as velocity, position, mass etc..
 #include <nclgl\Quaternion.h>
 #include <nclgl\Matrix3.h>
 #include "CollisionShape.h"
+#include "PhysicsBodyStore.h"
 #include <functional>
 
 class PhysicsEngine;
@@ -42,6 +43,7 @@ typedef std::function<bool(PhysicsObject* this_obj, PhysicsObject* colliding_obj
 class PhysicsObject
 {
 	friend class PhysicsEngine;
+	friend class PhysicsBodyStore;
 
 public:
 	PhysicsObject();
@@ -52,25 +54,39 @@ public:
 	//<--------- GETTERS ------------->
 	inline bool					IsEnabled()					const 	{ return m_Enabled; }
 	inline bool					IsColl()					const   {return m_isColl;}
+	inline bool					IsSleeping()				const	{ return m_pBodyStore->m_Sleeping[m_BodyIndex] != 0; }
+	inline int					GetIslandIndex()			const	{ return m_IslandIndex; }	//Island this object was solved in last step, or -1 if static/not touching anything
 
 	inline float				GetElasticity()				const 	{ return m_Elasticity; }
 	inline float				GetFriction()				const 	{ return m_Friction; }
 
-	inline const Vector3&		GetPosition()				const 	{ return m_Position; }
-	inline const Vector3&		GetLinearVelocity()			const 	{ return m_LinearVelocity; }
-	inline const Vector3&		GetForce()					const 	{ return m_Force; }
-	inline float				GetInverseMass()			const 	{ return m_InvMass; }
+	//Returned by value - the body store's arrays move whenever objects are added/removed
+	inline Vector3				GetPosition()				const 	{ return m_pBodyStore->m_Position[m_BodyIndex]; }
+	inline Vector3				GetLinearVelocity()			const 	{ return m_pBodyStore->m_LinearVelocity[m_BodyIndex]; }
+	inline Vector3				GetForce()					const 	{ return m_pBodyStore->m_Force[m_BodyIndex]; }
+	inline float				GetInverseMass()			const 	{ return m_pBodyStore->m_InvMass[m_BodyIndex]; }
 
-	inline const Quaternion&	GetOrientation()			const 	{ return m_Orientation; }
-	inline const Vector3&		GetAngularVelocity()		const 	{ return m_AngularVelocity; }
-	inline const Vector3&		GetTorque()					const 	{ return m_Torque; }
-	inline const Matrix3&		GetInverseInertia()			const 	{ return m_InvInertia; }
+	inline Quaternion			GetOrientation()			const 	{ return m_pBodyStore->m_Orientation[m_BodyIndex]; }
+	inline Vector3				GetAngularVelocity()		const 	{ return m_pBodyStore->m_AngularVelocity[m_BodyIndex]; }
+	inline Vector3				GetTorque()					const 	{ return m_pBodyStore->m_Torque[m_BodyIndex]; }
+	inline Matrix3				GetInverseInertia()			const 	{ return m_pBodyStore->m_InvInertia[m_BodyIndex]; }		//Local space
+
+	//Derived from the orientation once per step (or whenever it is set), so these are cheap to call
+	inline Matrix3				GetRotation()				const	{ return m_pBodyStore->m_Rotation[m_BodyIndex]; }
+	inline Matrix3				GetWorldInverseInertia()	const	{ return m_pBodyStore->m_InvInertiaWorld[m_BodyIndex]; }
+
+	//Displacement/rotation built up so far by the position correction pass, see PhysicsEngine::SolvePositions
+	inline Vector3				GetLinearCorrection()		const	{ return m_pBodyStore->m_LinearCorrection[m_BodyIndex]; }
+	inline Vector3				GetAngularCorrection()		const	{ return m_pBodyStore->m_AngularCorrection[m_BodyIndex]; }
 
 	inline CollisionShape*		GetCollisionShape()			const 	{ return m_pColShape; }
 
 	inline Object*				GetAssociatedObject()		const	{ return m_pParent; }
 
 	const Matrix4&				GetWorldSpaceTransform()    const;	//Built from scratch or returned from cached value
+	const WorldSpaceHull&		GetWorldSpaceHull()			const;	//Collision shape's hull in world space, rebuilt only when the object has moved or its shape has been resized
+
+	void						GetWorldSpaceAABB(BoundingBox* out_aabb) const;	//Collision shape bounds, or just the position if there is no shape
 
 
 
@@ -78,17 +94,20 @@ public:
 	inline void SetElasticity(float elasticity)						{ m_Elasticity = elasticity; }
 	inline void SetFriction(float friction)							{ m_Friction = friction; }
 
-	inline void SetPosition(const Vector3& v)						{ m_Position = v;	m_wsTransformInvalidated = true; }
-	inline void SetLinearVelocity(const Vector3& v)					{ m_LinearVelocity = v; }
-	inline void SetForce(const Vector3& v)							{ m_Force = v; }
-	inline void SetInverseMass(const float& v)						{ m_InvMass = v; }
+	inline void SetPosition(const Vector3& v)						{ WakeUp(); m_pBodyStore->m_Position[m_BodyIndex] = v;	m_pBodyStore->m_TransformDirty[m_BodyIndex] = BODY_DIRTY_ALL; }
+	inline void SetLinearVelocity(const Vector3& v)					{ WakeUp(); m_pBodyStore->m_LinearVelocity[m_BodyIndex] = v; }
+	inline void SetForce(const Vector3& v)							{ WakeUp(); m_pBodyStore->m_Force[m_BodyIndex] = v; }
+	inline void SetInverseMass(const float& v)						{ m_pBodyStore->m_InvMass[m_BodyIndex] = v; }
 
-	inline void SetOrientation(const Quaternion& v)					{ m_Orientation = v; m_wsTransformInvalidated = true; }
-	inline void SetAngularVelocity(const Vector3& v)				{ m_AngularVelocity = v; }
-	inline void SetTorque(const Vector3& v)							{ m_Torque = v; }
-	inline void SetInverseInertia(const Matrix3& v)					{ m_InvInertia = v; }
+	inline void SetOrientation(const Quaternion& v)					{ WakeUp(); m_pBodyStore->m_Orientation[m_BodyIndex] = v; m_pBodyStore->m_TransformDirty[m_BodyIndex] = BODY_DIRTY_ALL; m_pBodyStore->UpdateDerivedBody(m_BodyIndex); }
+	inline void SetAngularVelocity(const Vector3& v)				{ WakeUp(); m_pBodyStore->m_AngularVelocity[m_BodyIndex] = v; }
+	inline void SetTorque(const Vector3& v)							{ WakeUp(); m_pBodyStore->m_Torque[m_BodyIndex] = v; }
+	inline void SetInverseInertia(const Matrix3& v)					{ m_pBodyStore->m_InvInertia[m_BodyIndex] = v; m_pBodyStore->UpdateDerivedBody(m_BodyIndex); }
 
-	inline void SetCollisionShape(CollisionShape* colShape)			{ m_pColShape = colShape; }
+	//Only for use by the position correction pass - moved once it has finished, and doesn't wake the object
+	inline void AddCorrection(const Vector3& linear, const Vector3& angular)	{ m_pBodyStore->m_LinearCorrection[m_BodyIndex] += linear; m_pBodyStore->m_AngularCorrection[m_BodyIndex] += angular; }
+
+	inline void SetCollisionShape(CollisionShape* colShape)			{ m_pColShape = colShape; m_pBodyStore->m_TransformDirty[m_BodyIndex] |= BODY_DIRTY_HULL; }
 	
 
 
@@ -106,7 +125,13 @@ public:
 	inline void SetIsBullet (bool b)	{ m_isBullet = b; }
 	inline void SetIsTarget (bool b)	{ m_isTarget = b; }
 
-	inline void SetIsSleep	(bool b)	{ m_isSleep = b; }
+	//<---------- SLEEPING ------------>
+	//Objects are put to sleep automatically by the PhysicsEngine once they (and everything
+	// they are touching) have come to rest. Moving/pushing an object through any of the
+	// setters above, or a collision with an awake object, wakes it up again.
+	inline void WakeUp()				{ if (IsSleeping()) { m_pBodyStore->m_Sleeping[m_BodyIndex] = 0; m_SleepTimer = 0.0f; } }
+	void		PutToSleep();
+	inline void SetIsSleep	(bool b)	{ if (b) PutToSleep(); else WakeUp(); }
 
 protected:
 	Object*				m_pParent;			//Optional: Attached GameObject or NULL if none set
@@ -115,23 +140,17 @@ protected:
 
 	bool				m_isInAtmosphere;
 
-	mutable bool		m_wsTransformInvalidated;
-	mutable Matrix4		m_wsTransform;
+	mutable Matrix4		m_wsTransform;		//Only valid if not flagged as dirty in the body store
+	mutable WorldSpaceHull	m_wsHull;		//Same as above
+	mutable unsigned int	m_HullShapeVersion;	//Version of the collision shape m_wsHull was built from
 
 	float				m_Elasticity;		//Value from 0-1 definiing how much the object bounces off other objects
 	float				m_Friction;			//Value from 0-1 defining how much the object can slide off other objects
 
-	//<---------LINEAR-------------->
-	Vector3		m_Position;
-	Vector3		m_LinearVelocity;
-	Vector3		m_Force;
-	float		m_InvMass;
-
-	//<----------ANGULAR-------------->
-	Quaternion  m_Orientation;
-	Vector3		m_AngularVelocity;
-	Vector3		m_Torque;
-	Matrix3     m_InvInertia;
+	//<---------LINEAR/ANGULAR-------------->
+	// Position, velocity, orientation etc are all kept in the body store
+	PhysicsBodyStore*	m_pBodyStore;
+	int					m_BodyIndex;
 
 	//<----------COLLISION------------>
 	CollisionShape*				m_pColShape;
@@ -141,5 +160,9 @@ protected:
 	bool	m_isTarget;
 	bool	m_isHitTarget;
 
-	bool	m_isSleep;
+	float	m_SleepTimer;		//Time (in seconds) the object has been moving slower than the sleep thresholds
+	unsigned int m_ShapeVersion;	//Version of the collision shape last seen by the PhysicsEngine, which wakes the object up if it changes
+
+	//<----------SOLVER-------------->
+	int		m_IslandIndex;		//Set by the PhysicsEngine when building islands each step
 };
\ No newline at end of file
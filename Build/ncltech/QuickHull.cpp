@@ -0,0 +1,505 @@
+#include "QuickHull.h"
+#include <nclgl\common.h>
+#include <algorithm>
+#include <cfloat>
+
+bool QuickHull::Build(const Vector3* points, size_t num_points, Hull* out_hull, float merge_angle, int max_face_vertices)
+{
+	if (num_points < 4)
+		return false;
+
+	QuickHull builder(points, num_points);
+	if (!builder.BuildInitialHull())
+		return false;
+
+	//New faces only ever get added to the end, and a face is always removed when its
+	// furthest point is added to the hull - so one pass sees every point that's outside.
+	for (size_t i = 0; i < builder.m_vFaces.size(); ++i)
+	{
+		if (!builder.m_vFaces[i].removed && builder.m_vFaces[i].outside_head != -1)
+			builder.AddPointToHull((int)i);
+	}
+
+	builder.OutputHull(out_hull, merge_angle, max(max_face_vertices, 3));
+	return true;
+}
+
+QuickHull::QuickHull(const Vector3* points, size_t num_points)
+	: m_pPoints(points)
+	, m_NumPoints(num_points)
+{
+	//Scale the tolerance to the size of the points, as that's what float precision depends on
+	Vector3 max_abs = Vector3(0.0f, 0.0f, 0.0f);
+	Vector3 vMin = Vector3(FLT_MAX, FLT_MAX, FLT_MAX);
+	Vector3 vMax = Vector3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	for (size_t i = 0; i < num_points; ++i)
+	{
+		const Vector3& p = points[i];
+		max_abs = Vector3(max(max_abs.x, fabs(p.x)), max(max_abs.y, fabs(p.y)), max(max_abs.z, fabs(p.z)));
+		vMin = Vector3(min(vMin.x, p.x), min(vMin.y, p.y), min(vMin.z, p.z));
+		vMax = Vector3(max(vMax.x, p.x), max(vMax.y, p.y), max(vMax.z, p.z));
+	}
+	m_Tolerance = 3.0f * FLT_EPSILON * (max_abs.x + max_abs.y + max_abs.z);
+	m_Size = (num_points > 0) ? (vMax - vMin).Length() : 0.0f;
+
+	m_vNextOutside.resize(num_points, -1);
+}
+
+bool QuickHull::BuildInitialHull()
+{
+	const Vector3* p = m_pPoints;
+
+	//Min and max points along each axis
+	int extremes[6] = { 0, 0, 0, 0, 0, 0 };
+	for (size_t i = 1; i < m_NumPoints; ++i)
+	{
+		if (p[i].x < p[extremes[0]].x) extremes[0] = i;
+		if (p[i].x > p[extremes[1]].x) extremes[1] = i;
+		if (p[i].y < p[extremes[2]].y) extremes[2] = i;
+		if (p[i].y > p[extremes[3]].y) extremes[3] = i;
+		if (p[i].z < p[extremes[4]].z) extremes[4] = i;
+		if (p[i].z > p[extremes[5]].z) extremes[5] = i;
+	}
+
+	//The two of them furthest apart..
+	int v0 = 0, v1 = 0;
+	float best = -1.0f;
+	for (int i = 0; i < 6; ++i)
+	{
+		for (int j = i + 1; j < 6; ++j)
+		{
+			float dist_sq = (p[extremes[i]] - p[extremes[j]]).LengthSquared();
+			if (dist_sq > best)
+			{
+				best = dist_sq;
+				v0 = extremes[i];
+				v1 = extremes[j];
+			}
+		}
+	}
+	if (best <= m_Tolerance * m_Tolerance)
+		return false;
+
+	//..the point furthest from the line between them..
+	Vector3 dir = p[v1] - p[v0];
+	dir.Normalise();
+
+	int v2 = -1;
+	best = m_Tolerance * m_Tolerance;
+	for (size_t i = 0; i < m_NumPoints; ++i)
+	{
+		float dist_sq = Vector3::Cross(p[i] - p[v0], dir).LengthSquared();
+		if (dist_sq > best)
+		{
+			best = dist_sq;
+			v2 = i;
+		}
+	}
+	if (v2 == -1)
+		return false;
+
+	//..and the point furthest from the plane through all three
+	Vector3 normal = Vector3::Cross(p[v1] - p[v0], p[v2] - p[v0]);
+	normal.Normalise();
+
+	int v3 = -1;
+	best = m_Tolerance;
+	for (size_t i = 0; i < m_NumPoints; ++i)
+	{
+		float dist = fabs(Vector3::Dot(normal, p[i] - p[v0]));
+		if (dist > best)
+		{
+			best = dist;
+			v3 = i;
+		}
+	}
+	if (v3 == -1)
+		return false;
+
+	//Wind the base so that it faces away from the last point, the other faces then each
+	// take one of its edges backwards up to that point
+	if (Vector3::Dot(normal, p[v3] - p[v0]) > 0.0f)
+		std::swap(v1, v2);
+
+	AddTriangle(v0, v1, v2);
+	AddTriangle(v1, v0, v3);
+	AddTriangle(v2, v1, v3);
+	AddTriangle(v0, v2, v3);
+
+	for (size_t i = 0; i < m_vEdges.size(); ++i)
+	{
+		for (size_t j = 0; j < m_vEdges.size(); ++j)
+		{
+			if (m_vEdges[i].vertex == EdgeEnd(j) && EdgeEnd(i) == m_vEdges[j].vertex)
+				m_vEdges[i].twin = j;
+		}
+	}
+
+	for (int i = 0; i < (int)m_NumPoints; ++i)
+	{
+		if (i != v0 && i != v1 && i != v2 && i != v3)
+			AssignPoint(i, 0);
+	}
+
+	return true;
+}
+
+void QuickHull::AddPointToHull(int face)
+{
+	int eye_point = m_vFaces[face].furthest;
+	ComputeHorizon(eye_point, face);
+
+	//Fill the hole with a fan of triangles from each horizon edge to the new point, each
+	// stitched onto the face on the other side of the horizon..
+	size_t first_new_face = m_vFaces.size();
+	size_t num_new_faces = m_vHorizon.size();
+	for (size_t i = 0; i < num_new_faces; ++i)
+	{
+		int horizon_edge = m_vHorizon[i];
+		int new_face = AddTriangle(m_vEdges[horizon_edge].vertex, EdgeEnd(horizon_edge), eye_point);
+
+		int new_edge = m_vFaces[new_face].edge;
+		int outer_edge = m_vEdges[horizon_edge].twin;
+		m_vEdges[new_edge].twin = outer_edge;
+		m_vEdges[outer_edge].twin = new_edge;
+	}
+
+	//..and to the triangles either side of it, as the horizon edges go round in order
+	for (size_t i = 0; i < num_new_faces; ++i)
+	{
+		int edge_to_eye = m_vFaces[first_new_face + i].edge + 1;
+		int edge_from_eye = m_vFaces[first_new_face + (i + 1) % num_new_faces].edge + 2;
+		m_vEdges[edge_to_eye].twin = edge_from_eye;
+		m_vEdges[edge_from_eye].twin = edge_to_eye;
+	}
+
+	//Any points that were outside the removed faces are either outside one of the new
+	// ones or are now inside the hull
+	for (int visible_face : m_vVisibleFaces)
+	{
+		int point = m_vFaces[visible_face].outside_head;
+		while (point != -1)
+		{
+			int next = m_vNextOutside[point];
+			if (point != eye_point)
+				AssignPoint(point, first_new_face);
+			point = next;
+		}
+	}
+}
+
+void QuickHull::ComputeHorizon(int eye_point, int start_face)
+{
+	m_vVisibleFaces.clear();
+	m_vHorizon.clear();
+	m_vStack.clear();
+
+	m_vFaces[start_face].removed = true;
+	m_vVisibleFaces.push_back(start_face);
+
+	//Depth first walk across all the faces the eye can see. Each face is walked around
+	// from the edge it was entered by, so the horizon edges come out in order around it.
+	HorizonFrame root = { m_vFaces[start_face].edge, m_vFaces[start_face].edge, false };
+	m_vStack.push_back(root);
+
+	while (!m_vStack.empty())
+	{
+		HorizonFrame& frame = m_vStack.back();
+		if (frame.started && frame.edge == frame.end)
+		{
+			m_vStack.pop_back();
+			continue;
+		}
+
+		int edge = frame.edge;
+		frame.edge = m_vEdges[edge].next;
+		frame.started = true;
+
+		int twin = m_vEdges[edge].twin;
+		int neighbour = m_vEdges[twin].face;
+		if (m_vFaces[neighbour].removed)
+			continue;
+
+		if (DistanceToFace(m_vFaces[neighbour], eye_point) > m_Tolerance)
+		{
+			m_vFaces[neighbour].removed = true;
+			m_vVisibleFaces.push_back(neighbour);
+
+			HorizonFrame child = { m_vEdges[twin].next, twin, true };
+			m_vStack.push_back(child);
+		}
+		else
+		{
+			m_vHorizon.push_back(edge);
+		}
+	}
+}
+
+int QuickHull::AddTriangle(int v0, int v1, int v2)
+{
+	int face_idx = m_vFaces.size();
+	int edge_idx = m_vEdges.size();
+
+	int verts[3] = { v0, v1, v2 };
+	for (int i = 0; i < 3; ++i)
+	{
+		HalfEdge edge;
+		edge.vertex = verts[i];
+		edge.next = edge_idx + (i + 1) % 3;
+		edge.twin = -1;
+		edge.face = face_idx;
+		m_vEdges.push_back(edge);
+	}
+
+	const Vector3& a = m_pPoints[v0];
+	const Vector3& b = m_pPoints[v1];
+	const Vector3& c = m_pPoints[v2];
+
+	Face face;
+	face.edge = edge_idx;
+	face.normal = Vector3::Cross(b - a, c - a);
+	face.area = face.normal.Length() * 0.5f;
+	face.normal.Normalise();
+	face.offset = Vector3::Dot(face.normal, (a + b + c) / 3.0f);	//Centroid is the most accurate point to use
+	face.outside_head = -1;
+	face.furthest = -1;
+	face.furthest_dist = 0.0f;
+	face.removed = false;
+	m_vFaces.push_back(face);
+
+	return face_idx;
+}
+
+void QuickHull::AddOutsidePoint(int face_idx, int point, float dist)
+{
+	Face& face = m_vFaces[face_idx];
+	m_vNextOutside[point] = face.outside_head;
+	face.outside_head = point;
+
+	if (face.furthest == -1 || dist > face.furthest_dist)
+	{
+		face.furthest = point;
+		face.furthest_dist = dist;
+	}
+}
+
+void QuickHull::AssignPoint(int point, size_t first_face)
+{
+	int best_face = -1;
+	float best_dist = m_Tolerance;
+	for (size_t i = first_face; i < m_vFaces.size(); ++i)
+	{
+		if (m_vFaces[i].removed)
+			continue;
+
+		float dist = DistanceToFace(m_vFaces[i], point);
+		if (dist > best_dist)
+		{
+			best_dist = dist;
+			best_face = i;
+		}
+	}
+
+	if (best_face != -1)
+		AddOutsidePoint(best_face, point, best_dist);
+}
+
+void QuickHull::OutputHull(Hull* out_hull, float merge_angle, int max_face_vertices)
+{
+	std::vector<int> faces;
+	for (size_t i = 0; i < m_vFaces.size(); ++i)
+	{
+		if (!m_vFaces[i].removed)
+			faces.push_back(i);
+	}
+
+	//Largest faces first, so that each merged polygon grows out from the face that best
+	// describes its plane
+	std::sort(faces.begin(), faces.end(), [&](int a, int b) { return m_vFaces[a].area > m_vFaces[b].area; });
+
+	float cos_merge = cosf(DegToRad(merge_angle));
+	float min_area = m_Tolerance * m_Tolerance;
+	float merge_distance = max(QUICKHULL_MERGE_DISTANCE * m_Size, m_Tolerance);
+	m_vFaceGroups.assign(m_vFaces.size(), -1);
+
+	std::vector<std::vector<int>> polygons;
+	std::vector<Vector3> normals;
+	std::vector<int> members, outline;
+	int num_groups = 0;
+
+	for (int seed : faces)
+	{
+		if (m_vFaceGroups[seed] != -1)
+			continue;
+
+		//Flood out to every neighbour facing the same way as the seed, and lying on its plane.
+		// Slivers with next to no area don't have a reliable normal, but are on the plane of
+		// anything they touch.
+		int group = num_groups++;
+		const Vector3& seed_normal = m_vFaces[seed].normal;
+		float seed_offset = m_vFaces[seed].offset;
+
+		members.clear();
+		members.push_back(seed);
+		m_vFaceGroups[seed] = group;
+		for (size_t m = 0; m < members.size(); ++m)
+		{
+			int edge = m_vFaces[members[m]].edge;
+			for (int k = 0; k < 3; ++k, edge = m_vEdges[edge].next)
+			{
+				int neighbour = m_vEdges[m_vEdges[edge].twin].face;
+				if (m_vFaceGroups[neighbour] != -1)
+					continue;
+
+				const Face& face = m_vFaces[neighbour];
+				bool coplanar = face.area <= min_area;
+				if (!coplanar && Vector3::Dot(face.normal, seed_normal) >= cos_merge)
+				{
+					//Only the vertex across the shared edge can be off the plane of the group
+					int opposite = m_vEdges[m_vEdges[m_vEdges[edge].twin].next].next;
+					float dist = Vector3::Dot(seed_normal, m_pPoints[m_vEdges[opposite].vertex]) - seed_offset;
+					coplanar = fabs(dist) <= merge_distance;
+				}
+
+				if (coplanar)
+				{
+					m_vFaceGroups[neighbour] = group;
+					members.push_back(neighbour);
+				}
+			}
+		}
+
+		if (members.size() > 1 && GetGroupOutline(group, members, seed_normal, &outline))
+		{
+			//Newell's method, to average the normal over the whole polygon
+			Vector3 normal = Vector3(0.0f, 0.0f, 0.0f);
+			for (size_t i = 0, j = outline.size() - 1; i < outline.size(); j = i++)
+			{
+				const Vector3& a = m_pPoints[outline[j]];
+				const Vector3& b = m_pPoints[outline[i]];
+				normal.x += (a.y - b.y) * (a.z + b.z);
+				normal.y += (a.z - b.z) * (a.x + b.x);
+				normal.z += (a.x - b.x) * (a.y + b.y);
+			}
+
+			//Split anything too big into a fan of smaller (still convex) polygons
+			for (size_t start = 1; start + 1 < outline.size(); )
+			{
+				size_t end = min(start + (size_t)max_face_vertices - 2, outline.size() - 1);
+
+				polygons.push_back(std::vector<int>());
+				polygons.back().push_back(outline[0]);
+				polygons.back().insert(polygons.back().end(), outline.begin() + start, outline.begin() + end + 1);
+				normals.push_back(normal);
+
+				start = end;
+			}
+		}
+		else
+		{
+			//Otherwise just leave them all as triangles
+			for (int member : members)
+			{
+				int edge = m_vFaces[member].edge;
+				polygons.push_back(std::vector<int>());
+				for (int k = 0; k < 3; ++k, edge = m_vEdges[edge].next)
+					polygons.back().push_back(m_vEdges[edge].vertex);
+				normals.push_back(m_vFaces[member].normal);
+			}
+		}
+	}
+
+	//Only the points that ended up on the hull are given to it
+	std::vector<int> hull_index(m_NumPoints, -1);
+	int num_vertices = 0;
+	for (std::vector<int>& polygon : polygons)
+	{
+		for (int& vertex : polygon)
+		{
+			if (hull_index[vertex] == -1)
+			{
+				hull_index[vertex] = num_vertices++;
+				out_hull->AddVertex(m_pPoints[vertex]);
+			}
+			vertex = hull_index[vertex];
+		}
+	}
+
+	for (size_t i = 0; i < polygons.size(); ++i)
+	{
+		out_hull->AddFace(normals[i], polygons[i]);
+	}
+
+	out_hull->Finalize();
+}
+
+bool QuickHull::GetGroupOutline(int group, const std::vector<int>& members, const Vector3& group_normal, std::vector<int>* out_vertices) const
+{
+	out_vertices->clear();
+
+	//Any edge between a member and a face outside the group is on the outline
+	int start = -1;
+	size_t num_outline_edges = 0;
+	for (int member : members)
+	{
+		int edge = m_vFaces[member].edge;
+		for (int k = 0; k < 3; ++k, edge = m_vEdges[edge].next)
+		{
+			if (m_vFaceGroups[m_vEdges[m_vEdges[edge].twin].face] != group)
+			{
+				start = edge;
+				++num_outline_edges;
+			}
+		}
+	}
+	if (start == -1)
+		return false;
+
+	//The next outline edge starts where the last one ended - turn around that vertex
+	// (through the group) until we come to it
+	int edge = start;
+	do
+	{
+		out_vertices->push_back(m_vEdges[edge].vertex);
+		if (out_vertices->size() > num_outline_edges)
+			return false;
+
+		edge = m_vEdges[edge].next;
+		while (m_vFaceGroups[m_vEdges[m_vEdges[edge].twin].face] == group)
+		{
+			edge = m_vEdges[m_vEdges[edge].twin].next;
+		}
+	} while (edge != start);
+
+	//If not all of the outline was walked the group has a hole in it, or touches itself
+	// at a vertex if any come up twice
+	const std::vector<int>& outline = *out_vertices;
+	size_t n = outline.size();
+	if (n != num_outline_edges)
+		return false;
+
+	for (size_t i = 0; i < n; ++i)
+	{
+		for (size_t j = i + 1; j < n; ++j)
+		{
+			if (outline[i] == outline[j])
+				return false;
+		}
+	}
+
+	//Every corner has to turn the same way, give or take a little rounding error
+	for (size_t i = 0; i < n; ++i)
+	{
+		const Vector3& a = m_pPoints[outline[i]];
+		const Vector3& b = m_pPoints[outline[(i + 1) % n]];
+		const Vector3& c = m_pPoints[outline[(i + 2) % n]];
+
+		Vector3 ab = b - a;
+		Vector3 bc = c - b;
+		float turn = Vector3::Dot(Vector3::Cross(ab, bc), group_normal);
+		if (turn < -m_Tolerance * (ab.Length() + bc.Length()))
+			return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,111 @@
+/******************************************************************************
+Class: QuickHull
+Description: Builds the convex Hull of a cloud of points, such as the vertices
+of a mesh loaded from an OBJ file, in roughly O(n log n).
+
+Starts from a tetrahedron between four of the extreme points. Every other point
+is put in the 'outside' list of a face it is above, and then the furthest point
+above each face in turn is added to the hull: all the faces it can see are
+removed and the hole is filled with a fan of new triangles around it, with the
+points that were outside the removed faces handed out to the new ones. Points
+that end up inside the hull are never looked at again.
+
+The triangles are kept in a half-edge structure while building, so that each
+edge already knows its twin and nothing has to be searched for. Once all of the
+points are inside, adjacent triangles that are (near enough) coplanar are merged
+into single polygons - a cube comes out with six quads instead of twelve
+triangles - and the result is handed over to the Hull.
+******************************************************************************/
+#pragma once
+
+#include "Hull.h"
+#include "CollisionShape.h"
+
+#define QUICKHULL_DEFAULT_MERGE_ANGLE	1.0f	//Max angle (in degrees) between the normals of triangles merged into one face
+#define QUICKHULL_MERGE_DISTANCE		1e-3f	//..and furthest their vertices can be off the face's plane, relative to the size of the hull
+
+class QuickHull
+{
+public:
+	//Builds the convex hull of the given points into 'out_hull' (which should be empty) and
+	// finalizes it. Neighbouring triangles within 'merge_angle' degrees of each other, and not
+	// noticeably off each other's plane, are merged into single faces - which are split up
+	// again if they have more than 'max_face_vertices'. Returns false (leaving the hull empty)
+	// if the points don't enclose any volume, e.g. if they all lie on a plane.
+	static bool Build(const Vector3* points, size_t num_points, Hull* out_hull,
+		float merge_angle = QUICKHULL_DEFAULT_MERGE_ANGLE,
+		int max_face_vertices = MAX_HULL_FACE_VERTICES);
+
+protected:
+	struct HalfEdge
+	{
+		int		vertex;		//Point the edge starts from
+		int		next;		//Next edge around the face (ccw)
+		int		twin;		//Same edge going the other way, on the neighbouring face
+		int		face;
+	};
+
+	struct Face
+	{
+		int		edge;				//Any one of its (three) edges
+		Vector3	normal;
+		float	offset;				//Dot(normal, point on face)
+		float	area;
+		int		outside_head;		//First of the points above this face (linked through m_vNextOutside)
+		int		furthest;			//..and the one furthest above it
+		float	furthest_dist;
+		bool	removed;
+	};
+
+	//Where ComputeHorizon has got to on each face it is walking around
+	struct HorizonFrame
+	{
+		int		edge;		//Next edge to look across
+		int		end;		//Edge that was crossed to get onto the face, which ends the walk
+		bool	started;
+	};
+
+	QuickHull(const Vector3* points, size_t num_points);
+
+	bool BuildInitialHull();
+
+	//Adds the furthest point above the face to the hull
+	void AddPointToHull(int face);
+
+	//Finds all faces visible from the eye point, and the edges around the outside of them
+	void ComputeHorizon(int eye_point, int start_face);
+
+	int AddTriangle(int v0, int v1, int v2);
+	void AddOutsidePoint(int face, int point, float dist);
+
+	//Puts the point outside the face it is furthest above out of faces [first_face, end), or
+	// discards it if it's inside all of them
+	void AssignPoint(int point, size_t first_face);
+
+	float DistanceToFace(const Face& face, int point) const { return Vector3::Dot(face.normal, m_pPoints[point]) - face.offset; }
+	int EdgeEnd(int edge) const { return m_vEdges[m_vEdges[edge].next].vertex; }
+
+	//Merges coplanar triangles into polygons and copies the result into the Hull
+	void OutputHull(Hull* out_hull, float merge_angle, int max_face_vertices);
+
+	//Walks around the outside of a group of merged triangles, returning false if it isn't
+	// a single convex polygon
+	bool GetGroupOutline(int group, const std::vector<int>& members, const Vector3& group_normal, std::vector<int>* out_vertices) const;
+
+protected:
+	const Vector3*			m_pPoints;
+	size_t					m_NumPoints;
+	float					m_Tolerance;		//Points closer to a face than this are counted as on it
+	float					m_Size;				//Length of the diagonal of the points' bounding box
+
+	std::vector<HalfEdge>	m_vEdges;
+	std::vector<Face>		m_vFaces;
+	std::vector<int>		m_vNextOutside;		//Per point, the next point outside the same face
+
+	//Scratch space for adding points, kept between them to save on allocations
+	std::vector<int>		m_vVisibleFaces;
+	std::vector<int>		m_vHorizon;
+	std::vector<HorizonFrame> m_vStack;
+
+	std::vector<int>		m_vFaceGroups;		//Per face, which merged polygon it is part of
+};
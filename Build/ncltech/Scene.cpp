@@ -50,18 +50,46 @@ void Scene::OnUpdateScene(float dt)
 
 void Scene::BuildWorldMatrices()
 {
-	UpdateWorldMatrices(m_pRootGameObject, Matrix4());
-}
+	// The tree is walked one level at a time, so that the world matrices of all of
+	// the objects on a level can be built together in a couple of batched products:
+	//   world = parent * (physics * local)
+	m_WMNodes.clear();
+	m_WMNodes.push_back(m_pRootGameObject);
+	m_WMParents.assign(1, Matrix4());
 
-void Scene::UpdateWorldMatrices(Object* cNode, const Matrix4& parentWM)
-{
-	if (cNode->HasPhysics())
-		cNode->m_WorldTransform = parentWM * cNode->Physics()->GetWorldSpaceTransform() * cNode->m_LocalTransform;
-	else
-		cNode->m_WorldTransform = parentWM * cNode->m_LocalTransform;
+	while (!m_WMNodes.empty())
+	{
+		const unsigned int count = (unsigned int)m_WMNodes.size();
+		m_WMPhysics.resize(count);
+		m_WMLocals.resize(count);
 
-	for (auto child : cNode->GetChildren()) {
-		UpdateWorldMatrices(child, cNode->m_WorldTransform);
+		for (unsigned int i = 0; i < count; ++i)
+		{
+			Object* node = m_WMNodes[i];
+			m_WMPhysics[i] = node->HasPhysics() ? node->Physics()->GetWorldSpaceTransform() : Matrix4();
+			m_WMLocals[i] = node->m_LocalTransform;
+		}
+
+		Matrix4::Multiply(&m_WMPhysics[0], &m_WMLocals[0], &m_WMLocals[0], count);
+		Matrix4::Multiply(&m_WMParents[0], &m_WMLocals[0], &m_WMLocals[0], count);
+
+		// Store the results, and queue up the next level of the tree
+		m_WMNextNodes.clear();
+		m_WMNextParents.clear();
+		for (unsigned int i = 0; i < count; ++i)
+		{
+			Object* node = m_WMNodes[i];
+			node->m_WorldTransform = m_WMLocals[i];
+
+			for (auto child : node->GetChildren())
+			{
+				m_WMNextNodes.push_back(child);
+				m_WMNextParents.push_back(node->m_WorldTransform);
+			}
+		}
+
+		m_WMNodes.swap(m_WMNextNodes);
+		m_WMParents.swap(m_WMNextParents);
 	}
 }
 
@@ -95,9 +95,6 @@ public:
 
 protected:
 
-	// Recursive function called via 'BuildWorldMatrices'
-	void	UpdateWorldMatrices(Object* node, const Matrix4& parentWM);
-
 	// Recusive function called via 'InsertToRenderList'
 	void	InsertToRenderList(Object* node, RenderList* list, const Frustum& frustum);
 
@@ -107,4 +104,9 @@ protected:
 protected:
 	std::string			m_SceneName;
 	Object*				m_pRootGameObject;
+
+	// Scratch space for 'BuildWorldMatrices', kept between frames to avoid reallocating
+	std::vector<Object*>	m_WMNodes, m_WMNextNodes;
+	std::vector<Matrix4>	m_WMParents, m_WMNextParents;
+	std::vector<Matrix4>	m_WMPhysics, m_WMLocals;
 };
\ No newline at end of file
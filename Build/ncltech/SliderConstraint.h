@@ -0,0 +1,89 @@
+/******************************************************************************
+Class: SliderConstraint
+Description: Lets one object slide along an axis fixed in another, without any
+rotation between them (pistons, drawers, lift platforms etc).
+
+Five rows solved together as one block, see BlockConstraint: two keeping the
+point on B on the line through A's anchor, and three locking the objects'
+orientations together.
+******************************************************************************/
+#pragma once
+
+#include "BlockConstraint.h"
+#include "NCLDebug.h"
+
+//Final, so that the PhysicsEngine's pool of slider joints can call it without going through the vtable
+class SliderConstraint final : public BlockConstraint<5>
+{
+public:
+	SliderConstraint(PhysicsObject* obj1, PhysicsObject* obj2, const Vector3& globalAnchor, const Vector3& globalAxis)
+		: BlockConstraint<5>(obj1, obj2)
+	{
+		Vector3 axis = globalAxis;
+		axis.Normalise();
+
+		Matrix3 invRotA = Matrix3::Transpose(m_pObj1->GetRotation());
+		Matrix3 invRotB = Matrix3::Transpose(m_pObj2->GetRotation());
+		m_LocalOnA = invRotA * (globalAnchor - m_pObj1->GetPosition());
+		m_LocalOnB = invRotB * (globalAnchor - m_pObj2->GetPosition());
+		m_LocalAxisA = invRotA * axis;
+
+		//B's orientation relative to A's, to be kept the same
+		m_RelativeRotation = invRotA * m_pObj2->GetRotation();
+	}
+
+	virtual void DebugDraw() const override
+	{
+		Vector3 globalOnA = m_pObj1->GetRotation() * m_LocalOnA + m_pObj1->GetPosition();
+		Vector3 globalOnB = m_pObj2->GetRotation() * m_LocalOnB + m_pObj2->GetPosition();
+		Vector3 axis = m_pObj1->GetRotation() * m_LocalAxisA;
+
+		NCLDebug::DrawThickLine(m_pObj1->GetPosition(), globalOnA, 0.02f, Vector4(0.0f, 0.0f, 0.0f, 1.0f));
+		NCLDebug::DrawThickLine(globalOnA - axis, globalOnA + axis, 0.02f, Vector4(1.0f, 0.8f, 1.0f, 1.0f));
+		NCLDebug::DrawPointNDT(globalOnB, 0.05f, Vector4(1.0f, 0.8f, 1.0f, 1.0f));
+	}
+
+protected:
+	virtual void BuildRows() override
+	{
+		const Matrix3& rotA = m_pObj1->GetRotation();
+		const Matrix3& rotB = m_pObj2->GetRotation();
+
+		//Line - both rows act at B's anchor, so that A is pushed around the point
+		// currently on the line rather than its own (possibly distant) anchor
+		Vector3 onA = m_pObj1->GetPosition() + rotA * m_LocalOnA;
+		Vector3 onB = m_pObj2->GetPosition() + rotB * m_LocalOnB;
+		Vector3 r1 = onB - m_pObj1->GetPosition();
+		Vector3 r2 = onB - m_pObj2->GetPosition();
+
+		Vector3 a = rotA * m_LocalAxisA;
+		Vector3 t1 = GetPerpendicular(a);
+		Vector3 t2 = Vector3::Cross(a, t1);
+
+		m_Rows[0].Build(m_pObj1, m_pObj2, t1, r1, r2);
+		m_Rows[1].Build(m_pObj1, m_pObj2, t2, r1, r2);
+		m_Error[0] = Vector3::Dot(t1, onA - onB);
+		m_Error[1] = Vector3::Dot(t2, onA - onB);
+
+		//Orientation - for small angles, the rotation from where B actually is to where A says
+		// it should be is (I + [e]x), with e the rotation of A relative to B
+		Matrix3 rot_error = rotA * m_RelativeRotation * Matrix3::Transpose(rotB);
+		Vector3 error = Vector3(
+			rot_error(2, 1) - rot_error(1, 2),
+			rot_error(0, 2) - rot_error(2, 0),
+			rot_error(1, 0) - rot_error(0, 1)) * 0.5f;
+
+		m_Rows[2].BuildAngular(m_pObj1, m_pObj2, Vector3(1.0f, 0.0f, 0.0f));
+		m_Rows[3].BuildAngular(m_pObj1, m_pObj2, Vector3(0.0f, 1.0f, 0.0f));
+		m_Rows[4].BuildAngular(m_pObj1, m_pObj2, Vector3(0.0f, 0.0f, 1.0f));
+		m_Error[2] = error.x;
+		m_Error[3] = error.y;
+		m_Error[4] = error.z;
+	}
+
+protected:
+	Vector3 m_LocalOnA;			//Anchor in each object's local space
+	Vector3 m_LocalOnB;
+	Vector3 m_LocalAxisA;		//Axis B slides along, in A's local space
+	Matrix3 m_RelativeRotation;	//A's rotation matrix to B's, when the joint was made
+};
@@ -0,0 +1,249 @@
+#include "SpatialHashGrid.h"
+#include "PhysicsObject.h"
+#include "PhysicsEngine.h"
+#include "AABB.h"
+
+SpatialHashGrid::SpatialHashGrid()
+	: m_Stamp(0)
+{
+	SetCellSize(SPATIALHASH_DEFAULT_CELL_SIZE);
+}
+
+SpatialHashGrid::~SpatialHashGrid()
+{
+	Clear();
+}
+
+void SpatialHashGrid::AddObject(PhysicsObject* obj)
+{
+	if (m_ObjectLookup.find(obj) != m_ObjectLookup.end())
+		return;
+
+	m_ObjectLookup[obj] = m_Objects.size();
+	m_Objects.push_back(obj);
+}
+
+void SpatialHashGrid::RemoveObject(PhysicsObject* obj)
+{
+	auto found_loc = m_ObjectLookup.find(obj);
+	if (found_loc == m_ObjectLookup.end())
+		return;
+
+	size_t idx = found_loc->second;
+	m_ObjectLookup.erase(found_loc);
+
+	//Swap with the last object and pop
+	if (idx != m_Objects.size() - 1)
+	{
+		m_Objects[idx] = m_Objects.back();
+		m_ObjectLookup[m_Objects[idx]] = idx;
+	}
+	m_Objects.pop_back();
+}
+
+void SpatialHashGrid::Clear()
+{
+	m_Objects.clear();
+	m_ObjectLookup.clear();
+
+	m_Bounds.clear();
+	m_InGrid.clear();
+	m_CellEntries.clear();
+	m_OccupiedSlots.clear();
+	m_Oversized.clear();
+}
+
+void SpatialHashGrid::GenerateCPs(std::vector<CollisionPair>& cpList)
+{
+	const int num_objects = (int)m_Objects.size();
+
+	m_Bounds.resize(num_objects);
+	m_InGrid.resize(num_objects);
+	m_CellEntries.clear();
+	m_OccupiedSlots.clear();
+	m_Oversized.clear();
+
+	//Compute the bounds of every object and how many cells it will touch
+	size_t num_entries = 0;
+	for (int i = 0; i < num_objects; ++i)
+	{
+		m_InGrid[i] = 0;
+
+		//Objects without collision shapes can never generate pairs
+		PhysicsObject* obj = m_Objects[i];
+		if (obj->GetCollisionShape() == NULL)
+			continue;
+
+		obj->GetWorldSpaceAABB(&m_Bounds[i]);
+		const BoundingBox& bb = m_Bounds[i];
+
+		int64_t num_cells = int64_t(CellCoord(bb._max.x) - CellCoord(bb._min.x) + 1)
+			* int64_t(CellCoord(bb._max.y) - CellCoord(bb._min.y) + 1)
+			* int64_t(CellCoord(bb._max.z) - CellCoord(bb._min.z) + 1);
+
+		if (num_cells > SPATIALHASH_MAX_CELLS_PER_OBJECT)
+		{
+			m_Oversized.push_back(i);
+		}
+		else
+		{
+			m_InGrid[i] = 1;
+			num_entries += (size_t)num_cells;
+		}
+	}
+
+	PrepareTable(num_entries);
+
+	//Bin all objects into the cells they touch
+	for (int i = 0; i < num_objects; ++i)
+	{
+		if (!m_InGrid[i])
+			continue;
+
+		const BoundingBox& bb = m_Bounds[i];
+		int x0 = CellCoord(bb._min.x), x1 = CellCoord(bb._max.x);
+		int y0 = CellCoord(bb._min.y), y1 = CellCoord(bb._max.y);
+		int z0 = CellCoord(bb._min.z), z1 = CellCoord(bb._max.z);
+
+		for (int x = x0; x <= x1; ++x)
+		{
+			for (int y = y0; y <= y1; ++y)
+			{
+				for (int z = z0; z <= z1; ++z)
+				{
+					InsertEntry(x, y, z, i);
+				}
+			}
+		}
+	}
+
+	//Test all objects sharing a cell. A pair that shares more than one cell is only
+	// reported from the cell holding the min corner of their overlap, so that every
+	// pair is output exactly once without needing to remember which were found.
+	for (int slot_idx : m_OccupiedSlots)
+	{
+		const HashSlot& slot = m_Slots[slot_idx];
+		for (int e1 = slot.head; e1 != -1; e1 = m_CellEntries[e1].next)
+		{
+			int a = m_CellEntries[e1].object;
+			const BoundingBox& ba = m_Bounds[a];
+
+			for (int e2 = m_CellEntries[e1].next; e2 != -1; e2 = m_CellEntries[e2].next)
+			{
+				int b = m_CellEntries[e2].object;
+				const BoundingBox& bb = m_Bounds[b];
+
+				if (!ba.Intersects(bb))
+					continue;
+
+				if (CellCoord(max(ba._min.x, bb._min.x)) != slot.x
+					|| CellCoord(max(ba._min.y, bb._min.y)) != slot.y
+					|| CellCoord(max(ba._min.z, bb._min.z)) != slot.z)
+					continue;
+
+				EmitPair(a, b, cpList);
+			}
+		}
+	}
+
+	//Oversized objects are tested against everything else (and each other once)
+	for (size_t i = 0; i < m_Oversized.size(); ++i)
+	{
+		int a = m_Oversized[i];
+		const BoundingBox& ba = m_Bounds[a];
+
+		for (int b = 0; b < num_objects; ++b)
+		{
+			if (m_InGrid[b] && ba.Intersects(m_Bounds[b]))
+				EmitPair(a, b, cpList);
+		}
+
+		for (size_t j = i + 1; j < m_Oversized.size(); ++j)
+		{
+			int b = m_Oversized[j];
+			if (ba.Intersects(m_Bounds[b]))
+				EmitPair(a, b, cpList);
+		}
+	}
+}
+
+void SpatialHashGrid::PrepareTable(size_t num_entries)
+{
+	//Keep the table at most half full to keep the probe sequences short
+	size_t capacity = 64;
+	while (capacity < num_entries * 2)
+		capacity <<= 1;
+
+	if (m_Slots.size() < capacity)
+	{
+		HashSlot empty;
+		empty.x = empty.y = empty.z = 0;
+		empty.head = -1;
+		empty.stamp = 0;
+
+		m_Slots.assign(capacity, empty);
+		m_Stamp = 0;
+	}
+
+	//Rather than clearing the table each step, slots from older steps are
+	// ignored by bumping the stamp. Only needs a real clear when it wraps around.
+	m_Stamp++;
+	if (m_Stamp == 0)
+	{
+		for (HashSlot& slot : m_Slots)
+			slot.stamp = 0;
+		m_Stamp = 1;
+	}
+}
+
+void SpatialHashGrid::InsertEntry(int x, int y, int z, int object)
+{
+	const uint32_t mask = (uint32_t)m_Slots.size() - 1;
+
+	//Linear probe until we find the cell, or an unused slot to claim for it
+	uint32_t idx = HashCell(x, y, z) & mask;
+	for (;;)
+	{
+		HashSlot& slot = m_Slots[idx];
+		if (slot.stamp != m_Stamp)
+		{
+			slot.x = x;
+			slot.y = y;
+			slot.z = z;
+			slot.head = -1;
+			slot.stamp = m_Stamp;
+			m_OccupiedSlots.push_back((int)idx);
+			break;
+		}
+
+		if (slot.x == x && slot.y == y && slot.z == z)
+			break;
+
+		idx = (idx + 1) & mask;
+	}
+
+	CellEntry entry;
+	entry.object = object;
+	entry.next = m_Slots[idx].head;
+
+	m_Slots[idx].head = (int)m_CellEntries.size();
+	m_CellEntries.push_back(entry);
+}
+
+void SpatialHashGrid::EmitPair(int a, int b, std::vector<CollisionPair>& cpList) const
+{
+	CollisionPair cp;
+	cp.pObjectA = m_Objects[a];
+	cp.pObjectB = m_Objects[b];
+	cpList.push_back(cp);
+}
+
+void SpatialHashGrid::DebugDraw() const
+{
+	for (int slot_idx : m_OccupiedSlots)
+	{
+		const HashSlot& slot = m_Slots[slot_idx];
+		AABB cell(Vector3(slot.x * m_CellSize, slot.y * m_CellSize, slot.z * m_CellSize), m_CellSize);
+		cell.Draw();
+	}
+}
@@ -0,0 +1,92 @@
+/******************************************************************************
+Class: SpatialHashGrid
+Description: Uniform grid broadphase for scenes full of similar sized objects
+(such as the bullet spam in the coursework scene). Every step each object is
+binned into the grid cells its world space AABB touches, and only objects that
+share a cell are tested against one another.
+
+The grid is unbounded - cells are looked up in a flat open addressing hash table
+keyed on their integer cell coordinate. The table, cell entries and bounds are all
+kept between steps and only grow, so a step does not allocate any memory once the
+scene has warmed up. Objects that would cover too many cells (e.g. the ground) are
+kept out of the grid and tested against everything instead.
+******************************************************************************/
+#pragma once
+
+#include "BoundingBox.h"
+#include <vector>
+#include <unordered_map>
+#include <stdint.h>
+
+class PhysicsObject;
+struct CollisionPair;
+
+#define SPATIALHASH_DEFAULT_CELL_SIZE		1.0f	//Edge length of a grid cell (in meters)
+#define SPATIALHASH_MAX_CELLS_PER_OBJECT	64		//Objects covering more cells than this are tested against everything
+
+class SpatialHashGrid
+{
+public:
+	SpatialHashGrid();
+	~SpatialHashGrid();
+
+	//Add/Remove objects from the broadphase - called by the PhysicsEngine
+	void AddObject(PhysicsObject* obj);
+	void RemoveObject(PhysicsObject* obj);
+	void Clear();
+
+	//Re-bins all objects into the grid and appends every overlapping pair
+	// (that both have collision shapes) to the given list exactly once.
+	void GenerateCPs(std::vector<CollisionPair>& cpList);
+
+	//Draws all cells occupied during the last step
+	void DebugDraw() const;
+
+	void  SetCellSize(float size)		{ m_CellSize = size; m_InvCellSize = 1.0f / size; }
+	float GetCellSize() const			{ return m_CellSize; }
+
+	size_t GetNumOccupiedCells() const	{ return m_OccupiedSlots.size(); }
+	size_t GetNumOversized() const		{ return m_Oversized.size(); }
+
+protected:
+	struct HashSlot
+	{
+		int			x, y, z;	//Cell coordinate
+		int			head;		//First entry in m_CellEntries
+		uint32_t	stamp;		//Slot is only in use if this matches m_Stamp
+	};
+
+	struct CellEntry
+	{
+		int object;				//Index into m_Objects
+		int next;				//Next entry in the same cell, or -1
+	};
+
+	static inline uint32_t HashCell(int x, int y, int z)
+	{
+		return (uint32_t(x) * 73856093u) ^ (uint32_t(y) * 19349663u) ^ (uint32_t(z) * 83492791u);
+	}
+
+	inline int CellCoord(float v) const	{ return (int)floorf(v * m_InvCellSize); }
+
+	void PrepareTable(size_t num_entries);
+	void InsertEntry(int x, int y, int z, int object);
+
+	void EmitPair(int a, int b, std::vector<CollisionPair>& cpList) const;
+
+protected:
+	float	m_CellSize;
+	float	m_InvCellSize;
+
+	std::vector<PhysicsObject*>					m_Objects;
+	std::unordered_map<PhysicsObject*, size_t>	m_ObjectLookup;		//PhysicsObject -> index into m_Objects
+
+	//Per step data - reused every step
+	std::vector<BoundingBox>	m_Bounds;			//World space AABB of each object
+	std::vector<char>			m_InGrid;			//Non-zero if the object was binned into the grid
+	std::vector<HashSlot>		m_Slots;			//Open addressing table, size is always a power of two
+	std::vector<CellEntry>		m_CellEntries;
+	std::vector<int>			m_OccupiedSlots;
+	std::vector<int>			m_Oversized;
+	uint32_t					m_Stamp;
+};
@@ -4,11 +4,13 @@
 #include <nclgl/Matrix3.h>
 
 SphereCollisionShape::SphereCollisionShape()
+	: CollisionShape(COLLISION_SHAPE_SPHERE)
 {
 	m_Radius = 1.0f;
 }
 
 SphereCollisionShape::SphereCollisionShape(float radius)
+	: CollisionShape(COLLISION_SHAPE_SPHERE)
 {
 	m_Radius = radius;
 }
@@ -32,6 +34,13 @@ Matrix3 SphereCollisionShape::BuildInverseInertia(float invMass) const
 	return inertia;
 }
 
+void SphereCollisionShape::GetWorldSpaceAABB(const PhysicsObject* currentObject, BoundingBox* out_aabb) const
+{
+	Vector3 radius = Vector3(m_Radius, m_Radius, m_Radius);
+	out_aabb->_min = currentObject->GetPosition() - radius;
+	out_aabb->_max = currentObject->GetPosition() + radius;
+}
+
 void SphereCollisionShape::GetCollisionAxes(const PhysicsObject* currentObject, std::vector<Vector3>* out_axes) const
 {
 	/* There is infinite possible axes on a sphere so we MUST handle it seperately */
@@ -51,10 +60,16 @@ void SphereCollisionShape::GetMinMaxVertexOnAxis(const PhysicsObject* currentObj
 		*out_max = currentObject->GetPosition() + axis * m_Radius;
 }
 
-void SphereCollisionShape::GetIncidentReferencePolygon(const PhysicsObject* currentObject, const Vector3& axis, std::list<Vector3>* out_face, Vector3* out_normal, std::vector<Plane>* out_adjacent_planes) const
+Vector3 SphereCollisionShape::GetSupportPoint(const PhysicsObject* currentObject, const Vector3& axis) const
+{
+	//The radius is left to the margin
+	return currentObject->GetPosition();
+}
+
+void SphereCollisionShape::GetIncidentReferencePolygon(const PhysicsObject* currentObject, const Vector3& axis, ContactPolygon* out_face, Vector3* out_normal, ContactClipPlanes* out_adjacent_planes) const
 {
 	if (out_face)
-		out_face->push_back(currentObject->GetPosition() + axis * m_Radius);
+		out_face->Add(currentObject->GetPosition() + axis * m_Radius);
 	
 
 	if (out_normal)
@@ -32,7 +32,7 @@ public:
 
 
 	// Get/Set Sphere Radius
-	void	SetRadius(float radius) { m_Radius = radius; }
+	void	SetRadius(float radius) { m_Radius = radius; MarkChanged(); }
 	float	GetRadius() const { return m_Radius; }
 
 	// Debug Collision Shape
@@ -41,6 +41,16 @@ public:
 	// Build Inertia Matrix for rotational mass
 	virtual Matrix3 BuildInverseInertia(float invMass) const override;
 
+	// World-space bounding box used by the broadphase
+	virtual void GetWorldSpaceAABB(const PhysicsObject* currentObject, BoundingBox* out_aabb) const override;
+
+
+	// Support function used by CollisionDetectionGJK
+	virtual Vector3 GetSupportPoint(
+		const PhysicsObject* currentObject,
+		const Vector3& axis) const override;
+
+	virtual float GetSupportMargin() const override { return m_Radius; }
 
 	// Generic Collision Detection Routines
 	//  - Used in CollisionDetectionSAT to identify if two shapes overlap
@@ -61,9 +71,9 @@ public:
 	virtual void GetIncidentReferencePolygon(
 		const PhysicsObject* currentObject,
 		const Vector3& axis,
-		std::list<Vector3>* out_face,
+		ContactPolygon* out_face,
 		Vector3* out_normal,
-		std::vector<Plane>* out_adjacent_planes) const override;
+		ContactClipPlanes* out_adjacent_planes) const override;
 
 protected:
 	float	m_Radius;
@@ -0,0 +1,224 @@
+#include "SweepAndPrune.h"
+#include "PhysicsObject.h"
+#include "PhysicsEngine.h"
+#include <algorithm>
+
+SweepAndPrune::SweepAndPrune()
+{
+}
+
+SweepAndPrune::~SweepAndPrune()
+{
+	Clear();
+}
+
+void SweepAndPrune::AddObject(PhysicsObject* obj)
+{
+	if (m_ProxyLookup.find(obj) != m_ProxyLookup.end())
+		return;
+
+	uint32_t idx;
+	if (m_FreeProxies.size() > 0)
+	{
+		idx = m_FreeProxies.back();
+		m_FreeProxies.pop_back();
+	}
+	else
+	{
+		idx = (uint32_t)m_Proxies.size();
+		m_Proxies.push_back(SAPProxy());
+	}
+
+	SAPProxy& proxy = m_Proxies[idx];
+	proxy.obj = obj;
+
+	// New endpoints are appended to the end of the lists (min before max), so
+	// until the next sort they are seen as seperated from every other proxy.
+	// The next GenerateCPs call will sort them into place and find their pairs.
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		proxy.min[axis] = 0.0f;
+		proxy.max[axis] = 0.0f;
+
+		SAPEndPoint ep;
+		ep.value = FLT_MAX;
+		ep.data = (idx << 1);
+		m_EndPoints[axis].push_back(ep);
+
+		ep.data = (idx << 1) | 1;
+		m_EndPoints[axis].push_back(ep);
+	}
+
+	m_ProxyLookup[obj] = idx;
+}
+
+void SweepAndPrune::RemoveObject(PhysicsObject* obj)
+{
+	auto found_loc = m_ProxyLookup.find(obj);
+	if (found_loc == m_ProxyLookup.end())
+		return;
+
+	uint32_t idx = found_loc->second;
+	m_ProxyLookup.erase(found_loc);
+
+	//Remove the endpoints (keeping the remaining lists sorted)
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		std::vector<SAPEndPoint>& eps = m_EndPoints[axis];
+		eps.erase(std::remove_if(eps.begin(), eps.end(),
+			[idx](const SAPEndPoint& ep) { return ep.Proxy() == idx; }), eps.end());
+	}
+
+	//Remove all pairs referencing the proxy
+	for (size_t i = 0; i < m_Pairs.size(); )
+	{
+		if (m_Pairs[i].proxyA == idx || m_Pairs[i].proxyB == idx)
+			RemovePair(m_Pairs[i].proxyA, m_Pairs[i].proxyB);
+		else
+			++i;
+	}
+
+	m_Proxies[idx].obj = NULL;
+	m_FreeProxies.push_back(idx);
+}
+
+void SweepAndPrune::Clear()
+{
+	m_Proxies.clear();
+	m_FreeProxies.clear();
+	m_ProxyLookup.clear();
+	m_Pairs.clear();
+	m_PairLookup.clear();
+
+	for (int axis = 0; axis < 3; ++axis)
+		m_EndPoints[axis].clear();
+}
+
+void SweepAndPrune::GenerateCPs(std::vector<CollisionPair>& cpList)
+{
+	UpdateBounds();
+
+	SortAxis(0);
+	SortAxis(1);
+	SortAxis(2);
+
+	for (const SAPPair& pair : m_Pairs)
+	{
+		PhysicsObject* objA = m_Proxies[pair.proxyA].obj;
+		PhysicsObject* objB = m_Proxies[pair.proxyB].obj;
+
+		//Check they both atleast have collision shapes
+		if (objA->GetCollisionShape() != NULL
+			&& objB->GetCollisionShape() != NULL)
+		{
+			CollisionPair cp;
+			cp.pObjectA = objA;
+			cp.pObjectB = objB;
+			cpList.push_back(cp);
+		}
+	}
+}
+
+void SweepAndPrune::UpdateBounds()
+{
+	BoundingBox bb;
+	for (SAPProxy& proxy : m_Proxies)
+	{
+		//Sleeping objects have not moved since their bounds were last updated
+		if (proxy.obj == NULL || proxy.obj->IsSleeping())
+			continue;
+
+		proxy.obj->GetWorldSpaceAABB(&bb);
+
+		proxy.min[0] = bb._min.x; proxy.max[0] = bb._max.x;
+		proxy.min[1] = bb._min.y; proxy.max[1] = bb._max.y;
+		proxy.min[2] = bb._min.z; proxy.max[2] = bb._max.z;
+	}
+
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		for (SAPEndPoint& ep : m_EndPoints[axis])
+		{
+			const SAPProxy& proxy = m_Proxies[ep.Proxy()];
+			ep.value = ep.IsMax() ? proxy.max[axis] : proxy.min[axis];
+		}
+	}
+}
+
+void SweepAndPrune::SortAxis(int axis)
+{
+	// Insertion sort - as objects rarely move far between physics steps, each
+	// endpoint only needs to shift a few places. Every swap between a min and
+	// a max endpoint corresponds to a pair starting or stopping overlap on this
+	// axis, which is all we need to keep the pair list up to date.
+	std::vector<SAPEndPoint>& eps = m_EndPoints[axis];
+	for (size_t i = 1; i < eps.size(); ++i)
+	{
+		SAPEndPoint key = eps[i];
+
+		size_t j = i;
+		while (j > 0 && EndPointLess(key, eps[j - 1]))
+		{
+			const SAPEndPoint& prev = eps[j - 1];
+
+			if (!key.IsMax() && prev.IsMax())
+			{
+				//Min endpoint passed a max endpoint - possibly started overlapping
+				if (TestOverlap(key.Proxy(), prev.Proxy()))
+					AddPair(key.Proxy(), prev.Proxy());
+			}
+			else if (key.IsMax() && !prev.IsMax())
+			{
+				//Max endpoint passed a min endpoint - no longer overlapping
+				RemovePair(key.Proxy(), prev.Proxy());
+			}
+
+			eps[j] = prev;
+			--j;
+		}
+
+		eps[j] = key;
+	}
+}
+
+bool SweepAndPrune::TestOverlap(uint32_t a, uint32_t b) const
+{
+	const SAPProxy& pa = m_Proxies[a];
+	const SAPProxy& pb = m_Proxies[b];
+
+	return pa.min[0] <= pb.max[0] && pb.min[0] <= pa.max[0]
+		&& pa.min[1] <= pb.max[1] && pb.min[1] <= pa.max[1]
+		&& pa.min[2] <= pb.max[2] && pb.min[2] <= pa.max[2];
+}
+
+void SweepAndPrune::AddPair(uint32_t a, uint32_t b)
+{
+	uint64_t key = PairKey(a, b);
+	if (m_PairLookup.find(key) != m_PairLookup.end())
+		return;
+
+	SAPPair pair;
+	pair.proxyA = min(a, b);
+	pair.proxyB = max(a, b);
+
+	m_PairLookup[key] = m_Pairs.size();
+	m_Pairs.push_back(pair);
+}
+
+void SweepAndPrune::RemovePair(uint32_t a, uint32_t b)
+{
+	auto found_loc = m_PairLookup.find(PairKey(a, b));
+	if (found_loc == m_PairLookup.end())
+		return;
+
+	//Swap with the last pair and pop
+	size_t idx = found_loc->second;
+	m_PairLookup.erase(found_loc);
+
+	if (idx != m_Pairs.size() - 1)
+	{
+		m_Pairs[idx] = m_Pairs.back();
+		m_PairLookup[PairKey(m_Pairs[idx].proxyA, m_Pairs[idx].proxyB)] = idx;
+	}
+	m_Pairs.pop_back();
+}
@@ -0,0 +1,90 @@
+/******************************************************************************
+Class: SweepAndPrune
+Description: Incremental sweep-and-prune broadphase. Every physics object owns a
+proxy with a min/max endpoint on each of the three world axes, and the endpoint
+lists are kept sorted between physics steps. As objects only move a little from
+one step to the next, re-sorting with insertion sort is close to O(n), and every
+swap of a min past a max endpoint tells us that a pair has started or stopped
+overlapping. Overlapping pairs are kept in a persistent list so the broadphase
+output is O(n + pairs) instead of the O(n^2) brute force loop.
+******************************************************************************/
+#pragma once
+
+#include "BoundingBox.h"
+#include <vector>
+#include <unordered_map>
+#include <stdint.h>
+
+class PhysicsObject;
+struct CollisionPair;
+
+class SweepAndPrune
+{
+public:
+	SweepAndPrune();
+	~SweepAndPrune();
+
+	//Add/Remove objects from the broadphase - called by the PhysicsEngine
+	void AddObject(PhysicsObject* obj);
+	void RemoveObject(PhysicsObject* obj);
+	void Clear();
+
+	//Refreshes all proxy bounds, re-sorts the endpoint lists and appends all
+	// overlapping pairs (that both have collision shapes) to the given list.
+	void GenerateCPs(std::vector<CollisionPair>& cpList);
+
+	size_t GetNumProxies() const			{ return m_ProxyLookup.size(); }
+	size_t GetNumOverlappingPairs() const	{ return m_Pairs.size(); }
+
+protected:
+	struct SAPEndPoint
+	{
+		float		value;
+		uint32_t	data;		//(proxy index << 1) | is_max
+
+		inline uint32_t	Proxy() const	{ return data >> 1; }
+		inline bool		IsMax() const	{ return (data & 1) != 0; }
+	};
+
+	struct SAPProxy
+	{
+		PhysicsObject*	obj;
+		float			min[3];
+		float			max[3];
+	};
+
+	struct SAPPair
+	{
+		uint32_t proxyA;
+		uint32_t proxyB;
+	};
+
+	//Endpoints are ordered by value, with min endpoints before max endpoints
+	// at equal values so that touching boxes count as overlapping.
+	static inline bool EndPointLess(const SAPEndPoint& a, const SAPEndPoint& b)
+	{
+		return (a.value < b.value) || (a.value == b.value && !a.IsMax() && b.IsMax());
+	}
+
+	static inline uint64_t PairKey(uint32_t a, uint32_t b)
+	{
+		return (a < b) ? ((uint64_t(a) << 32) | b) : ((uint64_t(b) << 32) | a);
+	}
+
+	bool TestOverlap(uint32_t a, uint32_t b) const;
+	void AddPair(uint32_t a, uint32_t b);
+	void RemovePair(uint32_t a, uint32_t b);
+
+	void UpdateBounds();
+	void SortAxis(int axis);
+
+protected:
+	std::vector<SAPProxy>		m_Proxies;
+	std::vector<uint32_t>		m_FreeProxies;
+	std::vector<SAPEndPoint>	m_EndPoints[3];
+
+	std::unordered_map<PhysicsObject*, uint32_t>	m_ProxyLookup;
+
+	std::vector<SAPPair>					m_Pairs;
+	std::unordered_map<uint64_t, size_t>	m_PairLookup;		//Pair key -> index into m_Pairs
+};
@@ -0,0 +1,95 @@
+/******************************************************************************
+Class: VelocityDelta
+Description: Applies the impulses of a manifold/constraint to its two objects.
+
+Normally the impulse goes straight onto the objects' velocities (gauss-seidel),
+but while 'accumulate' is set the change in velocity is instead added up here.
+The jacobi solver uses this so that every manifold/constraint in an iteration
+sees the same velocities, and then applies all of the changes at once.
+******************************************************************************/
+#pragma once
+
+#include "PhysicsObject.h"
+#include "JacobianRow.h"
+#include <nclgl\Vector3.h>
+
+struct VelocityDelta
+{
+	bool	accumulate;
+	Vector3	linearA, angularA;
+	Vector3	linearB, angularB;
+
+	VelocityDelta() : accumulate(false) {}
+
+	void Clear()
+	{
+		linearA = angularA = linearB = angularB = Vector3(0.0f, 0.0f, 0.0f);
+	}
+
+	void Scale(float f)
+	{
+		linearA = linearA * f;
+		angularA = angularA * f;
+		linearB = linearB * f;
+		angularB = angularB * f;
+	}
+
+	//Applies 'impulse' at r1 on objA, and the opposite impulse at r2 on objB. Static
+	// objects are never written to, so that islands/batches resting on the same static
+	// object (e.g. the ground) can be solved on different threads.
+	void ApplyImpulse(PhysicsObject* objA, PhysicsObject* objB, const Vector3& impulse, const Vector3& r1, const Vector3& r2)
+	{
+		if (objA->GetInverseMass() > 0.0f)
+		{
+			AddToA(objA, impulse * objA->GetInverseMass(), objA->GetWorldInverseInertia() * Vector3::Cross(r1, impulse));
+		}
+
+		if (objB->GetInverseMass() > 0.0f)
+		{
+			AddToB(objB, impulse * objB->GetInverseMass(), objB->GetWorldInverseInertia() * Vector3::Cross(r2, impulse));
+		}
+	}
+
+	//Same as above, for an impulse of the given size along a precomputed jacobian row
+	void ApplyImpulse(PhysicsObject* objA, PhysicsObject* objB, const JacobianRow& row, float impulse)
+	{
+		if (row.invMassA > 0.0f)
+		{
+			AddToA(objA, row.linear * (impulse * row.invMassA), row.impulseAngularA * impulse);
+		}
+
+		if (row.invMassB > 0.0f)
+		{
+			AddToB(objB, row.linear * (impulse * row.invMassB), row.impulseAngularB * impulse);
+		}
+	}
+
+protected:
+	void AddToA(PhysicsObject* objA, const Vector3& lin, const Vector3& ang)
+	{
+		if (accumulate)
+		{
+			linearA = linearA + lin;
+			angularA = angularA + ang;
+		}
+		else
+		{
+			objA->SetLinearVelocity(objA->GetLinearVelocity() + lin);
+			objA->SetAngularVelocity(objA->GetAngularVelocity() + ang);
+		}
+	}
+
+	void AddToB(PhysicsObject* objB, const Vector3& lin, const Vector3& ang)
+	{
+		if (accumulate)
+		{
+			linearB = linearB - lin;
+			angularB = angularB - ang;
+		}
+		else
+		{
+			objB->SetLinearVelocity(objB->GetLinearVelocity() - lin);
+			objB->SetAngularVelocity(objB->GetAngularVelocity() - ang);
+		}
+	}
+};